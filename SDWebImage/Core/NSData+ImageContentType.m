@@ -14,8 +14,7 @@
 #import <MobileCoreServices/MobileCoreServices.h>
 #endif
 #import "SDImageIOAnimatedCoderInternal.h"
-
-#define kSVGTagEnd @"</svg>"
+#import "SDImageHeaderParser.h"
 
 @implementation NSData (ImageContentType)
 
@@ -23,68 +22,8 @@
     if (!data) {
         return SDImageFormatUndefined;
     }
-    
-    // File signatures table: http://www.garykessler.net/library/file_sigs.html
-    uint8_t c;
-    [data getBytes:&c length:1];
-    switch (c) {
-        case 0xFF:
-            return SDImageFormatJPEG;
-        case 0x89:
-            return SDImageFormatPNG;
-        case 0x47:
-            return SDImageFormatGIF;
-        case 0x49:
-        case 0x4D:
-            return SDImageFormatTIFF;
-        case 0x42:
-            return SDImageFormatBMP;
-        case 0x52: {
-            if (data.length >= 12) {
-                //RIFF....WEBP
-                NSString *testString = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(0, 12)] encoding:NSASCIIStringEncoding];
-                if ([testString hasPrefix:@"RIFF"] && [testString hasSuffix:@"WEBP"]) {
-                    return SDImageFormatWebP;
-                }
-            }
-            break;
-        }
-        case 0x00: {
-            if (data.length >= 12) {
-                //....ftypheic ....ftypheix ....ftyphevc ....ftyphevx
-                NSString *testString = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(4, 8)] encoding:NSASCIIStringEncoding];
-                if ([testString isEqualToString:@"ftypheic"]
-                    || [testString isEqualToString:@"ftypheix"]
-                    || [testString isEqualToString:@"ftyphevc"]
-                    || [testString isEqualToString:@"ftyphevx"]) {
-                    return SDImageFormatHEIC;
-                }
-                //....ftypmif1 ....ftypmsf1
-                if ([testString isEqualToString:@"ftypmif1"] || [testString isEqualToString:@"ftypmsf1"]) {
-                    return SDImageFormatHEIF;
-                }
-            }
-            break;
-        }
-        case 0x25: {
-            if (data.length >= 4) {
-                //%PDF
-                NSString *testString = [[NSString alloc] initWithData:[data subdataWithRange:NSMakeRange(1, 3)] encoding:NSASCIIStringEncoding];
-                if ([testString isEqualToString:@"PDF"]) {
-                    return SDImageFormatPDF;
-                }
-            }
-            break;
-        }
-        case 0x3C: {
-            // Check end with SVG tag
-            if ([data rangeOfData:[kSVGTagEnd dataUsingEncoding:NSUTF8StringEncoding] options:NSDataSearchBackwards range: NSMakeRange(data.length - MIN(100, data.length), MIN(100, data.length))].location != NSNotFound) {
-                return SDImageFormatSVG;
-            }
-            break;
-        }
-    }
-    return SDImageFormatUndefined;
+    // Compare the magic bytes in place, without creating strings or sub data
+    return SDImageHeaderGetFormat(data.bytes, data.length);
 }
 
 + (nonnull CFStringRef)sd_UTTypeFromImageFormat:(SDImageFormat)format {
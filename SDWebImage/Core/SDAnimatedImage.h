@@ -10,6 +10,11 @@
 #import "SDImageCoder.h"
 
 
+/// The progress block for preloading the animated image frames, called after each frame decoded
+typedef void(^SDAnimatedImagePreloadProgressBlock)(NSUInteger loadedFrameCount, NSUInteger totalFrameCount);
+/// The completion block for preloading the animated image frames, `finished` is NO if any frame failed to decode
+typedef void(^SDAnimatedImagePreloadCompletionBlock)(BOOL finished);
+
 /**
  This is the protocol for SDAnimatedImage class only but not for SDAnimatedImageCoder. If you want to provide a custom animated image class with full advanced function, you can conform to this instead of the base protocol.
  */
@@ -114,11 +119,21 @@ NS_SWIFT_NONISOLATED
 /**
  Pre-load all animated image frame into memory. Then later frame image request can directly return the frame for index without decoding.
  This method may be called on background thread.
+ The frames are decoded in parallel and this method blocks until all finished, see `preloadAllFramesWithProgress:completion:`.
  
  @note If one image instance is shared by lots of imageViews, the CPU performance for large animated image will drop down because the request frame index will be random (not in order) and the decoder should take extra effort to keep it re-entrant. You can use this to reduce CPU usage if need. Attention this will consume more memory usage.
  */
 - (void)preloadAllFrames;
 
+/**
+ Pre-load all animated image frame into memory asynchronously.
+ The frames are decoded in parallel on multiple cores. For ImageIO based coders (GIF/APNG/HEICS/WebP), each worker decodes a contiguous range of frames with its own `CGImageSource`. Other coders decode the frames one by one in the background. The in-flight decoding work is bounded by the budget of `SDImageDecodeScheduler`.
+ 
+ @param progressBlock The block called on main queue after each frame decoded
+ @param completionBlock The block called on main queue when preloading finished. `finished` is NO if any frame failed to decode, and the frames are not loaded in this case.
+ */
+- (void)preloadAllFramesWithProgress:(nullable SDAnimatedImagePreloadProgressBlock)progressBlock completion:(nullable SDAnimatedImagePreloadCompletionBlock)completionBlock;
+
 /**
  Unload all animated image frame from memory if are already pre-loaded. Then later frame image request need decoding. You can use this to free up the memory usage if need.
  */
@@ -127,6 +142,21 @@ NS_SWIFT_NONISOLATED
  Returns a Boolean value indicating whether all animated image frames are already pre-loaded into memory.
  */
 @property (nonatomic, assign, readonly, getter=isAllFramesLoaded) BOOL allFramesLoaded;
+
+// Between decoding just in time and preloading all frames, you can also choose to keep the decoded frames in a memory-mapped file.
+/**
+ The max bytes of the memory-mapped frame buffer. When non-zero, each frame decoded by `animatedImageFrameAtIndex:` is written once into a temporary file, and the later request for the same frame read it back from the file without decoding. The file pages are clean memory, so the system can page them out under memory pressure. This is useful for long animation which consume too much memory to preload, and too much CPU to decode each loop.
+ The frames exceeding this size are not stored, and still decoded each time. The file is removed when the image instance deallocates. Set to 0 to remove the file immediately.
+ Defaults to 0, which means disabled.
+ @note This does not take effect when all frames are pre-loaded.
+ @note The frames transformed by `SDAnimatedImageView.animationTransformer` are kept in another file for each transformer key, with the same size cap. This is the only way to keep the transformed frames across loops besides the in-memory frame buffer, they are transformed again after eviction when this is 0.
+ */
+@property (nonatomic, assign) NSUInteger maxMappedFrameBufferSize;
+/**
+ The bytes of the memory-mapped frame buffer used by the stored frames, see `maxMappedFrameBufferSize`.
+ */
+@property (nonatomic, assign, readonly) NSUInteger mappedFrameBufferSize;
+
 /**
  Return the animated image coder if the image is created with `initWithAnimatedCoder:scale:` method.
  @note We use this with animated coder which conforms to `SDProgressiveImageCoder` for progressive animation decoding.
@@ -16,7 +16,14 @@
 #import "UIImage+MultiFormat.h"
 #import "SDImageCoderHelper.h"
 #import "SDImageAssetManager.h"
+#import "SDImageIOAnimatedCoder.h"
+#import "SDImageIOAnimatedCoderInternal.h"
+#import "SDImageDecodeScheduler.h"
+#import "SDCallbackQueue.h"
+#import "SDImageMappedFrameBuffer.h"
+#import "SDImageFramePool.h"
 #import "objc/runtime.h"
+#import "SDInternalMacros.h"
 
 static CGFloat SDImageScaleFromPath(NSString *string) {
     if (string.length == 0 || [string hasSuffix:@"/"]) return 1;
@@ -31,11 +38,14 @@ static CGFloat SDImageScaleFromPath(NSString *string) {
     return scale;
 }
 
-@interface SDAnimatedImage ()
+@interface SDAnimatedImage () <SDImageFramePoolObserver>
 
 @property (nonatomic, strong) id<SDAnimatedImageCoder> animatedCoder;
 @property (atomic, copy) NSArray<SDImageFrame *> *loadedAnimatedImageFrames; // Mark as atomic to keep thread-safe
 @property (nonatomic, assign, getter=isAllFramesLoaded) BOOL allFramesLoaded;
+@property (atomic, strong) SDImageMappedFrameBuffer *mappedFrameBuffer;
+@property (nonatomic, strong) NSMapTable<id, NSNumber *> *framePoolBufferBytes; // the buffered bytes of each frame pool, the key is not retained. Protected by `@synchronized (self)`
+@property (nonatomic, assign) BOOL memoryCostNotificationScheduled; // Protected by `@synchronized (self)`
 
 @end
 
@@ -220,18 +230,133 @@ static CGFloat SDImageScaleFromPath(NSString *string) {
         return;
     }
     if (!self.isAllFramesLoaded) {
-        NSMutableArray<SDImageFrame *> *frames = [NSMutableArray arrayWithCapacity:self.animatedImageFrameCount];
-        for (size_t i = 0; i < self.animatedImageFrameCount; i++) {
-            UIImage *image = [self animatedImageFrameAtIndex:i];
-            NSTimeInterval duration = [self animatedImageDurationAtIndex:i];
-            SDImageFrame *frame = [SDImageFrame frameWithImage:image duration:duration]; // through the image should be nonnull, used as nullable for `animatedImageFrameAtIndex:`
-            [frames addObject:frame];
+        NSArray<SDImageFrame *> *frames = [self decodeAllFramesWithProgress:nil];
+        if (frames) {
+            self.loadedAnimatedImageFrames = frames;
+            self.allFramesLoaded = YES;
+            [self memoryCostDidChange];
         }
-        self.loadedAnimatedImageFrames = frames;
-        self.allFramesLoaded = YES;
     }
 }
 
+- (void)preloadAllFramesWithProgress:(SDAnimatedImagePreloadProgressBlock)progressBlock completion:(SDAnimatedImagePreloadCompletionBlock)completionBlock {
+    if (!_animatedCoder || self.isAllFramesLoaded) {
+        if (completionBlock) {
+            BOOL finished = self.isAllFramesLoaded;
+            [SDCallbackQueue.mainQueue async:^{
+                completionBlock(finished);
+            }];
+        }
+        return;
+    }
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        NSArray<SDImageFrame *> *frames = [self decodeAllFramesWithProgress:progressBlock];
+        if (frames && !self.isAllFramesLoaded) {
+            self.loadedAnimatedImageFrames = frames;
+            self.allFramesLoaded = YES;
+            [self memoryCostDidChange];
+        }
+        if (completionBlock) {
+            BOOL finished = frames != nil;
+            [SDCallbackQueue.mainQueue async:^{
+                completionBlock(finished);
+            }];
+        }
+    });
+}
+
+// Decode all frames in parallel, blocks until finished. Return nil if any frame failed to decode
+- (nullable NSArray<SDImageFrame *> *)decodeAllFramesWithProgress:(nullable SDAnimatedImagePreloadProgressBlock)progressBlock {
+    id<SDAnimatedImageCoder> animatedCoder = self.animatedCoder;
+    NSUInteger frameCount = animatedCoder.animatedImageFrameCount;
+    if (frameCount == 0) {
+        return nil;
+    }
+    // Only ImageIO coder can create the separate image source for each worker, other coders are not guaranteed to be re-entrant
+    SDImageIOAnimatedCoder *imageIOCoder = [animatedCoder isKindOfClass:SDImageIOAnimatedCoder.class] ? (SDImageIOAnimatedCoder *)animatedCoder : nil;
+    NSUInteger workerCount = 1;
+    if (imageIOCoder) {
+        workerCount = MIN(frameCount, [NSProcessInfo processInfo].activeProcessorCount);
+        NSUInteger maxConcurrentDecodes = SDImageDecodeScheduler.sharedScheduler.maxConcurrentDecodes;
+        if (maxConcurrentDecodes > 0) {
+            workerCount = MIN(workerCount, maxConcurrentDecodes);
+        }
+        workerCount = MAX(workerCount, 1);
+    }
+    // Each frame has the same canvas size as the poster image
+    CGImageRef posterImageRef = self.CGImage;
+    NSUInteger cost = posterImageRef ? CGImageGetBytesPerRow(posterImageRef) * CGImageGetHeight(posterImageRef) : 0;
+    
+    NSMutableArray *images = [NSMutableArray arrayWithCapacity:frameCount];
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        [images addObject:[NSNull null]];
+    }
+    __block NSUInteger loadedFrameCount = 0;
+    __block BOOL failed = NO;
+    // The caller may already hold a decode slot (such as `SDWebImagePreloadAllFrames` during image decoding), the workers run on behalf of it and do not wait for another slot, else all slots held by such callers deadlock
+    BOOL callerPerforming = [SDImageDecodeScheduler isCurrentThreadPerforming];
+    
+    dispatch_apply(workerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker) {
+        // Contiguous range keeps the decoder of each image source sequential, which avoids re-decoding the dependent frames
+        NSUInteger start = frameCount * worker / workerCount;
+        NSUInteger end = frameCount * (worker + 1) / workerCount;
+        CGImageSourceRef imageSource = [imageIOCoder createParallelImageSource];
+        for (NSUInteger i = start; i < end; i++) {
+            BOOL shouldStop;
+            @synchronized (images) {
+                shouldStop = failed;
+            }
+            if (shouldStop) {
+                break;
+            }
+            __block UIImage *image;
+            dispatch_block_t decodeBlock = ^{
+                @autoreleasepool {
+                    if (imageSource) {
+                        image = [imageIOCoder animatedImageFrameAtIndex:i imageSource:imageSource];
+                    } else {
+                        image = [animatedCoder animatedImageFrameAtIndex:i];
+                    }
+                }
+            };
+            if (callerPerforming) {
+                decodeBlock();
+            } else {
+                [SDImageDecodeScheduler.sharedScheduler performWithCost:cost priority:SDImageDecodePriorityNormal block:decodeBlock];
+            }
+            NSUInteger currentCount;
+            @synchronized (images) {
+                if (image) {
+                    images[i] = image;
+                    loadedFrameCount++;
+                } else {
+                    failed = YES;
+                }
+                currentCount = loadedFrameCount;
+            }
+            if (image && progressBlock) {
+                [SDCallbackQueue.mainQueue async:^{
+                    progressBlock(currentCount, frameCount);
+                }];
+            }
+        }
+        if (imageSource) {
+            CFRelease(imageSource);
+        }
+    });
+    
+    if (failed) {
+        return nil;
+    }
+    NSMutableArray<SDImageFrame *> *frames = [NSMutableArray arrayWithCapacity:frameCount];
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        NSTimeInterval duration = [animatedCoder animatedImageDurationAtIndex:i];
+        SDImageFrame *frame = [SDImageFrame frameWithImage:images[i] duration:duration];
+        [frames addObject:frame];
+    }
+    return [frames copy];
+}
+
 - (void)unloadAllFrames {
     if (!_animatedCoder) {
         return;
@@ -239,9 +364,80 @@ static CGFloat SDImageScaleFromPath(NSString *string) {
     if (self.isAllFramesLoaded) {
         self.loadedAnimatedImageFrames = nil;
         self.allFramesLoaded = NO;
+        [self memoryCostDidChange];
     }
 }
 
+#pragma mark - Mapped Frame Buffer
+- (NSUInteger)maxMappedFrameBufferSize {
+    return self.mappedFrameBuffer.limitBytes;
+}
+
+- (void)setMaxMappedFrameBufferSize:(NSUInteger)maxMappedFrameBufferSize {
+    if (maxMappedFrameBufferSize == 0) {
+        // Remove the file
+        self.mappedFrameBuffer = nil;
+        return;
+    }
+    SDImageMappedFrameBuffer *mappedFrameBuffer = self.mappedFrameBuffer;
+    if (mappedFrameBuffer) {
+        mappedFrameBuffer.limitBytes = maxMappedFrameBufferSize;
+    } else {
+        self.mappedFrameBuffer = [[SDImageMappedFrameBuffer alloc] initWithLimitBytes:maxMappedFrameBufferSize];
+    }
+}
+
+- (NSUInteger)mappedFrameBufferSize {
+    return self.mappedFrameBuffer.usedBytes;
+}
+
+#pragma mark - Memory Cost
+- (void)framePool:(SDImageFramePool *)framePool didUpdateBufferBytes:(NSUInteger)bufferBytes {
+    @synchronized (self) {
+        if (!self.framePoolBufferBytes) {
+            self.framePoolBufferBytes = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality valueOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPersonality];
+        }
+        if (bufferBytes > 0) {
+            [self.framePoolBufferBytes setObject:@(bufferBytes) forKey:framePool];
+        } else {
+            [self.framePoolBufferBytes removeObjectForKey:framePool];
+        }
+    }
+    [self memoryCostDidChange];
+}
+
+// The total buffered bytes of all frame pools which play this image
+- (NSUInteger)totalFramePoolBufferBytes {
+    NSUInteger bytes = 0;
+    @synchronized (self) {
+        for (NSNumber *value in self.framePoolBufferBytes.objectEnumerator) {
+            bytes += value.unsignedIntegerValue;
+        }
+    }
+    return bytes;
+}
+
+// Notify the memory cache to update the cost. The frame pools report on each frame buffered and evicted, so coalesce the changes into one notification on the next main queue turn, which also keep the posting out of the caller's lock
+- (void)memoryCostDidChange {
+    @synchronized (self) {
+        if (self.memoryCostNotificationScheduled) {
+            return;
+        }
+        self.memoryCostNotificationScheduled = YES;
+    }
+    @weakify(self);
+    dispatch_async(dispatch_get_main_queue(), ^{
+        @strongify(self);
+        if (!self) {
+            return;
+        }
+        @synchronized (self) {
+            self.memoryCostNotificationScheduled = NO;
+        }
+        [[NSNotificationCenter defaultCenter] postNotificationName:SDImageMemoryCostDidChangeNotification object:self];
+    });
+}
+
 #pragma mark - NSSecureCoding
 - (instancetype)initWithCoder:(NSCoder *)aDecoder {
     self = [super initWithCoder:aDecoder];
@@ -304,7 +500,22 @@ static CGFloat SDImageScaleFromPath(NSString *string) {
         SDImageFrame *frame = [self.loadedAnimatedImageFrames objectAtIndex:index];
         return frame.image;
     }
-    return [self.animatedCoder animatedImageFrameAtIndex:index];
+    SDImageMappedFrameBuffer *mappedFrameBuffer = self.mappedFrameBuffer;
+    if (mappedFrameBuffer) {
+        UIImage *image = [mappedFrameBuffer frameAtIndex:index];
+        if (image) {
+            return image;
+        }
+    }
+    UIImage *image = [self.animatedCoder animatedImageFrameAtIndex:index];
+    if (image && mappedFrameBuffer) {
+        // Return the one backed by file, so the decoded bitmap can be freed
+        UIImage *mappedImage = [mappedFrameBuffer storeFrame:image atIndex:index];
+        if (mappedImage) {
+            return mappedImage;
+        }
+    }
+    return image;
 }
 
 - (NSTimeInterval)animatedImageDurationAtIndex:(NSUInteger)index {
@@ -332,13 +543,19 @@ static CGFloat SDImageScaleFromPath(NSString *string) {
     if (!imageRef) {
         return 0;
     }
-    NSUInteger bytesPerFrame = CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
-    NSUInteger frameCount = 1;
+    // The poster frame
+    NSUInteger cost = CGImageGetBytesPerRow(imageRef) * CGImageGetHeight(imageRef);
+    // The pre-loaded frames
     if (self.isAllFramesLoaded) {
-        frameCount = self.animatedImageFrameCount;
+        for (SDImageFrame *frame in self.loadedAnimatedImageFrames) {
+            CGImageRef frameImageRef = frame.image.CGImage;
+            if (frameImageRef) {
+                cost += CGImageGetBytesPerRow(frameImageRef) * CGImageGetHeight(frameImageRef);
+            }
+        }
     }
-    frameCount = frameCount > 0 ? frameCount : 1;
-    NSUInteger cost = bytesPerFrame * frameCount;
+    // The frames buffered by players, the mapped frame buffer is not counted because it's backed by file and can be paged out
+    cost += [self totalFramePoolBufferBytes];
     return cost;
 }
 
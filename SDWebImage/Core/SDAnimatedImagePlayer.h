@@ -61,11 +61,46 @@ typedef NS_ENUM(NSUInteger, SDAnimatedImagePlaybackMode) {
 @property (nonatomic, assign) SDAnimatedImagePlaybackMode playbackMode;
 
 /// Provide a max buffer size by bytes. This is used to adjust frame buffer count and can be useful when the decoding cost is expensive (such as Animated WebP software decoding). Default is 0.
-/// `0` means automatically adjust by calculating current memory usage.
+/// `0` means automatically adjust by the share of global budget, see `maxTotalBufferSize`.
 /// `1` means without any buffer cache, each of frames will be decoded and then be freed after rendering. (Lowest Memory and Highest CPU)
 /// `NSUIntegerMax` means cache all the buffer. (Lowest CPU and Highest Memory)
 @property (nonatomic, assign) NSUInteger maxBufferSize;
 
+/// The max total buffer size by bytes, shared by all players which use the automatic `maxBufferSize` and hold buffered frames. The budget is split across players by visibility, frame size and frame rate, and rebalanced when players start, pause and clear the frame buffer. Default is 0.
+/// `0` means automatically calculated by current memory usage.
+@property (nonatomic, class, assign) NSUInteger maxTotalBufferSize;
+
+/// Whether the rendering target is visible. The invisible players, and the paused or stopped players which keep the frame buffer, get a smaller share of `maxTotalBufferSize`. Call `clearFrameBuffer` to give back the share. Default is YES.
+@property (nonatomic, assign, getter=isVisible) BOOL visible;
+
+/// Whether to store the buffered frames as the changed region against a keyframe, instead of the full frames. Default is NO.
+/// This can reduce the buffer memory several times for the animation which only changes a small region each frame (such as a spinner or a blinking cursor), and cost more CPU to compare and compose the frames (not on main thread). The frames which change more than half of the canvas, or which are not 8-bit sRGB (such as wide color or HDR), are still stored as full frames.
+/// @note The frame buffer is shared by the players of the same provider, so this applies to all of them.
+@property (nonatomic, assign) BOOL storesDeltaFrames;
+
+/// The max number of upcoming frames to decode ahead of the current frame. Default is 0.
+/// `0` means automatically adjust by the measured decode time per frame, prefetch more frames in parallel when decoding one frame takes longer than displaying it.
+/// `1` means only prefetch the next frame.
+/// @note The prefetched frames are still limited by the frame buffer, see `maxBufferSize`.
+@property (nonatomic, assign) NSUInteger maxPrefetchFrameCount;
+
+/// The max number of frames decoding concurrently. Default is 0.
+/// `0` means automatically adjust by the measured decode time per frame, up to the active processor count.
+@property (nonatomic, assign) NSUInteger maxConcurrentPrefetchCount;
+
+/// Whether to keep the wall-clock timing of animation. Default is NO.
+/// If NO, when decoding falls behind, the player stalls on the current frame until the next frame is decoded, so the animation plays slower.
+/// If YES, the time keeps running and the player skips to the frame matching the elapsed time. The skipped frames are not decoded.
+@property (nonatomic, assign) BOOL realTimePlayback;
+
+/// The max number of frames displayed per second, used to save CPU for small or offscreen rendering. Default is 0.
+/// `0` means no limit, each frame is displayed.
+/// When the animation frame rate is higher than this value, the frames are skipped to keep the wall-clock timing (see `realTimePlayback`), and the skipped frames are not decoded.
+@property (nonatomic, assign) double maxFrameRate;
+
+/// The number of frames skipped by `realTimePlayback` or `maxFrameRate` since the player created.
+@property (nonatomic, readonly) NSUInteger skippedFrameCount;
+
 /// You can specify a runloop mode to let it rendering.
 /// Default is NSRunLoopCommonModes on multi-core device, NSDefaultRunLoopMode on single-core device
 @property (nonatomic, copy, nonnull) NSRunLoopMode runLoopMode;
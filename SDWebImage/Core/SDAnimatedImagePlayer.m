@@ -9,7 +9,6 @@
 #import "SDAnimatedImagePlayer.h"
 #import "NSImage+Compatibility.h"
 #import "SDDisplayLink.h"
-#import "SDDeviceHelper.h"
 #import "SDImageFramePool.h"
 #import "SDInternalMacros.h"
 
@@ -29,6 +28,10 @@
 @property (nonatomic, assign) BOOL needsDisplayWhenImageBecomesAvailable;
 @property (nonatomic, assign) BOOL shouldReverse;
 @property (nonatomic, strong) SDDisplayLink *displayLink;
+@property (nonatomic, assign) BOOL bufferBudgetActive;
+@property (nonatomic, assign) NSTimeInterval averageFrameDuration;
+@property (nonatomic, assign, readwrite) NSUInteger skippedFrameCount;
+@property (nonatomic, assign) NSTimeInterval timeSinceFrameChange;
 
 @end
 
@@ -47,6 +50,7 @@
         self.totalLoopCount = provider.animatedImageLoopCount;
         self.animatedProvider = provider;
         self.playbackRate = 1.0;
+        self.visible = YES;
         self.framePool = [SDImageFramePool registerProvider:provider];
     }
     return self;
@@ -58,6 +62,8 @@
 }
 
 - (void)dealloc {
+    // Give back the buffer budget
+    [_framePool deactivatePlayer:self];
     // Dereference the frame pool, when zero the frame pool for provider will dealloc
     [SDImageFramePool unregisterProvider:self.animatedProvider];
 }
@@ -66,7 +72,8 @@
 
 - (SDDisplayLink *)displayLink {
     if (!_displayLink) {
-        _displayLink = [SDDisplayLink displayLinkWithTarget:self selector:@selector(displayDidRefresh:)];
+        // All players share one underlying display link
+        _displayLink = [SDDisplayLink sharedDisplayLinkWithTarget:self selector:@selector(displayDidRefresh:)];
         [_displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:self.runLoopMode];
         [_displayLink stop];
     }
@@ -137,11 +144,14 @@
 
 - (void)clearFrameBuffer {
     [self.framePool removeAllFrames];
+    // No buffered frames to keep, give back the budget
+    [self deactivateBufferBudget];
 }
 
 #pragma mark - Animation Control
 - (void)startPlaying {
     [self.displayLink start];
+    [self updateBufferBudget];
     // Setup frame
     [self setupCurrentFrame];
 }
@@ -149,12 +159,15 @@
 - (void)stopPlaying {
     // Using `_displayLink` here because when UIImageView dealloc, it may trigger `[self stopAnimating]`, we already release the display link in SDAnimatedImageView's dealloc method.
     [_displayLink stop];
+    // The buffered frames are kept, which use the reduced share
+    [self updateBufferBudget];
     // We need to reset the frame status, but not trigger any handle. This can ensure next time's playing status correct.
     [self resetCurrentFrameStatus];
 }
 
 - (void)pausePlaying {
     [_displayLink stop];
+    [self updateBufferBudget];
 }
 
 - (BOOL)isPlaying {
@@ -197,22 +210,11 @@
     NSTimeInterval duration = self.displayLink.duration;
     
     NSUInteger currentFrameIndex = self.currentFrameIndex;
-    NSUInteger nextFrameIndex = (currentFrameIndex + 1) % totalFrameCount;
-    
-    if (self.playbackMode == SDAnimatedImagePlaybackModeReverse) {
-        nextFrameIndex = currentFrameIndex == 0 ? (totalFrameCount - 1) : (currentFrameIndex - 1) % totalFrameCount;
-        
-    } else if (self.playbackMode == SDAnimatedImagePlaybackModeBounce ||
-               self.playbackMode == SDAnimatedImagePlaybackModeReversedBounce) {
-        if (currentFrameIndex == 0) {
-            self.shouldReverse = NO;
-        } else if (currentFrameIndex == totalFrameCount - 1) {
-            self.shouldReverse = YES;
-        }
-        nextFrameIndex = self.shouldReverse ? (currentFrameIndex - 1) : (currentFrameIndex + 1);
-        nextFrameIndex %= totalFrameCount;
-    }
+    NSUInteger nextFrameIndex = [self nextFrameIndexOfIndex:currentFrameIndex];
     
+    // Skip frames to keep the timing, or limit the frame rate
+    BOOL skipFrames = self.realTimePlayback || self.maxFrameRate > 0;
+    NSTimeInterval minFrameInterval = self.maxFrameRate > 0 ? 1 / self.maxFrameRate : 0;
     
     // Check if we need to display new frame firstly
     if (self.needsDisplayWhenImageBecomesAvailable) {
@@ -220,54 +222,87 @@
         
         // Update the current frame
         if (currentFrame) {
+            if (!self.bufferMiss) {
+                [self.framePool recordBufferHit:YES];
+            }
             // Update the current frame immediately
             self.currentFrame = currentFrame;
+            self.timeSinceFrameChange = 0;
             [self handleFrameChange];
             
             self.bufferMiss = NO;
             self.needsDisplayWhenImageBecomesAvailable = NO;
         }
         else {
+            if (!self.bufferMiss) {
+                [self.framePool recordBufferHit:NO];
+            }
             self.bufferMiss = YES;
         }
     }
     
-    // Check if we have the frame buffer
-    if (!self.bufferMiss) {
+    // Check if we have the frame buffer, when skipping frames the time keeps running even buffer miss
+    if (!self.bufferMiss || skipFrames) {
         // Then check if timestamp is reached
         self.currentTime += duration;
+        self.timeSinceFrameChange += duration;
         NSTimeInterval currentDuration = [self.animatedProvider animatedImageDurationAtIndex:currentFrameIndex];
         currentDuration = currentDuration / playbackRate;
-        if (self.currentTime < currentDuration) {
-            // Current frame timestamp not reached, prefetch frame in advance.
+        if (self.currentTime < currentDuration || self.timeSinceFrameChange < minFrameInterval) {
+            NSTimeInterval delay = MAX(currentDuration - self.currentTime, minFrameInterval - self.timeSinceFrameChange);
+            // Current frame timestamp not reached, prefetch frame in advance. When limit the frame rate, prefetch the frame which will be displayed after skipping
+            NSUInteger prefetchFrameIndex = minFrameInterval > 0 ? [self predictedFrameIndexAfterDelay:delay currentDuration:currentDuration] : nextFrameIndex;
             [self prefetchFrameAtIndex:currentFrameIndex
-                             nextIndex:nextFrameIndex];
+                             nextIndex:prefetchFrameIndex];
+            if (!self.bufferMiss) {
+                // Nothing changes until the timestamp reached
+                [self.displayLink scheduleNextCallbackAfter:delay];
+            }
             return;
         }
         
         // Otherwise, we should be ready to display next frame
         self.needsDisplayWhenImageBecomesAvailable = YES;
-        self.currentFrameIndex = nextFrameIndex;
-        self.currentTime -= currentDuration;
-        NSTimeInterval nextDuration = [self.animatedProvider animatedImageDurationAtIndex:nextFrameIndex];
-        nextDuration = nextDuration / playbackRate;
-        if (self.currentTime > nextDuration) {
-            // Do not skip frame
-            self.currentTime = nextDuration;
-        }
-        
-        // Update the loop count when last frame rendered
-        if (nextFrameIndex == 0) {
-            // Update the loop count
-            self.currentLoopCount++;
-            [self handleLoopChange];
+        NSUInteger skipCount = 0;
+        while (YES) {
+            currentFrameIndex = self.currentFrameIndex;
+            self.currentFrameIndex = nextFrameIndex;
+            self.currentTime -= currentDuration;
             
-            // if reached the max loop count, stop animating, 0 means loop indefinitely
-            NSUInteger maxLoopCount = self.totalLoopCount;
-            if (maxLoopCount != 0 && (self.currentLoopCount >= maxLoopCount)) {
-                [self stopPlaying];
-                return;
+            // Update the loop count when last frame rendered
+            if (nextFrameIndex == 0) {
+                // Update the loop count
+                self.currentLoopCount++;
+                [self handleLoopChange];
+                
+                // if reached the max loop count, stop animating, 0 means loop indefinitely
+                NSUInteger maxLoopCount = self.totalLoopCount;
+                if (maxLoopCount != 0 && (self.currentLoopCount >= maxLoopCount)) {
+                    [self stopPlaying];
+                    return;
+                }
             }
+            
+            currentDuration = [self.animatedProvider animatedImageDurationAtIndex:nextFrameIndex];
+            currentDuration = currentDuration / playbackRate;
+            // At most skip one loop each refresh
+            if (!skipFrames || self.currentTime < currentDuration || skipCount >= totalFrameCount) {
+                break;
+            }
+            // Skip the frame to keep the wall-clock timing
+            skipCount++;
+            self.skippedFrameCount++;
+            nextFrameIndex = [self nextFrameIndexOfIndex:nextFrameIndex];
+        }
+        if (self.currentTime > currentDuration) {
+            // Do not skip frame
+            self.currentTime = currentDuration;
+        }
+        nextFrameIndex = self.currentFrameIndex;
+        if (skipFrames && self.bufferMiss) {
+            // The missing frame is skipped, check the new one
+            self.skippedFrameCount++;
+            self.bufferMiss = NO;
         }
     }
     
@@ -280,27 +315,85 @@
                      nextIndex:nextFrameIndex];
 }
 
+// The next frame index by playback mode, also update the direction for bounce mode
+- (NSUInteger)nextFrameIndexOfIndex:(NSUInteger)index {
+    NSUInteger totalFrameCount = self.totalFrameCount;
+    NSUInteger nextFrameIndex = (index + 1) % totalFrameCount;
+    
+    if (self.playbackMode == SDAnimatedImagePlaybackModeReverse) {
+        nextFrameIndex = index == 0 ? (totalFrameCount - 1) : (index - 1) % totalFrameCount;
+        
+    } else if (self.playbackMode == SDAnimatedImagePlaybackModeBounce ||
+               self.playbackMode == SDAnimatedImagePlaybackModeReversedBounce) {
+        if (index == 0) {
+            self.shouldReverse = NO;
+        } else if (index == totalFrameCount - 1) {
+            self.shouldReverse = YES;
+        }
+        nextFrameIndex = self.shouldReverse ? (index - 1) : (index + 1);
+        nextFrameIndex %= totalFrameCount;
+    }
+    return nextFrameIndex;
+}
+
+// The frame index which will be displayed after the delay, by skipping frames
+- (NSUInteger)predictedFrameIndexAfterDelay:(NSTimeInterval)delay currentDuration:(NSTimeInterval)currentDuration {
+    NSUInteger currentFrameIndex = self.currentFrameIndex;
+    NSUInteger totalFrameCount = self.totalFrameCount;
+    BOOL reverse = self.playbackMode == SDAnimatedImagePlaybackModeReverse || (self.playbackMode != SDAnimatedImagePlaybackModeNormal && self.shouldReverse);
+    // The end time of current frame, relative to now
+    NSTimeInterval time = currentDuration - self.currentTime;
+    NSUInteger step = 1;
+    NSUInteger index = [self frameIndexAfterSteps:step fromIndex:currentFrameIndex reverse:reverse];
+    while (step < totalFrameCount) {
+        time += [self.animatedProvider animatedImageDurationAtIndex:index] / self.playbackRate;
+        if (time > delay) {
+            break;
+        }
+        step++;
+        index = [self frameIndexAfterSteps:step fromIndex:currentFrameIndex reverse:reverse];
+    }
+    return index;
+}
+
 // Check if we should prefetch next frame or current frame
 // When buffer miss, means the decode speed is slower than render speed, we fetch current miss frame
 // Or, most cases, the decode speed is faster than render speed, we fetch next frame
 - (void)prefetchFrameAtIndex:(NSUInteger)currentIndex
                    nextIndex:(NSUInteger)nextIndex {
     NSUInteger fetchFrameIndex = currentIndex;
-    UIImage *fetchFrame = nil;
+    BOOL fetchFrameBuffered = NO;
     if (!self.bufferMiss) {
         fetchFrameIndex = nextIndex;
-        fetchFrame = [self.framePool frameAtIndex:nextIndex];
+        // Only check, avoid composing the delta frame
+        fetchFrameBuffered = [self.framePool containsFrameAtIndex:nextIndex];
+        if (fetchFrameBuffered) {
+            // Compose the next delta frame in background, instead of on main thread during display
+            [self.framePool prepareFrameAtIndex:nextIndex];
+        }
     }
     BOOL bufferFull = NO;
     if (self.framePool.currentFrameCount == self.totalFrameCount) {
         bufferFull = YES;
     }
-    if (!fetchFrame && !bufferFull) {
+    if (bufferFull) {
+        return;
+    }
+    // Evict the frames by playback order
+    BOOL reverse = self.playbackMode == SDAnimatedImagePlaybackModeReverse || (self.playbackMode != SDAnimatedImagePlaybackModeNormal && self.shouldReverse);
+    [self.framePool updatePlayheadWithFrameIndex:currentIndex playbackMode:self.playbackMode reverse:reverse];
+    if (!fetchFrameBuffered) {
         // Calculate max buffer size
         [self calculateMaxBufferCountWithFrame:self.currentFrame];
-        // Prefetch next frame
+        // Prefetch the next frame, or the missing current frame
         [self.framePool prefetchFrameAtIndex:fetchFrameIndex];
     }
+    // Keep a window of upcoming frames decoded ahead, the frame pool ignores the ones already in buffer or being prefetched
+    NSUInteger prefetchFrameCount = [self calculatePrefetchFrameCountWithNextIndex:nextIndex];
+    for (NSUInteger step = 2; step <= prefetchFrameCount; step++) {
+        NSUInteger index = [self frameIndexAfterSteps:step fromIndex:currentIndex reverse:reverse];
+        [self.framePool prefetchFrameAtIndex:index];
+    }
 }
 
 - (void)handleFrameChange {
@@ -331,11 +424,13 @@
     NSUInteger max = 0;
     if (self.maxBufferSize > 0) {
         max = self.maxBufferSize;
+        [self deactivateBufferBudget];
     } else {
-        // Calculate based on current memory, these factors are by experience
-        NSUInteger total = [SDDeviceHelper totalMemory];
-        NSUInteger free = [SDDeviceHelper freeMemory];
-        max = MIN(total * 0.2, free * 0.6);
+        // Use the share of global budget
+        if (!self.bufferBudgetActive) {
+            [self activateBufferBudgetWithFrameBytes:bytes];
+        }
+        max = self.framePool.budgetBytes;
     }
     
     NSUInteger maxBufferCount = (double)max / (double)bytes;
@@ -347,6 +442,131 @@
     self.framePool.maxBufferCount = maxBufferCount;
 }
 
+// Calculate the lookahead depth, and update the concurrency of frame pool
+- (NSUInteger)calculatePrefetchFrameCountWithNextIndex:(NSUInteger)nextIndex {
+    // The frames needed to cover the decode time, 1 if decoding is faster than display
+    NSUInteger requiredCount = 1;
+    NSTimeInterval decodeDuration = self.framePool.averageDecodeDuration;
+    NSTimeInterval frameDuration = [self.animatedProvider animatedImageDurationAtIndex:nextIndex] / self.playbackRate;
+    // The frame can not be displayed faster than the display refresh
+    frameDuration = MAX(frameDuration, self.displayLink.refreshDuration);
+    if (decodeDuration > 0 && frameDuration > 0) {
+        requiredCount = MAX(ceil(decodeDuration / frameDuration), 1);
+    }
+    
+    NSUInteger prefetchFrameCount = self.maxPrefetchFrameCount > 0 ? self.maxPrefetchFrameCount : requiredCount;
+    if (self.maxFrameRate > 0) {
+        // The upcoming frames may be skipped, only prefetch the predicted one
+        prefetchFrameCount = 1;
+    }
+    // Keep the current frame in buffer as well
+    NSUInteger maxBufferCount = self.framePool.maxBufferCount;
+    if (maxBufferCount > 0) {
+        prefetchFrameCount = MIN(prefetchFrameCount, MAX(maxBufferCount - 1, 1));
+    }
+    prefetchFrameCount = MIN(prefetchFrameCount, self.totalFrameCount - 1);
+    prefetchFrameCount = MAX(prefetchFrameCount, 1);
+    
+    NSUInteger maxConcurrentCount = self.maxConcurrentPrefetchCount > 0 ? self.maxConcurrentPrefetchCount : [NSProcessInfo processInfo].activeProcessorCount;
+    NSUInteger concurrentCount = MIN(MIN(requiredCount, prefetchFrameCount), maxConcurrentCount);
+    concurrentCount = MAX(concurrentCount, 1);
+    if (self.framePool.maxConcurrentCount != concurrentCount) {
+        self.framePool.maxConcurrentCount = concurrentCount;
+    }
+    return prefetchFrameCount;
+}
+
+// The frame index after steps by playback order
+- (NSUInteger)frameIndexAfterSteps:(NSUInteger)steps fromIndex:(NSUInteger)index reverse:(BOOL)reverse {
+    NSUInteger totalFrameCount = self.totalFrameCount;
+    if (totalFrameCount <= 1) {
+        return 0;
+    }
+    switch (self.playbackMode) {
+        case SDAnimatedImagePlaybackModeReverse:
+            return (index + totalFrameCount - steps % totalFrameCount) % totalFrameCount;
+        case SDAnimatedImagePlaybackModeBounce:
+        case SDAnimatedImagePlaybackModeReversedBounce: {
+            // Bounce is a cycle of `2 * (totalFrameCount - 1)` steps
+            NSUInteger period = 2 * (totalFrameCount - 1);
+            NSUInteger phase = reverse ? (period - index) % period : index;
+            phase = (phase + steps) % period;
+            return phase < totalFrameCount ? phase : period - phase;
+        }
+        case SDAnimatedImagePlaybackModeNormal:
+        default:
+            return (index + steps) % totalFrameCount;
+    }
+}
+
+#pragma mark - Buffer Budget
++ (NSUInteger)maxTotalBufferSize {
+    return SDImageFramePool.maxTotalBufferBytes;
+}
+
++ (void)setMaxTotalBufferSize:(NSUInteger)maxTotalBufferSize {
+    SDImageFramePool.maxTotalBufferBytes = maxTotalBufferSize;
+}
+
+- (void)setVisible:(BOOL)visible {
+    if (_visible == visible) {
+        return;
+    }
+    _visible = visible;
+    [self updateBufferBudget];
+}
+
+- (BOOL)storesDeltaFrames {
+    return self.framePool.storesDeltaFrames;
+}
+
+- (void)setStoresDeltaFrames:(BOOL)storesDeltaFrames {
+    self.framePool.storesDeltaFrames = storesDeltaFrames;
+}
+
+- (void)setPlaybackRate:(double)playbackRate {
+    _playbackRate = playbackRate;
+    // The scheduled callback is calculated by previous rate
+    [_displayLink scheduleNextCallbackAfter:0];
+    [self updateBufferBudget];
+}
+
+- (void)activateBufferBudgetWithFrameBytes:(NSUInteger)frameBytes {
+    if (self.averageFrameDuration <= 0) {
+        NSUInteger totalFrameCount = self.totalFrameCount;
+        NSTimeInterval totalDuration = 0;
+        for (NSUInteger i = 0; i < totalFrameCount; i++) {
+            totalDuration += [self.animatedProvider animatedImageDurationAtIndex:i];
+        }
+        self.averageFrameDuration = totalFrameCount > 0 ? totalDuration / totalFrameCount : 0;
+    }
+    double frameRate = self.averageFrameDuration > 0 ? self.playbackRate / self.averageFrameDuration : 0;
+    // The frame can not be displayed faster than the display refresh
+    NSTimeInterval refreshDuration = _displayLink.refreshDuration;
+    if (refreshDuration > 0) {
+        frameRate = MIN(frameRate, 1 / refreshDuration);
+    }
+    self.bufferBudgetActive = YES;
+    // The paused player keeps its buffered frames registered, with the reduced share of invisible player
+    BOOL visible = self.isVisible && self.isPlaying;
+    [self.framePool activatePlayer:self frameBytes:frameBytes frameRate:frameRate visible:visible];
+}
+
+// Update the share if the budget is active, when the visibility, playing status, or frame rate is changed
+- (void)updateBufferBudget {
+    if (self.bufferBudgetActive) {
+        [self activateBufferBudgetWithFrameBytes:self.currentFrameBytes];
+    }
+}
+
+- (void)deactivateBufferBudget {
+    if (!self.bufferBudgetActive) {
+        return;
+    }
+    self.bufferBudgetActive = NO;
+    [self.framePool deactivatePlayer:self];
+}
+
 + (NSString *)defaultRunLoopMode {
     // Key off `activeProcessorCount` (as opposed to `processorCount`) since the system could shut down cores in certain situations.
     return [NSProcessInfo processInfo].activeProcessorCount > 1 ? NSRunLoopCommonModes : NSDefaultRunLoopMode;
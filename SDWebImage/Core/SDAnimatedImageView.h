@@ -39,6 +39,9 @@ NS_SWIFT_UI_ACTOR
  imageView.animationTransformer = [SDImageTintTransformer transformerWithColor:UIColor.blackColor];
  * @endcode
  @note The `transformerKey` property is used to ensure the buffer cache available. So make sure it's correct value match the actual logic on transformer. Which means, for the `same frame index + same transformer key`, the transformed image should always be the same.
+ @note The transformed frames share the in-memory frame buffer among the image views with the same image and transformer key. The frames evicted from that buffer are decoded and transformed again by default.
+ @warning Keeping the transformed frames after eviction is opt-in: only when the image is `SDAnimatedImage` and its `maxMappedFrameBufferSize` is set to non-zero (defaults to 0), the transformed frames are also kept in a separate memory-mapped file (with the same size cap) for each transformer key, so later loops don't decode and transform again.
+ @note To transform only once at load time and keep the result in disk cache, see `SDWebImageTransformAnimatedImageFrames`.
  */
 @property (nonatomic, strong, nullable) id<SDImageTransformer> animationTransformer;
 
@@ -85,6 +88,34 @@ NS_SWIFT_UI_ACTOR
  `NSUIntegerMax` means cache all the buffer. (Lowest CPU and Highest Memory)
  */
 @property (nonatomic, assign) NSUInteger maxBufferSize;
+/**
+ Whether to store the buffered frames as the changed region against a keyframe, instead of the full frames. Default is NO.
+ This can reduce the buffer memory several times for the animation which only changes a small region each frame, and cost more CPU to compare and compose the frames. See `SDAnimatedImagePlayer.storesDeltaFrames`.
+ @note The frame buffer is shared by the image views with the same image, so once enabled it applies to all of them, until one of them set this to NO explicitly.
+ */
+@property (nonatomic, assign) BOOL storesDeltaFrames;
+/**
+ The max number of upcoming frames to decode ahead of the current frame. Default is 0.
+ `0` means automatically adjust by the measured decode time per frame, prefetch more frames in parallel when decoding one frame takes longer than displaying it.
+ `1` means only prefetch the next frame.
+ */
+@property (nonatomic, assign) NSUInteger maxPrefetchFrameCount;
+/**
+ Whether to keep the wall-clock timing of animation. Default is NO.
+ If NO, when decoding falls behind, the animation stalls on the current frame until the next frame is decoded, so it plays slower.
+ If YES, the animation skips to the frame matching the elapsed time, and the skipped frames are not decoded.
+ */
+@property (nonatomic, assign) BOOL realTimePlayback;
+/**
+ The max number of frames displayed per second. The frames are skipped to keep the wall-clock timing, and the skipped frames are not decoded. Default is 0.
+ `0` means no limit.
+ */
+@property (nonatomic, assign) double maxFrameRate;
+/**
+ Whether to lower the frame rate automatically for small or offscreen image view, to save CPU. Default is NO.
+ If YES, the frame rate is limited to 15 FPS when the view is smaller than 48x48 points, and 2 FPS when the view is outside of its nearest clipping superview or window (such as scrolled out inside a scroll view). The frame rate is updated on layout, window change and scroll. `maxFrameRate` is still respected.
+ */
+@property (nonatomic, assign) BOOL automaticallyReducesFrameRate;
 /**
  Whehter or not to enable incremental image load for animated image. This is for the animated image which `sd_isIncremental` is YES (See `UIImage+Metadata.h`). If enable, animated image rendering will stop at the last frame available currently, and continue when another `setImage:` trigger, where the new animated image's `animatedImageData` should be updated from the previous one. If the `sd_isIncremental` is NO. The incremental image load stop.
  @note If you are confused about this description, open Chrome browser to view some large GIF images with low network speed to see the animation behavior.
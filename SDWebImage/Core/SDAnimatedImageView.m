@@ -14,11 +14,21 @@
 #import "NSImage+Compatibility.h"
 #import "SDInternalMacros.h"
 #import "objc/runtime.h"
+#import "SDImageMappedFrameBuffer.h"
+#import "SDImageFramePool.h"
+
+// The reduced frame rate by `automaticallyReducesFrameRate`
+static const double kSDAnimatedImageViewSmallFrameRate = 15;
+static const double kSDAnimatedImageViewOffscreenFrameRate = 2;
+static const CGFloat kSDAnimatedImageViewSmallSize = 48;
+
+static void * SDAnimatedImageViewContext = &SDAnimatedImageViewContext;
 
 // A wrapper to implements the transformer on animated image, like tint color
-@interface SDAnimatedImageFrameProvider : NSObject <SDAnimatedImageProvider>
+@interface SDAnimatedImageFrameProvider : NSObject <SDAnimatedImageProvider, SDImageFramePoolObserver>
 @property (nonatomic, strong) id<SDAnimatedImageProvider> provider;
 @property (nonatomic, strong) id<SDImageTransformer> transformer;
+@property (nonatomic, strong) SDImageMappedFrameBuffer *transformedFrameBuffer; // cache the transformed frames, shared by the same provider and transformer key
 @end
 
 @implementation SDAnimatedImageFrameProvider
@@ -28,10 +38,37 @@
     if (self) {
         _provider = provider;
         _transformer = transformer;
+        _transformedFrameBuffer = [self.class transformedFrameBufferForProvider:provider transformer:transformer];
     }
     return self;
 }
 
+// The transformed frames are kept in a mapped frame buffer when the animated image enables `maxMappedFrameBufferSize`, so later loops don't decode and transform again. The buffer is associated to the provider, and removed when the provider deallocates
++ (SDImageMappedFrameBuffer *)transformedFrameBufferForProvider:(id<SDAnimatedImageProvider>)provider transformer:(id<SDImageTransformer>)transformer {
+    if (![provider isKindOfClass:SDAnimatedImage.class]) {
+        return nil;
+    }
+    NSUInteger maxMappedFrameBufferSize = ((SDAnimatedImage *)provider).maxMappedFrameBufferSize;
+    NSString *transformerKey = transformer.transformerKey;
+    if (maxMappedFrameBufferSize == 0 || transformerKey.length == 0) {
+        return nil;
+    }
+    SDImageMappedFrameBuffer *frameBuffer;
+    @synchronized (provider) {
+        NSMutableDictionary<NSString *, SDImageMappedFrameBuffer *> *frameBuffers = objc_getAssociatedObject(provider, @selector(transformedFrameBufferForProvider:transformer:));
+        if (!frameBuffers) {
+            frameBuffers = [NSMutableDictionary dictionary];
+            objc_setAssociatedObject(provider, @selector(transformedFrameBufferForProvider:transformer:), frameBuffers, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+        }
+        frameBuffer = frameBuffers[transformerKey];
+        if (!frameBuffer) {
+            frameBuffer = [[SDImageMappedFrameBuffer alloc] initWithLimitBytes:maxMappedFrameBufferSize];
+            frameBuffers[transformerKey] = frameBuffer;
+        }
+    }
+    return frameBuffer;
+}
+
 - (NSUInteger)hash {
     NSUInteger prime = 31;
     NSUInteger result = 1;
@@ -73,8 +110,27 @@
 }
 
 - (UIImage *)animatedImageFrameAtIndex:(NSUInteger)index {
+    SDImageMappedFrameBuffer *transformedFrameBuffer = self.transformedFrameBuffer;
+    UIImage *transformedFrame = [transformedFrameBuffer frameAtIndex:index];
+    if (transformedFrame) {
+        return transformedFrame;
+    }
     UIImage *frame = [self.provider animatedImageFrameAtIndex:index];
-    return [self.transformer transformedImageWithImage:frame forKey:@""];
+    transformedFrame = [self.transformer transformedImageWithImage:frame forKey:@""];
+    if (transformedFrame && transformedFrameBuffer) {
+        UIImage *mappedFrame = [transformedFrameBuffer storeFrame:transformedFrame atIndex:index];
+        if (mappedFrame) {
+            return mappedFrame;
+        }
+    }
+    return transformedFrame;
+}
+
+- (void)framePool:(SDImageFramePool *)framePool didUpdateBufferBytes:(NSUInteger)bufferBytes {
+    // The transformed frames are counted into the original image's memory cost
+    if ([self.provider conformsToProtocol:@protocol(SDImageFramePoolObserver)]) {
+        [(id<SDImageFramePoolObserver>)self.provider framePool:framePool didUpdateBufferBytes:bufferBytes];
+    }
 }
 
 @end
@@ -97,6 +153,9 @@
 @property (nonatomic, assign) BOOL shouldAnimate;
 @property (nonatomic, assign) BOOL isProgressive;
 @property (nonatomic) CALayer *imageViewLayer; // The actual rendering layer.
+#if SD_UIKIT
+@property (nonatomic, strong) UIScrollView *observedScrollView; // The enclosing scroll view, observed for `automaticallyReducesFrameRate` only when in window
+#endif
 
 @end
 
@@ -156,6 +215,11 @@
     return self;
 }
 
+- (void)dealloc
+{
+    [self stopObservingScrollPosition];
+}
+
 - (void)commonInit
 {
     // Pay attention that UIKit's `initWithImage:` will trigger a `setImage:` during initialization before this `commonInit`.
@@ -232,6 +296,18 @@
         // Max Buffer Size
         self.player.maxBufferSize = self.maxBufferSize;
         
+        // Delta Frames, only opt-in here, the frame buffer may be shared with other image views enabling it
+        if (self.storesDeltaFrames) {
+            self.player.storesDeltaFrames = YES;
+        }
+        
+        // Max Prefetch Frame Count
+        self.player.maxPrefetchFrameCount = self.maxPrefetchFrameCount;
+        
+        // Frame Skipping
+        self.player.realTimePlayback = self.realTimePlayback;
+        [self updateFrameRate];
+        
         // Play Rate
         self.player.playbackRate = self.playbackRate;
         
@@ -304,6 +380,37 @@
     return _maxBufferSize; // Defaults to 0
 }
 
+- (void)setStoresDeltaFrames:(BOOL)storesDeltaFrames
+{
+    _storesDeltaFrames = storesDeltaFrames;
+    self.player.storesDeltaFrames = storesDeltaFrames;
+}
+
+- (void)setMaxPrefetchFrameCount:(NSUInteger)maxPrefetchFrameCount
+{
+    _maxPrefetchFrameCount = maxPrefetchFrameCount;
+    self.player.maxPrefetchFrameCount = maxPrefetchFrameCount;
+}
+
+- (void)setRealTimePlayback:(BOOL)realTimePlayback
+{
+    _realTimePlayback = realTimePlayback;
+    self.player.realTimePlayback = realTimePlayback;
+}
+
+- (void)setMaxFrameRate:(double)maxFrameRate
+{
+    _maxFrameRate = maxFrameRate;
+    [self updateFrameRate];
+}
+
+- (void)setAutomaticallyReducesFrameRate:(BOOL)automaticallyReducesFrameRate
+{
+    _automaticallyReducesFrameRate = automaticallyReducesFrameRate;
+    [self startObservingScrollPosition];
+    [self updateFrameRate];
+}
+
 - (void)setPlaybackRate:(double)playbackRate
 {
     _playbackRate = playbackRate;
@@ -354,9 +461,27 @@
     [super didMoveToSuperview];
 #endif
     
+    // The enclosing scroll view may change without changing the window
+    [self startObservingScrollPosition];
     [self checkPlay];
 }
 
+#if SD_MAC
+- (void)viewWillMoveToWindow:(NSWindow *)newWindow
+#else
+- (void)willMoveToWindow:(UIWindow *)newWindow
+#endif
+{
+#if SD_MAC
+    [super viewWillMoveToWindow:newWindow];
+#else
+    [super willMoveToWindow:newWindow];
+#endif
+    
+    // Release the enclosing scroll view before leaving the window
+    [self stopObservingScrollPosition];
+}
+
 #if SD_MAC
 - (void)viewDidMoveToWindow
 #else
@@ -369,9 +494,26 @@
     [super didMoveToWindow];
 #endif
     
+    [self startObservingScrollPosition];
     [self checkPlay];
 }
 
+#if SD_MAC
+- (void)layout
+#else
+- (void)layoutSubviews
+#endif
+{
+#if SD_MAC
+    [super layout];
+#else
+    [super layoutSubviews];
+#endif
+    
+    // The size or position may change
+    [self updateFrameRate];
+}
+
 #if SD_MAC
 - (void)setAlphaValue:(CGFloat)alphaValue
 #else
@@ -515,7 +657,98 @@
     BOOL isVisible = self.window && self.superview && ![self isHidden] && self.alpha > 0.0;
 #endif
     self.shouldAnimate = self.player && isVisible;
+    self.player.visible = isVisible;
+    [self updateFrameRate];
+}
+
+// Update the max frame rate of player by `maxFrameRate` and `automaticallyReducesFrameRate`
+- (void)updateFrameRate
+{
+    if (!self.player) {
+        return;
+    }
+    double maxFrameRate = self.maxFrameRate;
+    if (self.automaticallyReducesFrameRate && self.window) {
+        double reducedFrameRate = 0;
+        CGRect bounds = self.bounds;
+#if SD_MAC
+        BOOL isOffscreen = NSIsEmptyRect(self.visibleRect);
+#else
+        // Compare with the nearest clipping superview (such as scroll view), or the window
+        UIView *clippingView = self.superview;
+        while (clippingView && !clippingView.clipsToBounds) {
+            clippingView = clippingView.superview;
+        }
+        if (!clippingView) {
+            clippingView = self.window;
+        }
+        BOOL isOffscreen = !CGRectIntersectsRect([self convertRect:bounds toView:clippingView], clippingView.bounds);
+#endif
+        if (isOffscreen) {
+            reducedFrameRate = kSDAnimatedImageViewOffscreenFrameRate;
+        } else if (bounds.size.width * bounds.size.height < kSDAnimatedImageViewSmallSize * kSDAnimatedImageViewSmallSize) {
+            reducedFrameRate = kSDAnimatedImageViewSmallFrameRate;
+        }
+        if (reducedFrameRate > 0) {
+            maxFrameRate = maxFrameRate > 0 ? MIN(maxFrameRate, reducedFrameRate) : reducedFrameRate;
+        }
+    }
+    if (self.player.maxFrameRate != maxFrameRate) {
+        self.player.maxFrameRate = maxFrameRate;
+    }
+}
+
+// The view may be scrolled in or out without layout, observe the scroll position of the enclosing scroll view to update the frame rate
+- (void)startObservingScrollPosition
+{
+    [self stopObservingScrollPosition];
+    if (!self.automaticallyReducesFrameRate || !self.window) {
+        return;
+    }
+#if SD_MAC
+    NSClipView *clipView = self.enclosingScrollView.contentView;
+    if (clipView) {
+        [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(scrollPositionDidChange:) name:NSViewBoundsDidChangeNotification object:clipView];
+    }
+#else
+    UIView *scrollView = self.superview;
+    while (scrollView && ![scrollView isKindOfClass:UIScrollView.class]) {
+        scrollView = scrollView.superview;
+    }
+    if (scrollView) {
+        self.observedScrollView = (UIScrollView *)scrollView;
+        [scrollView addObserver:self forKeyPath:NSStringFromSelector(@selector(contentOffset)) options:0 context:SDAnimatedImageViewContext];
+    }
+#endif
+}
+
+- (void)stopObservingScrollPosition
+{
+#if SD_MAC
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:NSViewBoundsDidChangeNotification object:nil];
+#else
+    if (self.observedScrollView) {
+        [self.observedScrollView removeObserver:self forKeyPath:NSStringFromSelector(@selector(contentOffset)) context:SDAnimatedImageViewContext];
+        self.observedScrollView = nil;
+    }
+#endif
+}
+
+#if SD_MAC
+- (void)scrollPositionDidChange:(NSNotification *)notification
+{
+    [self updateFrameRate];
 }
+#else
+- (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey,id> *)change context:(void *)context
+{
+    if (context == SDAnimatedImageViewContext) {
+        [self updateFrameRate];
+    } else {
+        [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
+    }
+}
+#endif
 
 // Update progressive status only after `setImage:` call.
 - (void)updateIsProgressiveWithImage:(UIImage *)image
@@ -117,6 +117,31 @@
  */
 - (NSUInteger)totalSize;
 
+@optional
+/**
+ Returns the HTTP cache validators (`ETag` and `Last-Modified`) associated with a given key.
+ This method may blocks the calling thread until file read finished.
+ 
+ @param key A string identifying the data. If nil, just return nil.
+ @return The validators keyed by header field name, or nil if no validator is associated with key.
+ */
+- (nullable NSDictionary<NSString *, NSString *> *)cacheValidatorsForKey:(nonnull NSString *)key;
+
+/**
+ Set the HTTP cache validators with a given key, without override the exist disk file data.
+ 
+ @param cacheValidators The validators keyed by header field name (pass nil to remove).
+ @param key The key with which to associate the value. If nil, this method has no effect.
+ */
+- (void)setCacheValidators:(nullable NSDictionary<NSString *, NSString *> *)cacheValidators forKey:(nonnull NSString *)key;
+
+/**
+ Mark the data of a given key as fresh (such as revalidated by `304 Not Modified`), without rewriting the disk file data. So the expiration check treat it as a new entry.
+ 
+ @param key The key with which to associate the value. If nil, this method has no effect.
+ */
+- (void)refreshDataForKey:(nonnull NSString *)key;
+
 @end
 
 /**
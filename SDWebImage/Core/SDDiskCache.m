@@ -12,6 +12,7 @@
 #import <CommonCrypto/CommonDigest.h>
 
 static NSString * const SDDiskCacheExtendedAttributeName = @"com.hackemist.SDDiskCache";
+static NSString * const SDDiskCacheValidatorsAttributeName = @"com.hackemist.SDDiskCache.validators";
 
 @interface SDDiskCache ()
 
@@ -124,6 +125,50 @@ static NSString * const SDDiskCacheExtendedAttributeName = @"com.hackemist.SDDis
     }
 }
 
+- (NSDictionary<NSString *,NSString *> *)cacheValidatorsForKey:(NSString *)key {
+    NSParameterAssert(key);
+    NSString *cachePathForKey = [self cachePathForKey:key];
+    
+    NSData *data = [SDFileAttributeHelper extendedAttribute:SDDiskCacheValidatorsAttributeName atPath:cachePathForKey traverseLink:NO error:nil];
+    if (!data) {
+        return nil;
+    }
+    id cacheValidators = [NSPropertyListSerialization propertyListWithData:data options:NSPropertyListImmutable format:nil error:nil];
+    if (![cacheValidators isKindOfClass:NSDictionary.class]) {
+        return nil;
+    }
+    return cacheValidators;
+}
+
+- (void)setCacheValidators:(NSDictionary<NSString *,NSString *> *)cacheValidators forKey:(NSString *)key {
+    NSParameterAssert(key);
+    NSString *cachePathForKey = [self cachePathForKey:key];
+    
+    NSData *data;
+    if (cacheValidators.count > 0) {
+        data = [NSPropertyListSerialization dataWithPropertyList:cacheValidators format:NSPropertyListBinaryFormat_v1_0 options:0 error:nil];
+    }
+    if (!data) {
+        // Remove
+        [SDFileAttributeHelper removeExtendedAttribute:SDDiskCacheValidatorsAttributeName atPath:cachePathForKey traverseLink:NO error:nil];
+    } else {
+        // Override
+        [SDFileAttributeHelper setExtendedAttribute:SDDiskCacheValidatorsAttributeName value:data atPath:cachePathForKey traverseLink:NO overwrite:YES error:nil];
+    }
+}
+
+- (void)refreshDataForKey:(NSString *)key {
+    NSParameterAssert(key);
+    NSString *cachePathForKey = [self cachePathForKey:key];
+    if (![self.fileManager fileExistsAtPath:cachePathForKey]) {
+        return;
+    }
+    // Touch the dates used by expiration check, the file content is untouched
+    NSDate *now = [NSDate date];
+    [self.fileManager setAttributes:@{NSFileModificationDate : now} ofItemAtPath:cachePathForKey error:nil];
+    [[NSURL fileURLWithPath:cachePathForKey] setResourceValue:now forKey:NSURLContentAccessDateKey error:nil];
+}
+
 - (void)removeDataForKey:(NSString *)key {
     NSParameterAssert(key);
     NSString *filePath = [self cachePathForKey:key];
@@ -25,6 +25,12 @@
     return coder;
 }
 
+#pragma mark - SDImageCoder
+
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format {
+    return format == SDImageFormatPNG;
+}
+
 #pragma mark - Subclass Override
 
 + (SDImageFormat)imageFormat {
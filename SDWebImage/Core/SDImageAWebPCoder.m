@@ -42,7 +42,11 @@ static NSString * kSDCGImagePropertyWebPUnclampedDelayTime = @"UnclampedDelayTim
 #pragma mark - SDImageCoder
 
 - (BOOL)canDecodeFromData:(nullable NSData *)data {
-    switch ([NSData sd_imageFormatForImageData:data]) {
+    return [self canDecodeFromFormat:[NSData sd_imageFormatForImageData:data]];
+}
+
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format {
+    switch (format) {
         case SDImageFormatWebP:
             // Check WebP decoding compatibility
             return [self.class canDecodeFromFormat:SDImageFormatWebP];
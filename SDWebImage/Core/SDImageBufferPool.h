@@ -0,0 +1,59 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import <CoreGraphics/CoreGraphics.h>
+#import "SDWebImageCompat.h"
+
+/**
+ The size-class pool of bitmap buffers, used by `SDImageCoderHelper` force decoding and scaling, to avoid allocating a fresh few MB bitmap for each image, which churns the allocator and causes page faults during scrolling.
+ The buffer length is rounded up to the size class (each power of 2 is divided into 8 classes, at least 64 KB), so the buffer can be reused by the image of similar size, and the slack is at most 12.5%. The small buffer is not pooled, the buffer larger than `maxBytes` is allocated with the exact length and never pooled.
+ The idle buffers are bounded by `maxBytes`, and all removed when receiving memory warning.
+ @note This class is thread-safe.
+ */
+@interface SDImageBufferPool : NSObject
+
+/// The shared pool used by the framework.
+@property (nonatomic, class, readonly, nonnull) SDImageBufferPool *sharedPool;
+
+/// The max total bytes of the idle buffers kept in the pool. Defaults to 1/128 of the physical memory. Pass 0 to disable pooling.
+@property (nonatomic, assign) NSUInteger maxBytes;
+
+/// The total bytes of the idle buffers in the pool.
+@property (nonatomic, assign, readonly) NSUInteger pooledBytes;
+
+/**
+ Take a buffer from the pool, or allocate a new one if no idle buffer for the size class.
+ @note The buffer content is undefined, clear it if you need.
+
+ @param length The buffer length in bytes
+ @return The buffer, at least `length` bytes. NULL if allocation failed. You must return it via `recycleBuffer:length:` with the same length, or hand it over to `createDataProviderWithBuffer:length:`.
+ */
+- (nullable void *)allocateBufferWithLength:(size_t)length NS_RETURNS_INNER_POINTER;
+
+/**
+ Return the buffer to the pool. The buffer is freed if the pool is full.
+
+ @param buffer The buffer from `allocateBufferWithLength:`
+ @param length The length passed to `allocateBufferWithLength:`
+ */
+- (void)recycleBuffer:(nonnull void *)buffer length:(size_t)length;
+
+/**
+ Create a data provider which wraps the buffer without copy. The buffer is returned to the pool when the data provider is freed, which means the `CGImage` created with this data provider is freed.
+
+ @param buffer The buffer from `allocateBufferWithLength:`, the ownership is transferred to the data provider
+ @param length The length passed to `allocateBufferWithLength:`
+ @return The data provider, or NULL if failed (the buffer is recycled)
+ */
+- (nullable CGDataProviderRef)createDataProviderWithBuffer:(nonnull void *)buffer length:(size_t)length CF_RETURNS_RETAINED;
+
+/// Free all the idle buffers.
+- (void)removeAllBuffers;
+
+@end
@@ -0,0 +1,194 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDImageBufferPool.h"
+#import "SDInternalMacros.h"
+#import "SDDeviceHelper.h"
+#import <malloc/malloc.h>
+
+// The buffer smaller than this is cheap to allocate, not pooled
+static const size_t kMinimumPooledLength = 64 * 1024;
+
+// Each power of 2 is divided into 8 size classes, so the slack is at most 12.5%
+static const size_t kSizeClassesPerPowerOf2 = 8;
+
+// Round up to the size class, so the buffer can be reused by the similar size
+static size_t SDImageBufferPoolCapacityForLength(size_t length) {
+    if (length < kMinimumPooledLength || length > SIZE_MAX / 2) {
+        return length;
+    }
+    size_t powerOf2 = kMinimumPooledLength;
+    while (powerOf2 <= length / 2) {
+        powerOf2 *= 2;
+    }
+    size_t step = powerOf2 / kSizeClassesPerPowerOf2;
+    return (length + step - 1) / step * step;
+}
+
+static void SDImageBufferPoolReleaseData(void *info, const void *data, size_t size) {
+    SDImageBufferPool *pool = (__bridge_transfer SDImageBufferPool *)info;
+    [pool recycleBuffer:(void *)data length:size];
+}
+
+@interface SDImageBufferPool ()
+
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSNumber *, NSMutableArray<NSValue *> *> *buffers; // capacity -> idle buffers
+
+@end
+
+@implementation SDImageBufferPool {
+    SD_LOCK_DECLARE(_lock);
+    NSUInteger _maxBytes;
+    NSUInteger _pooledBytes;
+}
+
++ (SDImageBufferPool *)sharedPool {
+    static dispatch_once_t onceToken;
+    static SDImageBufferPool *pool;
+    dispatch_once(&onceToken, ^{
+        pool = [[SDImageBufferPool alloc] init];
+    });
+    return pool;
+}
+
+- (void)dealloc {
+    [self removeAllBuffers];
+#if SD_UIKIT
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+#endif
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _maxBytes = [SDDeviceHelper totalMemory] / 128;
+        _buffers = [NSMutableDictionary dictionary];
+        SD_LOCK_INIT(_lock);
+#if SD_UIKIT
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(didReceiveMemoryWarning:)
+                                                     name:UIApplicationDidReceiveMemoryWarningNotification
+                                                   object:nil];
+#endif
+    }
+    return self;
+}
+
+#if SD_UIKIT
+- (void)didReceiveMemoryWarning:(NSNotification *)notification {
+    [self removeAllBuffers];
+}
+#endif
+
+#pragma mark - Properties
+
+- (NSUInteger)maxBytes {
+    SD_LOCK(_lock);
+    NSUInteger maxBytes = _maxBytes;
+    SD_UNLOCK(_lock);
+    return maxBytes;
+}
+
+- (void)setMaxBytes:(NSUInteger)maxBytes {
+    SD_LOCK(_lock);
+    _maxBytes = maxBytes;
+    SD_UNLOCK(_lock);
+    if (self.pooledBytes > maxBytes) {
+        [self removeAllBuffers];
+    }
+}
+
+- (NSUInteger)pooledBytes {
+    SD_LOCK(_lock);
+    NSUInteger pooledBytes = _pooledBytes;
+    SD_UNLOCK(_lock);
+    return pooledBytes;
+}
+
+#pragma mark - Buffer
+
+- (void *)allocateBufferWithLength:(size_t)length {
+    if (length == 0) {
+        return NULL;
+    }
+    size_t capacity = SDImageBufferPoolCapacityForLength(length);
+    void *buffer = NULL;
+    BOOL poolable = NO;
+    if (capacity >= kMinimumPooledLength) {
+        SD_LOCK(_lock);
+        poolable = capacity <= _maxBytes;
+        NSMutableArray<NSValue *> *idleBuffers = self.buffers[@(capacity)];
+        NSValue *value = idleBuffers.lastObject;
+        if (value) {
+            [idleBuffers removeLastObject];
+            _pooledBytes -= capacity;
+            buffer = value.pointerValue;
+        }
+        SD_UNLOCK(_lock);
+    }
+    if (!buffer) {
+        // The buffer which can never be pooled does not need the slack
+        buffer = malloc(poolable ? capacity : length);
+    }
+    return buffer;
+}
+
+- (void)recycleBuffer:(void *)buffer length:(size_t)length {
+    if (!buffer) {
+        return;
+    }
+    size_t capacity = SDImageBufferPoolCapacityForLength(length);
+    BOOL pooled = NO;
+    // The buffer may be allocated with the exact length (when the `maxBytes` is smaller at that time), check the real size
+    if (capacity >= kMinimumPooledLength && malloc_size(buffer) >= capacity) {
+        SD_LOCK(_lock);
+        if (_pooledBytes + capacity <= _maxBytes) {
+            NSMutableArray<NSValue *> *idleBuffers = self.buffers[@(capacity)];
+            if (!idleBuffers) {
+                idleBuffers = [NSMutableArray array];
+                self.buffers[@(capacity)] = idleBuffers;
+            }
+            [idleBuffers addObject:[NSValue valueWithPointer:buffer]];
+            _pooledBytes += capacity;
+            pooled = YES;
+        }
+        SD_UNLOCK(_lock);
+    }
+    if (!pooled) {
+        free(buffer);
+    }
+}
+
+- (CGDataProviderRef)createDataProviderWithBuffer:(void *)buffer length:(size_t)length {
+    if (!buffer) {
+        return NULL;
+    }
+    void *info = (__bridge_retained void *)self;
+    CGDataProviderRef provider = CGDataProviderCreateWithData(info, buffer, length, SDImageBufferPoolReleaseData);
+    if (!provider) {
+        CFRelease(info);
+        [self recycleBuffer:buffer length:length];
+        return NULL;
+    }
+    return provider;
+}
+
+- (void)removeAllBuffers {
+    SD_LOCK(_lock);
+    NSDictionary<NSNumber *, NSMutableArray<NSValue *> *> *buffers = [self.buffers copy];
+    [self.buffers removeAllObjects];
+    _pooledBytes = 0;
+    SD_UNLOCK(_lock);
+    for (NSArray<NSValue *> *idleBuffers in buffers.allValues) {
+        for (NSValue *value in idleBuffers) {
+            free(value.pointerValue);
+        }
+    }
+}
+
+@end
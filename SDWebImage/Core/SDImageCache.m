@@ -16,6 +16,7 @@
 #import "UIImage+Metadata.h"
 #import "UIImage+ExtendedCacheData.h"
 #import "SDCallbackQueue.h"
+#import "SDImageDecodeScheduler.h"
 #import "SDImageTransformer.h" // TODO, remove this
 
 // TODO, remove this
@@ -74,6 +75,7 @@ static NSString * _defaultDiskCacheDirectory;
 @property (nonatomic, copy, readwrite, nonnull) SDImageCacheConfig *config;
 @property (nonatomic, copy, readwrite, nonnull) NSString *diskCachePath;
 @property (nonatomic, strong, nonnull) dispatch_queue_t ioQueue;
+@property (nonatomic, strong, nonnull) dispatch_queue_t decodeQueue;
 
 @end
 
@@ -130,6 +132,9 @@ static NSString * _defaultDiskCacheDirectory;
         dispatch_queue_attr_t ioQueueAttributes = _config.ioQueueAttributes;
         _ioQueue = dispatch_queue_create("com.hackemist.SDImageCache.ioQueue", ioQueueAttributes);
         NSAssert(_ioQueue, @"The IO queue should not be nil. Your configured `ioQueueAttributes` may be wrong");
+        // Create decode queue, the decode may wait for `SDImageDecodeScheduler` budget, which should not block the serial IO queue
+        // Serial to keep the disk query completion in order, and at most one thread waits for the budget
+        _decodeQueue = dispatch_queue_create("com.hackemist.SDImageCache.decodeQueue", DISPATCH_QUEUE_SERIAL);
         
         // Init the memory cache
         NSAssert([config.memoryCacheClass conformsToProtocol:@protocol(SDMemoryCache)], @"Custom memory cache class must conform to `SDMemoryCache` protocol");
@@ -267,7 +272,8 @@ static NSString * _defaultDiskCacheDirectory;
     }
     SDCallbackQueue *queue = context[SDWebImageContextCallbackQueue];
     if (!data && image) {
-        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        // Encoding may need the full bitmap, share the decode budget. Wait for the budget asynchronously, without parking a thread
+        [SDImageDecodeScheduler.sharedScheduler performAsyncWithCost:image.sd_memoryCost priority:SDImageDecodePriorityBackground queue:dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0) block:^{
             // Check image's associated image format, may return .undefined
             SDImageFormat format = image.sd_imageFormat;
             if (format == SDImageFormatUndefined) {
@@ -293,7 +299,7 @@ static NSString * _defaultDiskCacheDirectory;
                     }];
                 }
             });
-        });
+        }];
     } else {
         dispatch_async(self.ioQueue, ^{
             [self _storeImageDataToDisk:data forKey:key];
@@ -311,6 +317,11 @@ static NSString * _defaultDiskCacheDirectory;
     if (!image || !key) {
         return;
     }
+    // Check HTTP cache validators
+    NSDictionary<NSString *, NSString *> *cacheValidators = image.sd_cacheValidators;
+    if (cacheValidators && [self.diskCache respondsToSelector:@selector(setCacheValidators:forKey:)]) {
+        [self.diskCache setCacheValidators:cacheValidators forKey:key];
+    }
     // Check extended data
     id extendedObject = image.sd_extendedObject;
     if (![extendedObject conformsToProtocol:@protocol(NSCoding)]) {
@@ -522,7 +533,12 @@ static NSString * _defaultDiskCacheDirectory;
     if (!data) {
         return nil;
     }
-    UIImage *image = SDImageCacheDecodeImageData(data, key, [[self class] imageOptionsFromCacheOptions:options], context);
+    SDWebImageOptions imageOptions = [[self class] imageOptionsFromCacheOptions:options];
+    NSUInteger cost = [SDImageDecodeScheduler decodeCostForImageData:data options:SDGetDecodeOptionsFromContext(context, imageOptions, key)];
+    __block UIImage *image;
+    [SDImageDecodeScheduler.sharedScheduler performWithCost:cost priority:SDImageDecodePriorityNormal block:^{
+        image = SDImageCacheDecodeImageData(data, key, imageOptions, context);
+    }];
     [self _unarchiveObjectWithImage:image forKey:key];
     return image;
 }
@@ -567,6 +583,10 @@ static NSString * _defaultDiskCacheDirectory;
     if (!image || !key) {
         return;
     }
+    // Check HTTP cache validators
+    if ([self.diskCache respondsToSelector:@selector(cacheValidatorsForKey:)]) {
+        image.sd_cacheValidators = [self.diskCache cacheValidatorsForKey:key];
+    }
     // Check extended data
     NSData *extendedData = [self.diskCache extendedDataForKey:key];
     if (!extendedData) {
@@ -714,38 +734,41 @@ static NSString * _defaultDiskCacheDirectory;
         return diskImage;
     };
     
-    // Query in ioQueue to keep IO-safe
+    // Query in ioQueue to keep IO-safe, decode outside ioQueue, because waiting for the decode budget should not block other IO (such as the `dispatch_sync` query from main thread)
     if (shouldQueryDiskSync) {
         __block NSData* diskData;
-        __block UIImage* diskImage;
         dispatch_sync(self.ioQueue, ^{
             diskData = queryDiskDataBlock();
-            diskImage = queryDiskImageBlock(diskData);
         });
+        UIImage* diskImage = queryDiskImageBlock(diskData);
         if (doneBlock) {
             doneBlock(diskImage, diskData, SDImageCacheTypeDisk);
         }
     } else {
         dispatch_async(self.ioQueue, ^{
             NSData* diskData = queryDiskDataBlock();
-            UIImage* diskImage = queryDiskImageBlock(diskData);
-            @synchronized (operation) {
-                if (operation.isCancelled) {
-                    return;
+            dispatch_block_t decodeBlock = ^{
+                UIImage* diskImage = queryDiskImageBlock(diskData);
+                @synchronized (operation) {
+                    if (operation.isCancelled) {
+                        return;
+                    }
                 }
-            }
-            if (doneBlock) {
-                [(queue ?: SDCallbackQueue.mainQueue) async:^{
-                    // Dispatch from IO queue to main queue need time, user may call cancel during the dispatch timing
-                    // This check is here to avoid double callback (one is from `SDImageCacheToken` in sync)
-                    @synchronized (operation) {
-                        if (operation.isCancelled) {
-                            return;
+                if (doneBlock) {
+                    [(queue ?: SDCallbackQueue.mainQueue) async:^{
+                        // Dispatch from IO queue to main queue need time, user may call cancel during the dispatch timing
+                        // This check is here to avoid double callback (one is from `SDImageCacheToken` in sync)
+                        @synchronized (operation) {
+                            if (operation.isCancelled) {
+                                return;
+                            }
                         }
-                    }
-                    doneBlock(diskImage, diskData, SDImageCacheTypeDisk);
-                }];
-            }
+                        doneBlock(diskImage, diskData, SDImageCacheTypeDisk);
+                    }];
+                }
+            };
+            // Always go through the serial decode queue, even nothing to decode, so the completion keeps the query order
+            dispatch_async(self.decodeQueue, decodeBlock);
         });
     }
     
@@ -958,6 +981,33 @@ static NSString * _defaultDiskCacheDirectory;
     [self storeImage:image imageData:imageData forKey:key options:0 context:nil cacheType:cacheType completion:completionBlock];
 }
 
+- (void)refreshImageForKey:(NSString *)key cacheValidators:(NSDictionary<NSString *,NSString *> *)cacheValidators completion:(SDWebImageNoParamsBlock)completionBlock {
+    if (!key) {
+        if (completionBlock) {
+            completionBlock();
+        }
+        return;
+    }
+    if (cacheValidators) {
+        // The memory image is shared, update it in place to let next revalidation use the new validators
+        UIImage *memoryImage = [self imageFromMemoryCacheForKey:key];
+        memoryImage.sd_cacheValidators = cacheValidators;
+    }
+    dispatch_async(self.ioQueue, ^{
+        if (cacheValidators && [self.diskCache respondsToSelector:@selector(setCacheValidators:forKey:)]) {
+            [self.diskCache setCacheValidators:cacheValidators forKey:key];
+        }
+        if ([self.diskCache respondsToSelector:@selector(refreshDataForKey:)]) {
+            [self.diskCache refreshDataForKey:key];
+        }
+        if (completionBlock) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completionBlock();
+            });
+        }
+    });
+}
+
 - (void)removeImageForKey:(NSString *)key cacheType:(SDImageCacheType)cacheType completion:(nullable SDWebImageNoParamsBlock)completionBlock {
     switch (cacheType) {
         case SDImageCacheTypeNone: {
@@ -144,6 +144,18 @@ FOUNDATION_EXPORT void SDSetDecodeOptionsToContext(SDWebImageMutableContext * _N
          cacheType:(SDImageCacheType)cacheType
         completion:(nullable SDWebImageNoParamsBlock)completionBlock;
 
+/**
+ Mark the cached image for the given key as fresh, after the remote location revalidated it (`304 Not Modified`). The image data is not rewritten, only the HTTP cache validators and the expiration date are updated. Completion is called asynchronously.
+ This is used by `SDWebImageRefreshCachedWithValidators`.
+
+ @param key The image cache key
+ @param cacheValidators The new HTTP cache validators (`ETag` and `Last-Modified`) from the `304` response. Pass nil to keep the current one
+ @param completionBlock A block executed after the operation is finished
+ */
+- (void)refreshImageForKey:(nullable NSString *)key
+           cacheValidators:(nullable NSDictionary<NSString *, NSString *> *)cacheValidators
+                completion:(nullable SDWebImageNoParamsBlock)completionBlock;
+
 #pragma mark - Deprecated because SDWebImageManager does not use these APIs
 /**
  Remove the image from image cache for the given key. If cache type is memory only, completion is called synchronously, else asynchronously.
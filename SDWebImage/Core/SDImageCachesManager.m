@@ -171,6 +171,25 @@
     }
 }
 
+- (void)refreshImageForKey:(NSString *)key cacheValidators:(NSDictionary<NSString *,NSString *> *)cacheValidators completion:(SDWebImageNoParamsBlock)completionBlock {
+    // Revalidation applies to every cache which stored the image, regardless of the store policy
+    dispatch_group_t group = dispatch_group_create();
+    for (id<SDImageCache> cache in self.caches) {
+        if (![cache respondsToSelector:@selector(refreshImageForKey:cacheValidators:completion:)]) {
+            continue;
+        }
+        dispatch_group_enter(group);
+        [cache refreshImageForKey:key cacheValidators:cacheValidators completion:^{
+            dispatch_group_leave(group);
+        }];
+    }
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        if (completionBlock) {
+            completionBlock();
+        }
+    });
+}
+
 - (void)removeImageForKey:(NSString *)key cacheType:(SDImageCacheType)cacheType completion:(SDWebImageNoParamsBlock)completionBlock {
     if (!key) {
         return;
@@ -150,6 +150,16 @@ FOUNDATION_EXPORT SDImageCoderOption _Nonnull const SDImageCoderEncodeMaxFileSiz
  */
 FOUNDATION_EXPORT SDImageCoderOption _Nonnull const SDImageCoderEncodeEmbedThumbnail;
 
+/// The progress block for animated image encoding, called after each frame appended. Set `stop` to YES to cancel the encoding
+typedef void(^SDImageCoderEncodeProgressBlock)(NSUInteger encodedFrameCount, NSUInteger totalFrameCount, BOOL * _Nonnull stop);
+
+/**
+ A `SDImageCoderEncodeProgressBlock` block to observe the animated image encoding progress, or cancel it. (SDImageCoderEncodeProgressBlock)
+ The block is called on the encoding thread in frame order, after each frame is appended. When `stop` is set to YES, the remaining frames are skipped and the encoder returns nil.
+ @note works for `SDAnimatedImageCoder` when encoding with `encodedDataWithFrames:loopCount:format:options:`
+ */
+FOUNDATION_EXPORT SDImageCoderOption _Nonnull const SDImageCoderEncodeProgress;
+
 /**
  A SDWebImageContext object which hold the original context options from top-level API. (SDWebImageContext)
  This option is ignored for all built-in coders and take no effect.
@@ -217,6 +227,19 @@ FOUNDATION_EXPORT SDImageCoderOption _Nonnull const SDImageCoderWebImageContext
                                    format:(SDImageFormat)format
                                   options:(nullable SDImageCoderOptions *)options;
 
+@optional
+#pragma mark - Format Declaration
+/**
+ Returns YES if this coder can decode the data of image format, which is detected by `+[NSData sd_imageFormatForImageData:]`.
+ Implement this when the coder decides only by image format, so `SDImageCodersManager` can sniff the format once and dispatch through a format-indexed table, without calling `canDecodeFromData:` on each coder. The result for each format should not change during the coder's lifetime.
+ @note Coders which does not implement this (like the custom format which `sd_imageFormatForImageData:` can not detect) still go through `canDecodeFromData:` in the priority order.
+ @note If the subclass overrides `canDecodeFromData:` without overriding this, the `canDecodeFromData:` is still called, so the subclass can reject some data of the format.
+
+ @param format The image format
+ @return YES if this coder can decode the image format, NO otherwise
+ */
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format NS_SWIFT_NAME(canDecode(from:));
+
 #pragma mark - Animated Encoding
 @optional
 /**
@@ -25,5 +25,6 @@ SDImageCoderOption const SDImageCoderEncodeBackgroundColor = @"encodeBackgroundC
 SDImageCoderOption const SDImageCoderEncodeMaxPixelSize = @"encodeMaxPixelSize";
 SDImageCoderOption const SDImageCoderEncodeMaxFileSize = @"encodeMaxFileSize";
 SDImageCoderOption const SDImageCoderEncodeEmbedThumbnail = @"encodeEmbedThumbnail";
+SDImageCoderOption const SDImageCoderEncodeProgress = @"encodeProgress";
 
 SDImageCoderOption const SDImageCoderWebImageContext = @"webImageContext";
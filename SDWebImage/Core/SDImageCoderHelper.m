@@ -19,6 +19,7 @@
 #import "SDInternalMacros.h"
 #import "SDDeviceHelper.h"
 #import "SDImageIOAnimatedCoderInternal.h"
+#import "SDImageBufferPool.h"
 #import <Accelerate/Accelerate.h>
 
 #define kCGColorSpaceDeviceRGB CFSTR("kCGColorSpaceDeviceRGB")
@@ -130,6 +131,22 @@ static CGFloat kDestImageLimitBytes = 30.f * kBytesPerMB;
 
 static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to overlap the seems where tiles meet.
 
+// Create the image which use the pooled buffer without copy, the buffer is returned to `SDImageBufferPool` when the image is freed
+static CGImageRef SDCGImageCreateWithPooledBuffer(void *buffer, size_t length, size_t width, size_t height, size_t bitsPerComponent, size_t bitsPerPixel, size_t bytesPerRow, CGColorSpaceRef colorSpace, CGBitmapInfo bitmapInfo, CGColorRenderingIntent renderingIntent) CF_RETURNS_RETAINED {
+    CGDataProviderRef provider = [SDImageBufferPool.sharedPool createDataProviderWithBuffer:buffer length:length];
+    if (!provider) {
+        return NULL;
+    }
+    CGImageRef imageRef = CGImageCreate(width, height, bitsPerComponent, bitsPerPixel, bytesPerRow, colorSpace, bitmapInfo, provider, NULL, false, renderingIntent);
+    CGDataProviderRelease(provider);
+    return imageRef;
+}
+
+// The `vImageCreateCGImageFromBuffer` callback to return the pooled buffer, the user data is the buffer length
+static void SDImageBufferPoolReleaseVImageData(void *userData, void *buf_data) {
+    [SDImageBufferPool.sharedPool recycleBuffer:buf_data length:(size_t)(uintptr_t)userData];
+}
+
 #if SD_MAC
 @interface SDAnimatedImageRep (Private)
 /// This wrap the animated image frames for legacy animated image coder API (`encodedDataWithImage:`).
@@ -469,18 +486,32 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
     // kCGImageAlphaNone is not supported in CGBitmapContextCreate.
     // Check #3330 for more detail about why this bitmap is choosen.
     // From v5.17.0, use runtime detection of bitmap info instead of hardcode.
-    CGBitmapInfo bitmapInfo = [SDImageCoderHelper preferredPixelFormat:hasAlpha].bitmapInfo;
-    CGContextRef context = CGBitmapContextCreate(NULL, newWidth, newHeight, 8, 0, [self colorSpaceGetDeviceRGB], bitmapInfo);
+    SDImagePixelFormat pixelFormat = [SDImageCoderHelper preferredPixelFormat:hasAlpha];
+    CGBitmapInfo bitmapInfo = pixelFormat.bitmapInfo;
+    // Draw into the pooled buffer, and create image from it without copy
+    size_t bytesPerRow = SDByteAlign(newWidth * kBytesPerPixel, pixelFormat.alignment);
+    size_t length = bytesPerRow * newHeight;
+    void *buffer = [SDImageBufferPool.sharedPool allocateBufferWithLength:length];
+    if (!buffer) {
+        return NULL;
+    }
+    CGColorSpaceRef colorSpace = [self colorSpaceGetDeviceRGB];
+    CGContextRef context = CGBitmapContextCreate(buffer, newWidth, newHeight, kBitsPerComponent, bytesPerRow, colorSpace, bitmapInfo);
     if (!context) {
+        [SDImageBufferPool.sharedPool recycleBuffer:buffer length:length];
         return NULL;
     }
+    if (hasAlpha) {
+        // The pooled buffer may contains the previous pixels
+        CGContextClearRect(context, CGRectMake(0, 0, newWidth, newHeight));
+    }
     
     // Apply transform
     CGAffineTransform transform = SDCGContextTransformFromOrientation(orientation, CGSizeMake(newWidth, newHeight));
     CGContextConcatCTM(context, transform);
     CGContextDrawImage(context, CGRectMake(0, 0, width, height), cgImage); // The rect is bounding box of CGImage, don't swap width & height
-    CGImageRef newImageRef = CGBitmapContextCreateImage(context);
     CGContextRelease(context);
+    CGImageRef newImageRef = SDCGImageCreateWithPooledBuffer(buffer, length, newWidth, newHeight, kBitsPerComponent, kBitsPerComponent * kBytesPerPixel, bytesPerRow, colorSpace, bitmapInfo, kCGRenderingIntentDefault);
     
     return newImageRef;
 }
@@ -530,10 +561,12 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
         // Keep float components
         alphaBitmapInfo |= kCGBitmapFloatComponents;
     }
+    // Both buffers are taken from the pool, the output one is handed over to the output image
     __block vImage_Buffer input_buffer = {}, output_buffer = {};
+    __block size_t input_length = 0, output_length = 0;
     @onExit {
-        if (input_buffer.data) free(input_buffer.data);
-        if (output_buffer.data) free(output_buffer.data);
+        if (input_buffer.data) [SDImageBufferPool.sharedPool recycleBuffer:input_buffer.data length:input_length];
+        if (output_buffer.data) [SDImageBufferPool.sharedPool recycleBuffer:output_buffer.data length:output_length];
     };
     // Always provide alpha channel
     vImage_CGImageFormat format = (vImage_CGImageFormat) {
@@ -545,11 +578,19 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
         .decode = NULL,
         .renderingIntent = renderingIntent
     };
-    // input
-    vImage_Error ret = vImageBuffer_InitWithCGImage(&input_buffer, &format, NULL, cgImage, kvImageNoFlags);
+    // input, `kvImageNoAllocate` only fill the preferred rowBytes
+    vImage_Error ret = vImageBuffer_Init(&input_buffer, height, width, format.bitsPerPixel, kvImageNoAllocate);
+    if (ret < kvImageNoError) return NULL;
+    input_length = input_buffer.rowBytes * input_buffer.height;
+    input_buffer.data = [SDImageBufferPool.sharedPool allocateBufferWithLength:input_length];
+    if (!input_buffer.data) return NULL;
+    ret = vImageBuffer_InitWithCGImage(&input_buffer, &format, NULL, cgImage, kvImageNoAllocate);
     if (ret != kvImageNoError) return NULL;
     // output
-    vImageBuffer_Init(&output_buffer, size.height, size.width, (uint32_t)bitsPerComponent * components, kvImageNoFlags);
+    ret = vImageBuffer_Init(&output_buffer, size.height, size.width, (uint32_t)bitsPerComponent * components, kvImageNoAllocate);
+    if (ret < kvImageNoError) return NULL;
+    output_length = output_buffer.rowBytes * output_buffer.height;
+    output_buffer.data = [SDImageBufferPool.sharedPool allocateBufferWithLength:output_length];
     if (!output_buffer.data) return NULL;
     
     if (components == 4) {
@@ -592,7 +633,12 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
         .decode = NULL,
         .renderingIntent = renderingIntent
     };
-    CGImageRef outputImage = vImageCreateCGImageFromBuffer(&output_buffer, &output_format, NULL, NULL, kvImageNoFlags, &ret);
+    // Use the output buffer without copy, which is returned to the pool when the image is freed
+    CGImageRef outputImage = vImageCreateCGImageFromBuffer(&output_buffer, &output_format, SDImageBufferPoolReleaseVImageData, (void *)(uintptr_t)output_length, kvImageNoAllocate, &ret);
+    if (outputImage) {
+        // Owned by the output image now
+        output_buffer.data = NULL;
+    }
     if (ret != kvImageNoError) {
         CGImageRelease(outputImage);
         return NULL;
@@ -790,18 +836,33 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
         // kCGImageAlphaNone is not supported in CGBitmapContextCreate.
         // Check #3330 for more detail about why this bitmap is choosen.
         // From v5.17.0, use runtime detection of bitmap info instead of hardcode.
-        CGBitmapInfo bitmapInfo = [SDImageCoderHelper preferredPixelFormat:hasAlpha].bitmapInfo;
-        CGContextRef destContext = CGBitmapContextCreate(NULL,
-                                                         destResolution.width,
-                                                         destResolution.height,
+        SDImagePixelFormat pixelFormat = [SDImageCoderHelper preferredPixelFormat:hasAlpha];
+        CGBitmapInfo bitmapInfo = pixelFormat.bitmapInfo;
+        // Draw into the pooled buffer, and create image from it without copy
+        size_t destWidth = destResolution.width;
+        size_t destHeight = destResolution.height;
+        size_t destBytesPerRow = SDByteAlign(destWidth * kBytesPerPixel, pixelFormat.alignment);
+        size_t destLength = destBytesPerRow * destHeight;
+        void *destBuffer = [SDImageBufferPool.sharedPool allocateBufferWithLength:destLength];
+        if (!destBuffer) {
+            return image;
+        }
+        CGContextRef destContext = CGBitmapContextCreate(destBuffer,
+                                                         destWidth,
+                                                         destHeight,
                                                          kBitsPerComponent,
-                                                         0,
+                                                         destBytesPerRow,
                                                          colorspaceRef,
                                                          bitmapInfo);
         
         if (destContext == NULL) {
+            [SDImageBufferPool.sharedPool recycleBuffer:destBuffer length:destLength];
             return image;
         }
+        if (hasAlpha) {
+            // The pooled buffer may contains the previous pixels
+            CGContextClearRect(destContext, CGRectMake(0, 0, destWidth, destHeight));
+        }
         CGContextSetInterpolationQuality(destContext, kCGInterpolationHigh);
         
         // Now define the size of the rectangle to be used for the
@@ -857,8 +918,8 @@ static const CGFloat kDestSeemOverlap = 2.0f;   // the numbers of pixels to over
             CGImageRelease( sourceTileImageRef );
         }
         
-        CGImageRef destImageRef = CGBitmapContextCreateImage(destContext);
         CGContextRelease(destContext);
+        CGImageRef destImageRef = SDCGImageCreateWithPooledBuffer(destBuffer, destLength, destWidth, destHeight, kBitsPerComponent, kBitsPerComponent * kBytesPerPixel, destBytesPerRow, colorspaceRef, bitmapInfo, kCGRenderingIntentDefault);
         if (destImageRef == NULL) {
             return image;
         }
@@ -28,6 +28,8 @@
  Conformance is important because that way, they will implement `canDecodeFromData` or `canEncodeToFormat`
  Those methods are called on each coder in the array (using the priority order) until one of them returns YES.
  That means that coder can decode that data / encode to that format
+ For decoding, the manager sniff the image format only once. Coders which implement `canDecodeFromFormat:` are looked up from a format-indexed table (built lazily and cleared when coders changed) without calling `canDecodeFromData:`, other coders are still probed with `canDecodeFromData:`. The priority order is kept for both.
+ If a subclass overrides `canDecodeFromData:` but inherits `canDecodeFromFormat:` (such as a subclass of `SDImageGIFCoder` which rejects some data), it's still probed with `canDecodeFromData:`.
  */
 @interface SDImageCodersManager : NSObject <SDImageCoder>
 
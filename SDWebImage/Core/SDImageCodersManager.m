@@ -12,10 +12,53 @@
 #import "SDImageAPNGCoder.h"
 #import "SDImageHEICCoder.h"
 #import "SDInternalMacros.h"
+#import "NSData+ImageContentType.h"
+#import <objc/runtime.h>
+
+// The class in the hierarchy which provides the implementation of selector
+static Class SDImplementingClassForSelector(Class cls, SEL selector) {
+    IMP imp = method_getImplementation(class_getInstanceMethod(cls, selector));
+    Class superclass = class_getSuperclass(cls);
+    while (superclass) {
+        Method method = class_getInstanceMethod(superclass, selector);
+        if (!method || method_getImplementation(method) != imp) {
+            break;
+        }
+        cls = superclass;
+        superclass = class_getSuperclass(cls);
+    }
+    return cls;
+}
+
+// Whether the coder decides only by format, and the `canDecodeFromData:` probe can be skipped
+static BOOL SDImageCoderDecidesByFormat(id<SDImageCoder> coder) {
+    if (![coder respondsToSelector:@selector(canDecodeFromFormat:)]) {
+        return NO;
+    }
+    Class cls = [coder class];
+    Class formatClass = SDImplementingClassForSelector(cls, @selector(canDecodeFromFormat:));
+    Class dataClass = SDImplementingClassForSelector(cls, @selector(canDecodeFromData:));
+    // The subclass which overrides `canDecodeFromData:` only (such as subclass of `SDImageGIFCoder`) may reject some data of the format, keep the probe
+    return dataClass == formatClass || ![dataClass isSubclassOfClass:formatClass];
+}
+
+// The coder in the format-indexed table, with whether it needs the `canDecodeFromData:` probe
+@interface SDImageDecodingCoderEntry : NSObject
+
+@property (nonatomic, strong, nonnull) id<SDImageCoder> coder;
+@property (nonatomic, assign) BOOL decidesByFormat;
+
+@end
+
+@implementation SDImageDecodingCoderEntry
+@end
 
 @interface SDImageCodersManager ()
 
 @property (nonatomic, strong, nonnull) NSMutableArray<id<SDImageCoder>> *imageCoders;
+// format -> coders which may decode the format, in the priority order. Built lazily for each format, cleared when coders changed
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSNumber *, NSArray<SDImageDecodingCoderEntry *> *> *decodingCodersTable;
+@property (nonatomic, assign) NSUInteger codersVersion;
 
 @end
 
@@ -36,6 +79,7 @@
     if (self = [super init]) {
         // initialize with default coders
         _imageCoders = [NSMutableArray arrayWithArray:@[[SDImageIOCoder sharedCoder], [SDImageGIFCoder sharedCoder], [SDImageAPNGCoder sharedCoder]]];
+        _decodingCodersTable = [NSMutableDictionary dictionary];
         SD_LOCK_INIT(_codersLock);
     }
     return self;
@@ -54,6 +98,7 @@
     if (coders.count) {
         [_imageCoders addObjectsFromArray:coders];
     }
+    [self invalidateDecodingCodersTable];
     SD_UNLOCK(_codersLock);
 }
 
@@ -65,6 +110,7 @@
     }
     SD_LOCK(_codersLock);
     [_imageCoders addObject:coder];
+    [self invalidateDecodingCodersTable];
     SD_UNLOCK(_codersLock);
 }
 
@@ -74,18 +120,64 @@
     }
     SD_LOCK(_codersLock);
     [_imageCoders removeObject:coder];
+    [self invalidateDecodingCodersTable];
     SD_UNLOCK(_codersLock);
 }
 
-#pragma mark - SDImageCoder
-- (BOOL)canDecodeFromData:(NSData *)data {
-    NSArray<id<SDImageCoder>> *coders = self.coders;
+#pragma mark - Decoding dispatch
+
+// Must be called under `_codersLock`
+- (void)invalidateDecodingCodersTable {
+    [_decodingCodersTable removeAllObjects];
+    _codersVersion++;
+}
+
+// The coders which may decode the format, from the highest priority. Coders which does not declare formats are always included, and need the `canDecodeFromData:` probe
+- (NSArray<SDImageDecodingCoderEntry *> *)decodingCodersForFormat:(SDImageFormat)format {
+    NSNumber *formatKey = @(format);
+    SD_LOCK(_codersLock);
+    NSArray<SDImageDecodingCoderEntry *> *decodingCoders = _decodingCodersTable[formatKey];
+    NSArray<id<SDImageCoder>> *coders = decodingCoders ? nil : [_imageCoders copy];
+    NSUInteger codersVersion = _codersVersion;
+    SD_UNLOCK(_codersLock);
+    if (decodingCoders) {
+        return decodingCoders;
+    }
+    // Build outside the lock, the coder may call back into manager
+    NSMutableArray<SDImageDecodingCoderEntry *> *mutableCoders = [NSMutableArray arrayWithCapacity:coders.count];
     for (id<SDImageCoder> coder in coders.reverseObjectEnumerator) {
-        if ([coder canDecodeFromData:data]) {
-            return YES;
+        if (![coder respondsToSelector:@selector(canDecodeFromFormat:)] || [coder canDecodeFromFormat:format]) {
+            // Walk the class hierarchy once here, not on each decode
+            SDImageDecodingCoderEntry *entry = [SDImageDecodingCoderEntry new];
+            entry.coder = coder;
+            entry.decidesByFormat = SDImageCoderDecidesByFormat(coder);
+            [mutableCoders addObject:entry];
         }
     }
-    return NO;
+    decodingCoders = [mutableCoders copy];
+    SD_LOCK(_codersLock);
+    if (codersVersion == _codersVersion) {
+        _decodingCodersTable[formatKey] = decodingCoders;
+    }
+    SD_UNLOCK(_codersLock);
+    return decodingCoders;
+}
+
+// Find the coder from the format-indexed table, only probe the data for coders which does not decide by formats
+- (nullable id<SDImageCoder>)decodingCoderForData:(nullable NSData *)data {
+    SDImageFormat format = [NSData sd_imageFormatForImageData:data];
+    NSArray<SDImageDecodingCoderEntry *> *entries = [self decodingCodersForFormat:format];
+    for (SDImageDecodingCoderEntry *entry in entries) {
+        if (entry.decidesByFormat || [entry.coder canDecodeFromData:data]) {
+            return entry.coder;
+        }
+    }
+    return nil;
+}
+
+#pragma mark - SDImageCoder
+- (BOOL)canDecodeFromData:(NSData *)data {
+    return [self decodingCoderForData:data] != nil;
 }
 
 - (BOOL)canEncodeToFormat:(SDImageFormat)format {
@@ -102,14 +194,8 @@
     if (!data) {
         return nil;
     }
-    UIImage *image;
-    NSArray<id<SDImageCoder>> *coders = self.coders;
-    for (id<SDImageCoder> coder in coders.reverseObjectEnumerator) {
-        if ([coder canDecodeFromData:data]) {
-            image = [coder decodedImageWithData:data options:options];
-            break;
-        }
-    }
+    id<SDImageCoder> coder = [self decodingCoderForData:data];
+    UIImage *image = [coder decodedImageWithData:data options:options];
     
     return image;
 }
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+#import "SDImageCoder.h"
+
+/// The priority of decode work submitted to `SDImageDecodeScheduler`. Higher priority work is admitted first when the budget is exhausted.
+typedef NS_ENUM(NSInteger, SDImageDecodePriority) {
+    /// Work which nobody is waiting for, such as encoding image to store into disk cache
+    SDImageDecodePriorityBackground = -8,
+    /// Work which improves the experience but can be skipped, such as progressive decoding
+    SDImageDecodePriorityLow = -4,
+    /// The default priority, such as decoding the image from disk cache, or decoding animated image frames
+    SDImageDecodePriorityNormal = 0,
+    /// Work for the image which is requested with high priority, such as `SDWebImageDownloaderHighPriority`
+    SDImageDecodePriorityHigh = 4,
+};
+
+/**
+ The global decode scheduler shared by downloader, image cache and animated image frame pool.
+ Each decode/encode work is submitted with the estimated bitmap bytes and priority. The scheduler limits the concurrent work by both CPU slots (`maxConcurrentDecodes`) and the bytes of the in-flight bitmaps (`maxInFlightBytes`), so a burst of images does not oversubscribe CPU and spike memory with lots of full size bitmaps at once.
+ When the budget is exhausted, the synchronous work waits on the calling thread, the asynchronous work is queued without occupying a thread. The pending work is admitted in priority order (FIFO for the same priority), and a waiter is jumped over by higher priority work only a few times, so the low priority work does not starve.
+ @note The work on main thread, or nested inside another admitted work on the same thread, never waits. It is still counted into the budget.
+ @warning Do not perform the work on a serial queue which others `dispatch_sync` onto (such as the IO queue of `SDImageCache`), the waiting blocks all of them. Read the data on that queue, and decode on another queue instead.
+ @note This class is thread-safe.
+ */
+@interface SDImageDecodeScheduler : NSObject
+
+/// The shared scheduler used by the framework.
+@property (nonatomic, class, readonly, nonnull) SDImageDecodeScheduler *sharedScheduler;
+
+/// The max number of concurrent work. Defaults to the active processor count. Pass 0 means no limit.
+@property (nonatomic, assign) NSUInteger maxConcurrentDecodes;
+
+/// The max total estimated bytes of concurrent work. Defaults to 1/16 of the physical memory. Pass 0 means no limit.
+/// @note A single work larger than this limit is still admitted when nothing else is running.
+@property (nonatomic, assign) NSUInteger maxInFlightBytes;
+
+/// The number of running work.
+@property (nonatomic, assign, readonly) NSUInteger runningCount;
+
+/// The total estimated bytes of running work.
+@property (nonatomic, assign, readonly) NSUInteger inFlightBytes;
+
+/// The number of work waiting for the budget.
+@property (nonatomic, assign, readonly) NSUInteger pendingCount;
+
+/// Create a scheduler with the default limits.
+- (nonnull instancetype)init;
+
+/// Create a scheduler with the limits.
+/// @param maxConcurrentDecodes The max number of concurrent work, 0 means no limit.
+/// @param maxInFlightBytes The max total estimated bytes of concurrent work, 0 means no limit.
+- (nonnull instancetype)initWithMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes maxInFlightBytes:(NSUInteger)maxInFlightBytes NS_DESIGNATED_INITIALIZER;
+
+/**
+ Perform the work once the budget allows, the work is executed synchronously on the calling thread.
+
+ @param cost The estimated bitmap bytes of the work, 0 if unknown (only take a CPU slot)
+ @param priority The priority
+ @param block The work to perform
+ */
+- (void)performWithCost:(NSUInteger)cost priority:(SDImageDecodePriority)priority block:(nonnull NS_NOESCAPE dispatch_block_t)block;
+
+/**
+ Perform the work once the budget allows, the work is dispatched asynchronously to the queue after admitted. Prefer this to `performWithCost:priority:block:` when the caller does not need to wait, no thread is parked while waiting for the budget.
+
+ @param cost The estimated bitmap bytes of the work, 0 if unknown (only take a CPU slot)
+ @param priority The priority
+ @param queue The queue to perform the work, nil means the global queue matching the priority
+ @param block The work to perform
+ */
+- (void)performAsyncWithCost:(NSUInteger)cost priority:(SDImageDecodePriority)priority queue:(nullable dispatch_queue_t)queue block:(nonnull dispatch_block_t)block;
+
+/**
+ Whether the current thread is performing the admitted work (inside the `performWithCost:priority:block:`).
+ The work which dispatches the sub-work to other threads and waits for them (such as `dispatch_apply`) should check this before calling, and run the sub-work directly if YES. The sub-work on other threads is not nested, waiting for another slot while the caller holds one may deadlock when all slots are held by such callers.
+
+ @return YES if the current thread is performing the admitted work
+ */
++ (BOOL)isCurrentThreadPerforming;
+
+/**
+ Estimate the decoded bitmap bytes from the image data header, without decoding. The thumbnail pixel size and scale down limit bytes in options are respected.
+
+ @param data The image data
+ @param options The decode options
+ @return The estimated bytes, 0 if the header does not contain the pixel size
+ */
++ (NSUInteger)decodeCostForImageData:(nullable NSData *)data options:(nullable SDImageCoderOptions *)options;
+
+@end
@@ -0,0 +1,300 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDImageDecodeScheduler.h"
+#import "SDImageHeaderParser.h"
+#import "SDInternalMacros.h"
+#import "SDDeviceHelper.h"
+
+// The admitted work depth of current thread, nested work does not wait to avoid deadlock
+static __thread NSUInteger SDImageDecodeSchedulerThreadDepth = 0;
+// The max times a waiter can be jumped over by the higher priority work, so the low priority work does not starve
+static const NSUInteger kSDImageDecodeSchedulerMaxSkipCount = 8;
+
+@interface SDImageDecodeSchedulerWaiter : NSObject
+
+@property (nonatomic, assign) NSUInteger cost;
+@property (nonatomic, assign) SDImageDecodePriority priority;
+@property (nonatomic, assign) NSUInteger skipCount; // the times jumped over by higher priority waiters
+@property (nonatomic, strong, nullable) dispatch_semaphore_t semaphore; // the synchronous waiter
+@property (nonatomic, copy, nullable) dispatch_block_t block; // the asynchronous waiter
+@property (nonatomic, strong, nullable) dispatch_queue_t queue;
+
+@end
+
+@implementation SDImageDecodeSchedulerWaiter
+@end
+
+@interface SDImageDecodeScheduler ()
+
+@property (nonatomic, strong, nonnull) NSMutableArray<SDImageDecodeSchedulerWaiter *> *waiters; // sorted by priority, then FIFO
+
+@end
+
+@implementation SDImageDecodeScheduler {
+    SD_LOCK_DECLARE(_lock);
+    NSUInteger _maxConcurrentDecodes;
+    NSUInteger _maxInFlightBytes;
+    NSUInteger _runningCount;
+    NSUInteger _inFlightBytes;
+}
+
++ (SDImageDecodeScheduler *)sharedScheduler {
+    static dispatch_once_t onceToken;
+    static SDImageDecodeScheduler *scheduler;
+    dispatch_once(&onceToken, ^{
+        scheduler = [[SDImageDecodeScheduler alloc] init];
+    });
+    return scheduler;
+}
+
+- (instancetype)init {
+    return [self initWithMaxConcurrentDecodes:[NSProcessInfo processInfo].activeProcessorCount maxInFlightBytes:[SDDeviceHelper totalMemory] / 16];
+}
+
+- (instancetype)initWithMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes maxInFlightBytes:(NSUInteger)maxInFlightBytes {
+    self = [super init];
+    if (self) {
+        _maxConcurrentDecodes = maxConcurrentDecodes;
+        _maxInFlightBytes = maxInFlightBytes;
+        _waiters = [NSMutableArray array];
+        SD_LOCK_INIT(_lock);
+    }
+    return self;
+}
+
+#pragma mark - Properties
+
+- (NSUInteger)maxConcurrentDecodes {
+    SD_LOCK(_lock);
+    NSUInteger maxConcurrentDecodes = _maxConcurrentDecodes;
+    SD_UNLOCK(_lock);
+    return maxConcurrentDecodes;
+}
+
+- (void)setMaxConcurrentDecodes:(NSUInteger)maxConcurrentDecodes {
+    SD_LOCK(_lock);
+    _maxConcurrentDecodes = maxConcurrentDecodes;
+    // Limit may be raised
+    [self admitWaiters];
+    SD_UNLOCK(_lock);
+}
+
+- (NSUInteger)maxInFlightBytes {
+    SD_LOCK(_lock);
+    NSUInteger maxInFlightBytes = _maxInFlightBytes;
+    SD_UNLOCK(_lock);
+    return maxInFlightBytes;
+}
+
+- (void)setMaxInFlightBytes:(NSUInteger)maxInFlightBytes {
+    SD_LOCK(_lock);
+    _maxInFlightBytes = maxInFlightBytes;
+    // Limit may be raised
+    [self admitWaiters];
+    SD_UNLOCK(_lock);
+}
+
+- (NSUInteger)runningCount {
+    SD_LOCK(_lock);
+    NSUInteger runningCount = _runningCount;
+    SD_UNLOCK(_lock);
+    return runningCount;
+}
+
+- (NSUInteger)inFlightBytes {
+    SD_LOCK(_lock);
+    NSUInteger inFlightBytes = _inFlightBytes;
+    SD_UNLOCK(_lock);
+    return inFlightBytes;
+}
+
+- (NSUInteger)pendingCount {
+    SD_LOCK(_lock);
+    NSUInteger pendingCount = self.waiters.count;
+    SD_UNLOCK(_lock);
+    return pendingCount;
+}
+
+#pragma mark - Perform
+
+- (void)performWithCost:(NSUInteger)cost priority:(SDImageDecodePriority)priority block:(NS_NOESCAPE dispatch_block_t)block {
+    if (!block) {
+        return;
+    }
+    // Never block main thread, and nested work which already hold a slot
+    BOOL shouldWait = SDImageDecodeSchedulerThreadDepth == 0 && ![NSThread isMainThread];
+    SDImageDecodeSchedulerWaiter *waiter;
+    SD_LOCK(_lock);
+    if (!shouldWait || (self.waiters.count == 0 && [self canAdmitCost:cost])) {
+        _runningCount++;
+        _inFlightBytes += cost;
+    } else {
+        waiter = [SDImageDecodeSchedulerWaiter new];
+        waiter.cost = cost;
+        waiter.priority = priority;
+        waiter.semaphore = dispatch_semaphore_create(0);
+        [self enqueueWaiter:waiter];
+    }
+    SD_UNLOCK(_lock);
+
+    if (waiter) {
+        // The slot is taken by `admitWaiters` before signal
+        dispatch_semaphore_wait(waiter.semaphore, DISPATCH_TIME_FOREVER);
+    }
+
+    [self runAdmittedBlock:block cost:cost];
+}
+
+- (void)performAsyncWithCost:(NSUInteger)cost priority:(SDImageDecodePriority)priority queue:(dispatch_queue_t)queue block:(dispatch_block_t)block {
+    if (!block) {
+        return;
+    }
+    if (!queue) {
+        queue = dispatch_get_global_queue([self.class queueQualityOfServiceForPriority:priority], 0);
+    }
+    SDImageDecodeSchedulerWaiter *waiter = [SDImageDecodeSchedulerWaiter new];
+    waiter.cost = cost;
+    waiter.priority = priority;
+    waiter.block = block;
+    waiter.queue = queue;
+    SD_LOCK(_lock);
+    // No thread is parked, the block is dispatched once admitted
+    [self enqueueWaiter:waiter];
+    [self admitWaiters];
+    SD_UNLOCK(_lock);
+}
+
+// Run the admitted block on current thread, and give back the slot
+- (void)runAdmittedBlock:(dispatch_block_t)block cost:(NSUInteger)cost {
+    SDImageDecodeSchedulerThreadDepth++;
+    block();
+    SDImageDecodeSchedulerThreadDepth--;
+
+    SD_LOCK(_lock);
+    _runningCount--;
+    _inFlightBytes -= MIN(cost, _inFlightBytes);
+    [self admitWaiters];
+    SD_UNLOCK(_lock);
+}
+
+#pragma mark - Helper
+
+// Must be called under `_lock`
+- (BOOL)canAdmitCost:(NSUInteger)cost {
+    if (_runningCount == 0) {
+        // Always make progress, even the single work exceed the bytes limit
+        return YES;
+    }
+    if (_maxConcurrentDecodes > 0 && _runningCount >= _maxConcurrentDecodes) {
+        return NO;
+    }
+    if (_maxInFlightBytes > 0 && _inFlightBytes + cost > _maxInFlightBytes) {
+        return NO;
+    }
+    return YES;
+}
+
+// Must be called under `_lock`. Insert after the waiters with the same or higher priority, but never jump over the waiter which has been jumped over too many times
+- (void)enqueueWaiter:(SDImageDecodeSchedulerWaiter *)waiter {
+    NSUInteger index = self.waiters.count;
+    while (index > 0) {
+        SDImageDecodeSchedulerWaiter *previousWaiter = self.waiters[index - 1];
+        if (previousWaiter.priority >= waiter.priority || previousWaiter.skipCount >= kSDImageDecodeSchedulerMaxSkipCount) {
+            break;
+        }
+        index--;
+    }
+    for (NSUInteger i = index; i < self.waiters.count; i++) {
+        self.waiters[i].skipCount++;
+    }
+    [self.waiters insertObject:waiter atIndex:index];
+}
+
+// Must be called under `_lock`. Admit in order, the head waiter blocks the others so the large work does not starve
+- (void)admitWaiters {
+    while (self.waiters.count > 0) {
+        SDImageDecodeSchedulerWaiter *waiter = self.waiters.firstObject;
+        if (![self canAdmitCost:waiter.cost]) {
+            break;
+        }
+        [self.waiters removeObjectAtIndex:0];
+        _runningCount++;
+        _inFlightBytes += waiter.cost;
+        if (waiter.block) {
+            dispatch_block_t block = waiter.block;
+            NSUInteger cost = waiter.cost;
+            dispatch_async(waiter.queue, ^{
+                [self runAdmittedBlock:block cost:cost];
+            });
+        } else {
+            dispatch_semaphore_signal(waiter.semaphore);
+        }
+    }
+}
+
++ (dispatch_qos_class_t)queueQualityOfServiceForPriority:(SDImageDecodePriority)priority {
+    if (priority >= SDImageDecodePriorityHigh) {
+        return QOS_CLASS_USER_INITIATED;
+    } else if (priority >= SDImageDecodePriorityNormal) {
+        return QOS_CLASS_DEFAULT;
+    } else if (priority >= SDImageDecodePriorityLow) {
+        return QOS_CLASS_UTILITY;
+    } else {
+        return QOS_CLASS_BACKGROUND;
+    }
+}
+
++ (BOOL)isCurrentThreadPerforming {
+    return SDImageDecodeSchedulerThreadDepth > 0;
+}
+
++ (NSUInteger)decodeCostForImageData:(NSData *)data options:(SDImageCoderOptions *)options {
+    if (!data) {
+        return 0;
+    }
+    SDImageHeaderInfo info = SDImageHeaderGetInfo(data.bytes, data.length);
+    double pixelCount = (double)info.pixelWidth * info.pixelHeight;
+    if (pixelCount <= 0) {
+        return 0;
+    }
+    CGSize thumbnailSize = CGSizeZero;
+    NSValue *thumbnailSizeValue = options[SDImageCoderDecodeThumbnailPixelSize];
+    if (thumbnailSizeValue != nil) {
+#if SD_MAC
+        thumbnailSize = thumbnailSizeValue.sizeValue;
+#else
+        thumbnailSize = thumbnailSizeValue.CGSizeValue;
+#endif
+    }
+    if (thumbnailSize.width > 0 && thumbnailSize.height > 0) {
+        BOOL preserveAspectRatio = YES;
+        NSNumber *preserveAspectRatioValue = options[SDImageCoderDecodePreserveAspectRatio];
+        if (preserveAspectRatioValue != nil) {
+            preserveAspectRatio = preserveAspectRatioValue.boolValue;
+        }
+        double thumbnailPixelCount;
+        if (preserveAspectRatio) {
+            double ratio = MIN(thumbnailSize.width / info.pixelWidth, thumbnailSize.height / info.pixelHeight);
+            thumbnailPixelCount = pixelCount * ratio * ratio;
+        } else {
+            thumbnailPixelCount = thumbnailSize.width * thumbnailSize.height;
+        }
+        // Thumbnail never scale up
+        pixelCount = MIN(pixelCount, thumbnailPixelCount);
+    }
+    // The decoded bitmap is 4 bytes per pixel (RGBA8888)
+    double bytes = pixelCount * 4;
+    NSUInteger limitBytes = [options[SDImageCoderDecodeScaleDownLimitBytes] unsignedIntegerValue];
+    if (limitBytes > 0) {
+        bytes = MIN(bytes, limitBytes);
+    }
+    return (NSUInteger)MIN(bytes, (double)NSUIntegerMax);
+}
+
+@end
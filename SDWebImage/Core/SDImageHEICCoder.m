@@ -39,7 +39,11 @@ static NSString * kSDCGImagePropertyHEICSUnclampedDelayTime = @"UnclampedDelayTi
 #pragma mark - SDImageCoder
 
 - (BOOL)canDecodeFromData:(nullable NSData *)data {
-    switch ([NSData sd_imageFormatForImageData:data]) {
+    return [self canDecodeFromFormat:[NSData sd_imageFormatForImageData:data]];
+}
+
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format {
+    switch (format) {
         case SDImageFormatHEIC:
             // Check HEIC decoding compatibility
             return [self.class canDecodeFromFormat:SDImageFormatHEIC];
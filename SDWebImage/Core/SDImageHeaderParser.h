@@ -0,0 +1,62 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import <ImageIO/ImageIO.h>
+#import "SDWebImageCompat.h"
+#import "NSData+ImageContentType.h"
+
+/// The hints parsed from the image header. They are hints only, the decoded image is the source of truth.
+typedef NS_OPTIONS(NSUInteger, SDImageHeaderHints) {
+    SDImageHeaderHintNone = 0,
+    /// The image may contain alpha channel (PNG color type or `tRNS`, GIF transparent color, WebP alpha, HEIF alpha auxiliary image, 32-bit BMP)
+    SDImageHeaderHintAlpha = 1 << 0,
+    /// The image contains multiple frames to animate (APNG `acTL`, GIF with multiple frames or the loop extension, animated WebP, HEIF image sequence)
+    SDImageHeaderHintAnimated = 1 << 1,
+    /// The image is progressive JPEG or interlaced PNG/GIF
+    SDImageHeaderHintProgressive = 1 << 2,
+};
+
+/**
+ The image information parsed from the image header, without decoding.
+ */
+typedef struct SDImageHeaderInfo {
+    /// The image format, same as `+[NSData sd_imageFormatForImageData:]`
+    SDImageFormat format;
+    /// The pixel width, 0 if not found in the header
+    NSUInteger pixelWidth;
+    /// The pixel height, 0 if not found in the header
+    NSUInteger pixelHeight;
+    /// The EXIF orientation (JPEG/PNG/TIFF/WebP EXIF, HEIF `irot`), `kCGImagePropertyOrientationUp` if not found
+    CGImagePropertyOrientation orientation;
+    /// The frame count, 0 if not known from the header (such as GIF which need to walk all the frames)
+    NSUInteger frameCount;
+    /// The hints
+    SDImageHeaderHints hints;
+} SDImageHeaderInfo;
+
+/**
+ Detect the image format from the image data bytes. This is the same as `+[NSData sd_imageFormatForImageData:]`, without any allocation.
+ @note SVG is detected by the end tag, so pass the whole data for SVG.
+
+ @param bytes The image data bytes
+ @param length The bytes length
+ @return The image format
+ */
+FOUNDATION_EXPORT SDImageFormat SDImageHeaderGetFormat(const void * _Nullable bytes, size_t length);
+
+/**
+ Parse the image header (JPEG SOF and EXIF, PNG IHDR/acTL, GIF Logical Screen Descriptor, WebP VP8/VP8L/VP8X, HEIF ispe/irot, TIFF IFD0, BMP info header), without any allocation or decoding.
+ The parser only reads the given bytes, so you can pass the first few KB of the downloading data. Any field not found in the bytes is left as default, pass more bytes when the pixel size is 0 (for example, large JPEG EXIF segment before SOF).
+ @note This function is thread-safe and accepts any malformed input.
+
+ @param bytes The image data bytes, the whole data or just the prefix
+ @param length The bytes length
+ @return The image header info
+ */
+FOUNDATION_EXPORT SDImageHeaderInfo SDImageHeaderGetInfo(const void * _Nullable bytes, size_t length);
@@ -0,0 +1,613 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDImageHeaderParser.h"
+
+// Whether `count` bytes from `offset` are available, without overflow
+#define SD_HAS_BYTES(offset, count, length) ((offset) <= (length) && (count) <= (length) - (offset))
+
+// HEIF boxes nest shallowly, limit the depth for malformed input
+#define SD_HEIF_MAX_BOX_DEPTH 4
+
+static inline uint16_t SDReadBE16(const uint8_t *p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static inline uint32_t SDReadBE32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static inline uint16_t SDReadLE16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t SDReadLE24(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16);
+}
+
+static inline uint32_t SDReadLE32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline BOOL SDBytesEqual(const uint8_t *p, const char *string, size_t count) {
+    return memcmp(p, string, count) == 0;
+}
+
+#pragma mark - Format
+
+SDImageFormat SDImageHeaderGetFormat(const void *bytes, size_t length) {
+    if (!bytes || length == 0) {
+        return SDImageFormatUndefined;
+    }
+    const uint8_t *p = bytes;
+    // File signatures table: http://www.garykessler.net/library/file_sigs.html
+    switch (p[0]) {
+        case 0xFF:
+            return SDImageFormatJPEG;
+        case 0x89:
+            return SDImageFormatPNG;
+        case 0x47:
+            return SDImageFormatGIF;
+        case 0x49:
+        case 0x4D:
+            return SDImageFormatTIFF;
+        case 0x42:
+            return SDImageFormatBMP;
+        case 0x52: {
+            //RIFF....WEBP
+            if (length >= 12 && SDBytesEqual(p, "RIFF", 4) && SDBytesEqual(p + 8, "WEBP", 4)) {
+                return SDImageFormatWebP;
+            }
+            break;
+        }
+        case 0x00: {
+            if (length >= 12 && SDBytesEqual(p + 4, "ftyp", 4)) {
+                const uint8_t *brand = p + 8;
+                //....ftypheic ....ftypheix ....ftyphevc ....ftyphevx
+                if (SDBytesEqual(brand, "heic", 4) || SDBytesEqual(brand, "heix", 4) || SDBytesEqual(brand, "hevc", 4) || SDBytesEqual(brand, "hevx", 4)) {
+                    return SDImageFormatHEIC;
+                }
+                //....ftypmif1 ....ftypmsf1
+                if (SDBytesEqual(brand, "mif1", 4) || SDBytesEqual(brand, "msf1", 4)) {
+                    return SDImageFormatHEIF;
+                }
+            }
+            break;
+        }
+        case 0x25: {
+            //%PDF
+            if (length >= 4 && SDBytesEqual(p + 1, "PDF", 3)) {
+                return SDImageFormatPDF;
+            }
+            break;
+        }
+        case 0x3C: {
+            // Check end with SVG tag in the last 100 bytes
+            static const char kSVGTagEnd[] = "</svg>";
+            size_t tagLength = sizeof(kSVGTagEnd) - 1;
+            size_t searchLength = MIN(100, length);
+            if (searchLength < tagLength) {
+                break;
+            }
+            for (size_t offset = length - tagLength; offset + searchLength >= length; offset--) {
+                if (SDBytesEqual(p + offset, kSVGTagEnd, tagLength)) {
+                    return SDImageFormatSVG;
+                }
+                if (offset == 0) {
+                    break;
+                }
+            }
+            break;
+        }
+    }
+    return SDImageFormatUndefined;
+}
+
+#pragma mark - TIFF
+
+// Parse the TIFF IFD0, which is also the EXIF payload in JPEG/PNG/WebP
+static void SDImageHeaderParseTIFF(const uint8_t *p, size_t length, BOOL parseSize, SDImageHeaderInfo *info) {
+    if (length < 8) {
+        return;
+    }
+    BOOL bigEndian;
+    if (SDBytesEqual(p, "MM", 2)) {
+        bigEndian = YES;
+    } else if (SDBytesEqual(p, "II", 2)) {
+        bigEndian = NO;
+    } else {
+        return;
+    }
+#define SD_TIFF_READ16(q) (bigEndian ? SDReadBE16(q) : SDReadLE16(q))
+#define SD_TIFF_READ32(q) (bigEndian ? SDReadBE32(q) : SDReadLE32(q))
+    if (SD_TIFF_READ16(p + 2) != 42) {
+        return;
+    }
+    size_t ifdOffset = SD_TIFF_READ32(p + 4);
+    if (!SD_HAS_BYTES(ifdOffset, 2, length)) {
+        return;
+    }
+    size_t entryCount = SD_TIFF_READ16(p + ifdOffset);
+    for (size_t i = 0; i < entryCount; i++) {
+        size_t entryOffset = ifdOffset + 2 + i * 12;
+        if (!SD_HAS_BYTES(entryOffset, 12, length)) {
+            break;
+        }
+        const uint8_t *entry = p + entryOffset;
+        uint16_t tag = SD_TIFF_READ16(entry);
+        uint16_t type = SD_TIFF_READ16(entry + 2);
+        uint32_t value;
+        if (type == 3) {
+            // SHORT
+            value = SD_TIFF_READ16(entry + 8);
+        } else if (type == 4) {
+            // LONG
+            value = SD_TIFF_READ32(entry + 8);
+        } else {
+            continue;
+        }
+        if (tag == 0x0112) {
+            // Orientation
+            if (value >= 1 && value <= 8) {
+                info->orientation = (CGImagePropertyOrientation)value;
+            }
+        } else if (parseSize && tag == 0x0100) {
+            // ImageWidth
+            info->pixelWidth = value;
+        } else if (parseSize && tag == 0x0101) {
+            // ImageLength
+            info->pixelHeight = value;
+        }
+    }
+#undef SD_TIFF_READ16
+#undef SD_TIFF_READ32
+}
+
+#pragma mark - JPEG
+
+static void SDImageHeaderParseJPEG(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    if (length < 2 || p[1] != 0xD8) {
+        return;
+    }
+    size_t offset = 2;
+    while (SD_HAS_BYTES(offset, 2, length)) {
+        if (p[offset] != 0xFF) {
+            // Corrupted
+            return;
+        }
+        uint8_t marker = p[offset + 1];
+        if (marker == 0xFF) {
+            // Fill byte
+            offset++;
+            continue;
+        }
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            // Standalone marker without length
+            offset += 2;
+            continue;
+        }
+        if (marker == 0xD9 || marker == 0xDA) {
+            // EOI or SOS, no SOF found
+            return;
+        }
+        if (!SD_HAS_BYTES(offset, 4, length)) {
+            return;
+        }
+        size_t segmentLength = SDReadBE16(p + offset + 2);
+        if (segmentLength < 2) {
+            return;
+        }
+        size_t payloadOffset = offset + 4;
+        size_t segmentEnd = offset + 2 + segmentLength;
+        size_t payloadLength = MIN(segmentEnd, length) - payloadOffset;
+        if (marker == 0xE1 && payloadLength >= 6 && SDBytesEqual(p + payloadOffset, "Exif\0\0", 6)) {
+            // APP1 EXIF
+            SDImageHeaderParseTIFF(p + payloadOffset + 6, payloadLength - 6, NO, info);
+        } else if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // SOFn, except DHT, JPG and DAC
+            if (payloadLength < 5) {
+                return;
+            }
+            info->pixelHeight = SDReadBE16(p + payloadOffset + 1);
+            info->pixelWidth = SDReadBE16(p + payloadOffset + 3);
+            info->frameCount = 1;
+            if (marker == 0xC2 || marker == 0xC6 || marker == 0xCA || marker == 0xCE) {
+                info->hints |= SDImageHeaderHintProgressive;
+            }
+            // EXIF always comes before SOF
+            return;
+        }
+        offset = segmentEnd;
+    }
+}
+
+#pragma mark - PNG
+
+static void SDImageHeaderParsePNG(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    static const uint8_t kPNGSignature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+    if (length < 29 || memcmp(p, kPNGSignature, 8) != 0 || !SDBytesEqual(p + 12, "IHDR", 4)) {
+        return;
+    }
+    info->pixelWidth = SDReadBE32(p + 16);
+    info->pixelHeight = SDReadBE32(p + 20);
+    info->frameCount = 1;
+    uint8_t colorType = p[25];
+    if (colorType & 0x04) {
+        // Gray or RGB with alpha
+        info->hints |= SDImageHeaderHintAlpha;
+    }
+    if (p[28] == 1) {
+        // Adam7 interlace
+        info->hints |= SDImageHeaderHintProgressive;
+    }
+    // Walk the chunks before image data
+    size_t offset = 8;
+    while (SD_HAS_BYTES(offset, 8, length)) {
+        size_t chunkLength = SDReadBE32(p + offset);
+        const uint8_t *type = p + offset + 4;
+        size_t dataOffset = offset + 8;
+        size_t dataLength = MIN(chunkLength, length - dataOffset);
+        if (SDBytesEqual(type, "IDAT", 4)) {
+            break;
+        } else if (SDBytesEqual(type, "acTL", 4)) {
+            if (dataLength >= 4) {
+                uint32_t frameCount = SDReadBE32(p + dataOffset);
+                info->frameCount = frameCount;
+                if (frameCount > 1) {
+                    info->hints |= SDImageHeaderHintAnimated;
+                }
+            }
+        } else if (SDBytesEqual(type, "tRNS", 4)) {
+            info->hints |= SDImageHeaderHintAlpha;
+        } else if (SDBytesEqual(type, "eXIf", 4)) {
+            SDImageHeaderParseTIFF(p + dataOffset, dataLength, NO, info);
+        }
+        // Length, type, data and CRC
+        if (!SD_HAS_BYTES(dataOffset, chunkLength, SIZE_MAX - 4)) {
+            break;
+        }
+        offset = dataOffset + chunkLength + 4;
+    }
+}
+
+#pragma mark - GIF
+
+// Skip the data sub-blocks, return the offset after the block terminator, or 0 if incomplete
+static size_t SDImageHeaderSkipGIFSubBlocks(const uint8_t *p, size_t length, size_t offset) {
+    while (offset < length) {
+        size_t blockSize = p[offset];
+        offset += 1 + blockSize;
+        if (blockSize == 0) {
+            return offset;
+        }
+    }
+    return 0;
+}
+
+static void SDImageHeaderParseGIF(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    if (length < 13 || !(SDBytesEqual(p, "GIF87a", 6) || SDBytesEqual(p, "GIF89a", 6))) {
+        return;
+    }
+    // Logical Screen Descriptor
+    info->pixelWidth = SDReadLE16(p + 6);
+    info->pixelHeight = SDReadLE16(p + 8);
+    uint8_t flags = p[10];
+    size_t offset = 13;
+    if (flags & 0x80) {
+        // Global Color Table
+        offset += 3 * ((size_t)1 << ((flags & 0x07) + 1));
+    }
+    // Walk the blocks to count frames, this does not touch the image data, only the sub-block sizes
+    NSUInteger frameCount = 0;
+    while (offset < length) {
+        uint8_t introducer = p[offset];
+        if (introducer == 0x21) {
+            // Extension
+            if (!SD_HAS_BYTES(offset, 2, length)) {
+                break;
+            }
+            uint8_t label = p[offset + 1];
+            if (label == 0xF9 && SD_HAS_BYTES(offset, 4, length) && (p[offset + 3] & 0x01)) {
+                // Graphic Control Extension with transparent color
+                info->hints |= SDImageHeaderHintAlpha;
+            } else if (label == 0xFF && SD_HAS_BYTES(offset, 14, length) && p[offset + 2] == 11 && SDBytesEqual(p + offset + 3, "NETSCAPE2.0", 11)) {
+                // Loop extension
+                info->hints |= SDImageHeaderHintAnimated;
+            }
+            offset = SDImageHeaderSkipGIFSubBlocks(p, length, offset + 2);
+        } else if (introducer == 0x2C) {
+            // Image Descriptor
+            if (!SD_HAS_BYTES(offset, 10, length)) {
+                break;
+            }
+            uint8_t imageFlags = p[offset + 9];
+            if (frameCount == 0 && (imageFlags & 0x40)) {
+                info->hints |= SDImageHeaderHintProgressive;
+            }
+            frameCount++;
+            offset += 10;
+            if (imageFlags & 0x80) {
+                // Local Color Table
+                offset += 3 * ((size_t)1 << ((imageFlags & 0x07) + 1));
+            }
+            // LZW minimum code size, then image data
+            offset = SDImageHeaderSkipGIFSubBlocks(p, length, offset + 1);
+        } else if (introducer == 0x3B) {
+            // Trailer, the frame count is complete
+            info->frameCount = frameCount;
+            break;
+        } else {
+            // Corrupted
+            break;
+        }
+        if (offset == 0) {
+            // Incomplete
+            break;
+        }
+    }
+    if (frameCount > 1) {
+        info->hints |= SDImageHeaderHintAnimated;
+    }
+}
+
+#pragma mark - WebP
+
+static void SDImageHeaderParseWebP(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    if (length < 20) {
+        return;
+    }
+    const uint8_t *type = p + 12;
+    if (SDBytesEqual(type, "VP8 ", 4)) {
+        // Lossy, frame tag then start code
+        if (length < 30 || p[23] != 0x9D || p[24] != 0x01 || p[25] != 0x2A) {
+            return;
+        }
+        info->pixelWidth = SDReadLE16(p + 26) & 0x3FFF;
+        info->pixelHeight = SDReadLE16(p + 28) & 0x3FFF;
+        info->frameCount = 1;
+    } else if (SDBytesEqual(type, "VP8L", 4)) {
+        // Lossless, signature then 14 bits width - 1, 14 bits height - 1, 1 bit alpha
+        if (length < 25 || p[20] != 0x2F) {
+            return;
+        }
+        uint32_t bits = SDReadLE32(p + 21);
+        info->pixelWidth = (bits & 0x3FFF) + 1;
+        info->pixelHeight = ((bits >> 14) & 0x3FFF) + 1;
+        info->frameCount = 1;
+        if ((bits >> 28) & 0x01) {
+            info->hints |= SDImageHeaderHintAlpha;
+        }
+    } else if (SDBytesEqual(type, "VP8X", 4)) {
+        // Extended, flags then 24 bits canvas width - 1, 24 bits canvas height - 1
+        if (length < 30) {
+            return;
+        }
+        uint8_t flags = p[20];
+        info->pixelWidth = SDReadLE24(p + 24) + 1;
+        info->pixelHeight = SDReadLE24(p + 27) + 1;
+        if (flags & 0x10) {
+            info->hints |= SDImageHeaderHintAlpha;
+        }
+        BOOL animated = (flags & 0x02) != 0;
+        BOOL hasEXIF = (flags & 0x08) != 0;
+        if (animated) {
+            info->hints |= SDImageHeaderHintAnimated;
+        } else {
+            info->frameCount = 1;
+        }
+        if (!animated && !hasEXIF) {
+            return;
+        }
+        // Walk the chunks to count frames and find EXIF, which is placed after the image data
+        size_t riffEnd = (size_t)SDReadLE32(p + 4) + 8;
+        size_t offset = 12;
+        NSUInteger frameCount = 0;
+        while (SD_HAS_BYTES(offset, 8, length)) {
+            const uint8_t *chunkType = p + offset;
+            size_t chunkLength = SDReadLE32(p + offset + 4);
+            size_t dataOffset = offset + 8;
+            if (SDBytesEqual(chunkType, "ANMF", 4)) {
+                frameCount++;
+            } else if (SDBytesEqual(chunkType, "EXIF", 4)) {
+                size_t dataLength = MIN(chunkLength, length - dataOffset);
+                const uint8_t *exif = p + dataOffset;
+                // Some encoders keep the JPEG APP1 header
+                if (dataLength >= 6 && SDBytesEqual(exif, "Exif\0\0", 6)) {
+                    exif += 6;
+                    dataLength -= 6;
+                }
+                SDImageHeaderParseTIFF(exif, dataLength, NO, info);
+            }
+            // Chunk is padded to even size
+            if (!SD_HAS_BYTES(dataOffset, chunkLength + (chunkLength & 1), SIZE_MAX)) {
+                break;
+            }
+            offset = dataOffset + chunkLength + (chunkLength & 1);
+        }
+        if (animated && offset >= riffEnd && offset <= length) {
+            // Reach the end, the frame count is complete
+            info->frameCount = frameCount;
+        }
+    }
+}
+
+#pragma mark - HEIF
+
+// Read the box header at offset, return NO if not available
+static BOOL SDImageHeaderReadHEIFBox(const uint8_t *p, size_t end, size_t offset, const uint8_t **type, size_t *payloadOffset, size_t *boxEnd) {
+    if (!SD_HAS_BYTES(offset, 8, end)) {
+        return NO;
+    }
+    uint64_t boxSize = SDReadBE32(p + offset);
+    size_t headerSize = 8;
+    if (boxSize == 1) {
+        // 64 bits large size
+        if (!SD_HAS_BYTES(offset, 16, end)) {
+            return NO;
+        }
+        boxSize = ((uint64_t)SDReadBE32(p + offset + 8) << 32) | SDReadBE32(p + offset + 12);
+        headerSize = 16;
+    } else if (boxSize == 0) {
+        // Extends to the end
+        boxSize = end - offset;
+    }
+    if (boxSize < headerSize) {
+        return NO;
+    }
+    *type = p + offset + 4;
+    *payloadOffset = offset + headerSize;
+    // The box may be truncated, children are parsed until the available end
+    *boxEnd = boxSize > end - offset ? end : offset + (size_t)boxSize;
+    return YES;
+}
+
+static void SDImageHeaderParseHEIFBoxes(const uint8_t *p, size_t start, size_t end, NSUInteger depth, SDImageHeaderInfo *info, BOOL *foundRotation) {
+    if (depth > SD_HEIF_MAX_BOX_DEPTH) {
+        return;
+    }
+    size_t offset = start;
+    const uint8_t *type;
+    size_t payloadOffset;
+    size_t boxEnd;
+    while (SDImageHeaderReadHEIFBox(p, end, offset, &type, &payloadOffset, &boxEnd)) {
+        size_t payloadLength = boxEnd - payloadOffset;
+        if (SDBytesEqual(type, "ftyp", 4)) {
+            // Major brand, minor version, then compatible brands
+            for (size_t brandOffset = payloadOffset; brandOffset + 4 <= boxEnd; brandOffset += 4) {
+                if (brandOffset == payloadOffset + 4) {
+                    continue;
+                }
+                if (SDBytesEqual(p + brandOffset, "msf1", 4) || SDBytesEqual(p + brandOffset, "hevs", 4)) {
+                    // Image sequence
+                    info->hints |= SDImageHeaderHintAnimated;
+                }
+            }
+        } else if (SDBytesEqual(type, "meta", 4)) {
+            // Full box with version and flags
+            if (payloadLength >= 4) {
+                SDImageHeaderParseHEIFBoxes(p, payloadOffset + 4, boxEnd, depth + 1, info, foundRotation);
+            }
+            // The image properties are all in meta, no need to walk the media data
+            return;
+        } else if (SDBytesEqual(type, "iprp", 4) || SDBytesEqual(type, "ipco", 4)) {
+            SDImageHeaderParseHEIFBoxes(p, payloadOffset, boxEnd, depth + 1, info, foundRotation);
+        } else if (SDBytesEqual(type, "ispe", 4)) {
+            // Full box, then 32 bits width and height. The grid tiles and thumbnails are smaller than the primary image, use the largest one
+            if (payloadLength >= 12) {
+                NSUInteger width = SDReadBE32(p + payloadOffset + 4);
+                NSUInteger height = SDReadBE32(p + payloadOffset + 8);
+                if ((uint64_t)width * height > (uint64_t)info->pixelWidth * info->pixelHeight) {
+                    info->pixelWidth = width;
+                    info->pixelHeight = height;
+                }
+            }
+        } else if (SDBytesEqual(type, "irot", 4)) {
+            // Anti-clockwise rotation in 90 degrees, use the first one
+            if (payloadLength >= 1 && !*foundRotation) {
+                static const CGImagePropertyOrientation kRotationOrientations[4] = {kCGImagePropertyOrientationUp, kCGImagePropertyOrientationLeft, kCGImagePropertyOrientationDown, kCGImagePropertyOrientationRight};
+                info->orientation = kRotationOrientations[p[payloadOffset] & 0x03];
+                *foundRotation = YES;
+            }
+        } else if (SDBytesEqual(type, "auxC", 4)) {
+            // Full box, then auxiliary type URN
+            static const char kHEVCAlphaURN[] = "urn:mpeg:hevc:2015:auxid:1";
+            static const char kMPEGAlphaURN[] = "urn:mpeg:mpegB:cicp:systems:auxiliary:alpha";
+            if (payloadLength >= 4) {
+                const uint8_t *urn = p + payloadOffset + 4;
+                size_t urnLength = payloadLength - 4;
+                if ((urnLength >= sizeof(kHEVCAlphaURN) - 1 && SDBytesEqual(urn, kHEVCAlphaURN, sizeof(kHEVCAlphaURN) - 1))
+                    || (urnLength >= sizeof(kMPEGAlphaURN) - 1 && SDBytesEqual(urn, kMPEGAlphaURN, sizeof(kMPEGAlphaURN) - 1))) {
+                    info->hints |= SDImageHeaderHintAlpha;
+                }
+            }
+        }
+        if (boxEnd <= offset) {
+            break;
+        }
+        offset = boxEnd;
+    }
+}
+
+static void SDImageHeaderParseHEIF(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    BOOL foundRotation = NO;
+    SDImageHeaderParseHEIFBoxes(p, 0, length, 0, info, &foundRotation);
+    if (!(info->hints & SDImageHeaderHintAnimated) && info->pixelWidth > 0) {
+        info->frameCount = 1;
+    }
+}
+
+#pragma mark - BMP
+
+static void SDImageHeaderParseBMP(const uint8_t *p, size_t length, SDImageHeaderInfo *info) {
+    if (length < 26 || !SDBytesEqual(p, "BM", 2)) {
+        return;
+    }
+    uint32_t headerSize = SDReadLE32(p + 14);
+    uint16_t bitCount;
+    if (headerSize == 12) {
+        // BITMAPCOREHEADER, 16 bits size
+        info->pixelWidth = SDReadLE16(p + 18);
+        info->pixelHeight = SDReadLE16(p + 20);
+        bitCount = SDReadLE16(p + 24);
+    } else {
+        // BITMAPINFOHEADER and later, signed 32 bits size, negative height means top-down
+        if (length < 30) {
+            return;
+        }
+        int32_t width = (int32_t)SDReadLE32(p + 18);
+        int32_t height = (int32_t)SDReadLE32(p + 22);
+        info->pixelWidth = width > 0 ? (NSUInteger)width : 0;
+        info->pixelHeight = height == INT32_MIN ? 0 : (NSUInteger)ABS(height);
+        bitCount = SDReadLE16(p + 28);
+    }
+    info->frameCount = 1;
+    if (bitCount == 32) {
+        info->hints |= SDImageHeaderHintAlpha;
+    }
+}
+
+#pragma mark - Info
+
+SDImageHeaderInfo SDImageHeaderGetInfo(const void *bytes, size_t length) {
+    SDImageHeaderInfo info = {
+        .format = SDImageHeaderGetFormat(bytes, length),
+        .pixelWidth = 0,
+        .pixelHeight = 0,
+        .orientation = kCGImagePropertyOrientationUp,
+        .frameCount = 0,
+        .hints = SDImageHeaderHintNone,
+    };
+    const uint8_t *p = bytes;
+    switch (info.format) {
+        case SDImageFormatJPEG:
+            SDImageHeaderParseJPEG(p, length, &info);
+            break;
+        case SDImageFormatPNG:
+            SDImageHeaderParsePNG(p, length, &info);
+            break;
+        case SDImageFormatGIF:
+            SDImageHeaderParseGIF(p, length, &info);
+            break;
+        case SDImageFormatTIFF:
+            SDImageHeaderParseTIFF(p, length, YES, &info);
+            break;
+        case SDImageFormatWebP:
+            SDImageHeaderParseWebP(p, length, &info);
+            break;
+        case SDImageFormatHEIC:
+        case SDImageFormatHEIF:
+            SDImageHeaderParseHEIF(p, length, &info);
+            break;
+        case SDImageFormatBMP:
+            SDImageHeaderParseBMP(p, length, &info);
+            break;
+        default:
+            break;
+    }
+    return info;
+}
@@ -260,26 +260,17 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
     return isBuggy;
 }
 
-@interface SDImageIOCoderFrame : NSObject
-
-@property (nonatomic, assign) NSUInteger index; // Frame index (zero based)
-@property (nonatomic, assign) NSTimeInterval duration; // Frame duration in seconds
-
-@end
-
-@implementation SDImageIOCoderFrame
-@end
-
 @implementation SDImageIOAnimatedCoder {
     size_t _width, _height;
     CGImageSourceRef _imageSource;
     BOOL _incremental;
-    SD_LOCK_DECLARE(_lock); // Lock only apply for incremental animation decoding
+    SD_LOCK_DECLARE(_lock); // Lock for incremental animation decoding, and the lazy frame duration scanning
     NSData *_imageData;
     CGFloat _scale;
     NSUInteger _loopCount;
     NSUInteger _frameCount;
-    NSArray<SDImageIOCoderFrame *> *_frames;
+    NSTimeInterval *_frameDurations; // Frame durations in seconds, scanned lazily, 0 means not scanned yet
+    NSUInteger _frameDurationsCapacity; // The allocated count of `_frameDurations`, grow geometrically for incremental decoding
     BOOL _finished;
     BOOL _preserveAspectRatio;
     CGSize _thumbnailSize;
@@ -306,6 +297,10 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
         CFRelease(_imageSource);
         _imageSource = NULL;
     }
+    if (_frameDurations) {
+        free(_frameDurations);
+        _frameDurations = NULL;
+    }
 #if SD_UIKIT
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 #endif
@@ -878,7 +873,7 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
         imageUTType = self.class.animatedImageUTType;
     }
     
-    // Create an image destination. Animated Image does not support EXIF image orientation TODO
+    // Create an image destination. Animated Image does not support EXIF image orientation, the frames are normalized to up orientation
     // The `CGImageDestinationCreateWithData` will log a warning when count is 0, use 1 instead.
     CGImageDestinationRef imageDestination = CGImageDestinationCreateWithData((__bridge CFMutableDataRef)imageData, (__bridge CFStringRef)imageUTType, frames.count ?: 1, NULL);
     if (!imageDestination) {
@@ -965,13 +960,54 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
         };
         // container level properties (applies for `CGImageDestinationSetProperties`, not individual frames)
         CGImageDestinationSetProperties(imageDestination, (__bridge CFDictionaryRef)containerProperties);
+        // The prepared frames are normalized to up orientation, the remaining orientation is written per frame
+        properties[(__bridge NSString *)kCGImagePropertyOrientation] = nil;
         
-        for (size_t i = 0; i < frames.count; i++) {
-            SDImageFrame *frame = frames[i];
-            NSTimeInterval frameDuration = frame.duration;
-            CGImageRef frameImageRef = frame.image.CGImage;
-            properties[self.class.dictionaryProperty] = @{self.class.delayTimeProperty : @(frameDuration)};
-            CGImageDestinationAddImage(imageDestination, frameImageRef, (__bridge CFDictionaryRef)properties);
+        SDImageCoderEncodeProgressBlock progressBlock = options[SDImageCoderEncodeProgress];
+        BOOL stop = NO;
+        // Prepare the frames concurrently, only the append is serial (in order). Process in batches to bound the memory of prepared frames
+        NSUInteger frameCount = frames.count;
+        NSUInteger batchSize = MAX([NSProcessInfo processInfo].activeProcessorCount, 1) * 2;
+        for (NSUInteger batchStart = 0; batchStart < frameCount && !stop; batchStart += batchSize) {
+            NSUInteger batchCount = MIN(batchSize, frameCount - batchStart);
+            CGImageRef *preparedImageRefs = calloc(batchCount, sizeof(CGImageRef));
+            CGImagePropertyOrientation *preparedOrientations = calloc(batchCount, sizeof(CGImagePropertyOrientation));
+            if (!preparedImageRefs || !preparedOrientations) {
+                free(preparedImageRefs);
+                free(preparedOrientations);
+                stop = YES;
+                break;
+            }
+            dispatch_apply(batchCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t i) {
+                @autoreleasepool {
+                    preparedImageRefs[i] = [self.class CGImageCreatePreparedForEncoding:frames[batchStart + i].image maxPixelSize:finalPixelSize orientation:&preparedOrientations[i]];
+                }
+            });
+            for (size_t i = 0; i < batchCount; i++) {
+                CGImageRef frameImageRef = preparedImageRefs[i];
+                if (!stop) {
+                    SDImageFrame *frame = frames[batchStart + i];
+                    NSTimeInterval frameDuration = frame.duration;
+                    properties[self.class.dictionaryProperty] = @{self.class.delayTimeProperty : @(frameDuration)};
+                    // Frames which can not be normalized (HDR, or decode failed) keep their orientation
+                    CGImagePropertyOrientation frameOrientation = frameImageRef ? preparedOrientations[i] : [self.class exifOrientationForImage:frame.image];
+                    properties[(__bridge NSString *)kCGImagePropertyOrientation] = frameOrientation != kCGImagePropertyOrientationUp ? @(frameOrientation) : nil;
+                    CGImageDestinationAddImage(imageDestination, frameImageRef ?: frame.image.CGImage, (__bridge CFDictionaryRef)properties);
+                    if (progressBlock) {
+                        progressBlock(batchStart + i + 1, frameCount, &stop);
+                    }
+                }
+                if (frameImageRef) {
+                    CGImageRelease(frameImageRef);
+                }
+            }
+            free(preparedImageRefs);
+            free(preparedOrientations);
+        }
+        if (stop) {
+            // Cancelled
+            CFRelease(imageDestination);
+            return nil;
         }
     }
     // Finalize the destination.
@@ -990,6 +1026,52 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
     return [imageData copy];
 }
 
++ (CGImagePropertyOrientation)exifOrientationForImage:(UIImage *)image {
+#if SD_UIKIT || SD_WATCH
+    return [SDImageCoderHelper exifOrientationFromImageOrientation:image.imageOrientation];
+#else
+    return kCGImagePropertyOrientationUp;
+#endif
+}
+
+// Prepare the animated frame for encoding, this can be called concurrently: decode the lazy image, convert to RGB color space, normalize the orientation, and scale down to the max pixel size. Return the retained original CGImage if nothing to do
+// The `orientation` is the EXIF orientation the returned image still needs: up if normalized, the image's own orientation if not (HDR frame, or decode failed)
++ (CGImageRef)CGImageCreatePreparedForEncoding:(UIImage *)image maxPixelSize:(CGFloat)maxPixelSize orientation:(CGImagePropertyOrientation *)orientation CF_RETURNS_RETAINED {
+    CGImageRef imageRef = image.CGImage;
+    CGImagePropertyOrientation imageOrientation = [self exifOrientationForImage:image];
+    *orientation = imageOrientation;
+    if (!imageRef) {
+        return NULL;
+    }
+    if ([SDImageCoderHelper CGImageIsHDR:imageRef]) {
+        // Keep the HDR pixels, let ImageIO process, the orientation is written as property
+        return CGImageRetain(imageRef);
+    }
+    CGColorSpaceModel colorSpaceModel = CGColorSpaceGetModel(CGImageGetColorSpace(imageRef));
+    BOOL shouldDecode = imageOrientation != kCGImagePropertyOrientationUp || colorSpaceModel != kCGColorSpaceModelRGB || [SDImageCoderHelper CGImageIsLazy:imageRef];
+    CGImageRef preparedImageRef = NULL;
+    if (shouldDecode) {
+        preparedImageRef = [SDImageCoderHelper CGImageCreateDecoded:imageRef orientation:imageOrientation];
+    }
+    if (preparedImageRef) {
+        *orientation = kCGImagePropertyOrientationUp;
+    } else {
+        preparedImageRef = CGImageRetain(imageRef);
+    }
+    CGFloat pixelWidth = CGImageGetWidth(preparedImageRef);
+    CGFloat pixelHeight = CGImageGetHeight(preparedImageRef);
+    if (maxPixelSize > 0 && MAX(pixelWidth, pixelHeight) > maxPixelSize) {
+        CGFloat ratio = maxPixelSize / MAX(pixelWidth, pixelHeight);
+        CGSize scaledSize = CGSizeMake(MAX(round(pixelWidth * ratio), 1), MAX(round(pixelHeight * ratio), 1));
+        CGImageRef scaledImageRef = [SDImageCoderHelper CGImageCreateScaled:preparedImageRef size:scaledSize];
+        if (scaledImageRef) {
+            CGImageRelease(preparedImageRef);
+            preparedImageRef = scaledImageRef;
+        }
+    }
+    return preparedImageRef;
+}
+
 #pragma mark - SDAnimatedImageCoder
 - (nullable instancetype)initWithAnimatedImageData:(nullable NSData *)data options:(nullable SDImageCoderOptions *)options {
     if (!data) {
@@ -1058,6 +1140,7 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
         
         _imageSource = imageSource;
         _imageData = data;
+        SD_LOCK_INIT(_lock);
 #if SD_UIKIT
         [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(didReceiveMemoryWarning:) name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 #endif
@@ -1073,24 +1156,62 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
     NSUInteger loopCount = [self.class imageLoopCountWithSource:imageSource];
     _loopCount = loopCount;
     
-    NSMutableArray<SDImageIOCoderFrame *> *frames = [NSMutableArray arrayWithCapacity:frameCount];
-    for (size_t i = 0; i < frameCount; i++) {
-        SDImageIOCoderFrame *frame = [[SDImageIOCoderFrame alloc] init];
-        frame.index = i;
-        frame.duration = [self.class frameDurationAtIndex:i source:imageSource];
-        [frames addObject:frame];
-    }
-    if (frames.count != frameCount) {
-        // frames not match, do not override current value
-        return NO;
+    // For incremental decoding, append the newly available frames only, and keep the existing entries, which keep the progressive loading linear
+    if (_incremental && _frameDurations && frameCount >= _frameCount) {
+        if (frameCount > _frameDurationsCapacity) {
+            NSUInteger capacity = MAX(frameCount, _frameDurationsCapacity * 2);
+            NSTimeInterval *frameDurations = realloc(_frameDurations, capacity * sizeof(NSTimeInterval));
+            if (!frameDurations) {
+                // frames not match, do not override current value
+                return NO;
+            }
+            _frameDurations = frameDurations;
+            _frameDurationsCapacity = capacity;
+        }
+        if (frameCount > _frameCount) {
+            memset(_frameDurations + _frameCount, 0, (frameCount - _frameCount) * sizeof(NSTimeInterval));
+        }
+        // The previous last frame may be not fully received when it was scanned, rescan it lazily. The other frames are finalized
+        if (_frameCount > 0) {
+            _frameDurations[_frameCount - 1] = 0;
+        }
+        _frameCount = frameCount;
+        return YES;
     }
     
+    // Only allocate the frame table, reading the frame properties for each frame is expensive for long animation (hundreds of frames), which is done lazily in `animatedImageDurationAtIndex:`
+    NSTimeInterval *frameDurations = NULL;
+    if (frameCount > 0) {
+        frameDurations = calloc(frameCount, sizeof(NSTimeInterval));
+        if (!frameDurations) {
+            // frames not match, do not override current value
+            return NO;
+        }
+        // The first frame is always needed for display
+        frameDurations[0] = [self.class frameDurationAtIndex:0 source:imageSource];
+    }
+    
+    if (_frameDurations) {
+        free(_frameDurations);
+    }
     _frameCount = frameCount;
-    _frames = [frames copy];
+    _frameDurations = frameDurations;
+    _frameDurationsCapacity = frameCount;
     
     return YES;
 }
 
+// Must be called inside the lock
+- (NSTimeInterval)safeAnimatedImageDurationAtIndex:(NSUInteger)index {
+    NSTimeInterval duration = _frameDurations[index];
+    if (duration == 0) {
+        // Not scanned yet, only block for this frame
+        duration = [self.class frameDurationAtIndex:index source:_imageSource];
+        _frameDurations[index] = duration;
+    }
+    return duration;
+}
+
 - (NSData *)animatedImageData {
     return _imageData;
 }
@@ -1107,20 +1228,14 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
     NSTimeInterval duration;
     // Incremental Animation decoding may update frames when new bytes available
     // Which should use lock to ensure frame count and frames match, ensure atomic logic
-    if (_incremental) {
-        SD_LOCK(_lock);
-        if (index >= _frames.count) {
-            SD_UNLOCK(_lock);
-            return 0;
-        }
-        duration = _frames[index].duration;
+    // The frame duration is scanned lazily, which also use lock
+    SD_LOCK(_lock);
+    if (index >= _frameCount) {
         SD_UNLOCK(_lock);
-    } else {
-        if (index >= _frames.count) {
-            return 0;
-        }
-        duration = _frames[index].duration;
+        return 0;
     }
+    duration = [self safeAnimatedImageDurationAtIndex:index];
+    SD_UNLOCK(_lock);
     return duration;
 }
 
@@ -1130,14 +1245,14 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
     // Which should use lock to ensure frame count and frames match, ensure atomic logic
     if (_incremental) {
         SD_LOCK(_lock);
-        if (index >= _frames.count) {
+        if (index >= _frameCount) {
             SD_UNLOCK(_lock);
             return nil;
         }
         image = [self safeAnimatedImageFrameAtIndex:index];
         SD_UNLOCK(_lock);
     } else {
-        if (index >= _frames.count) {
+        if (index >= _frameCount) {
             return nil;
         }
         image = [self safeAnimatedImageFrameAtIndex:index];
@@ -1146,7 +1261,24 @@ static BOOL SDImageIOPNGPluginBuggyNeedWorkaround(void) {
 }
 
 - (UIImage *)safeAnimatedImageFrameAtIndex:(NSUInteger)index {
-    UIImage *image = [self.class createFrameAtIndex:index source:_imageSource scale:_scale preserveAspectRatio:_preserveAspectRatio thumbnailSize:_thumbnailSize lazyDecode:_lazyDecode animatedImage:YES decodeToHDR:!_incremental || _finished ? _decodeToHDR : NO];
+    return [self animatedImageFrameAtIndex:index imageSource:_imageSource];
+}
+
+#pragma mark - Parallel Decoding
+
+- (CGImageSourceRef)createParallelImageSource {
+    // The incremental image source is updated with the new bytes, which can not be shared
+    if (_incremental || !_imageData) {
+        return NULL;
+    }
+    return CGImageSourceCreateWithData((__bridge CFDataRef)_imageData, NULL);
+}
+
+- (UIImage *)animatedImageFrameAtIndex:(NSUInteger)index imageSource:(CGImageSourceRef)imageSource {
+    if (!imageSource) {
+        return nil;
+    }
+    UIImage *image = [self.class createFrameAtIndex:index source:imageSource scale:_scale preserveAspectRatio:_preserveAspectRatio thumbnailSize:_thumbnailSize lazyDecode:_lazyDecode animatedImage:YES decodeToHDR:!_incremental || _finished ? _decodeToHDR : NO];
     if (!image) {
         return nil;
     }
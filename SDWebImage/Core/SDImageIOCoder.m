@@ -141,6 +141,11 @@ static NSString * kSDCGImageDestinationEncodeToISOGainmap = @"kCGImageDestinatio
     return YES;
 }
 
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format {
+    // The fallback coder, try all formats the same as `canDecodeFromData:`
+    return YES;
+}
+
 - (UIImage *)decodedImageWithData:(NSData *)data options:(nullable SDImageCoderOptions *)options {
     if (!data) {
         return nil;
@@ -63,6 +63,13 @@ FOUNDATION_EXPORT id<SDProgressiveImageCoder> _Nullable SDImageLoaderGetProgress
  */
 FOUNDATION_EXPORT void SDImageLoaderSetProgressiveCoder(id<SDWebImageOperation> _Nonnull operation, id<SDProgressiveImageCoder> _Nullable progressiveCoder);
 
+/**
+ This function get the HTTP cache validators (`ETag` and `Last-Modified` header fields) from the response. Which can be bind to the image using `sd_cacheValidators` and stored alongside the image in disk cache.
+ @param response The URL response from the network.
+ @return The validators keyed by header field name, or nil if the response is not HTTP or contains no validator.
+ */
+FOUNDATION_EXPORT NSDictionary<NSString *, NSString *> * _Nullable SDImageLoaderGetCacheValidators(NSURLResponse * _Nullable response);
+
 #pragma mark - SDImageLoader
 
 /**
@@ -30,6 +30,30 @@ void SDImageLoaderSetProgressiveCoder(id<SDWebImageOperation> operation, id<SDPr
     objc_setAssociatedObject(operation, SDImageLoaderProgressiveCoderKey, progressiveCoder, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
+NSDictionary<NSString *, NSString *> * _Nullable SDImageLoaderGetCacheValidators(NSURLResponse * _Nullable response) {
+    if (![response isKindOfClass:NSHTTPURLResponse.class]) {
+        return nil;
+    }
+    NSDictionary *headerFields = ((NSHTTPURLResponse *)response).allHeaderFields;
+    NSMutableDictionary<NSString *, NSString *> *validators = [NSMutableDictionary dictionary];
+    // Header field name is case-insensitive
+    for (NSString *field in headerFields) {
+        if (![field isKindOfClass:NSString.class]) {
+            continue;
+        }
+        NSString *value = headerFields[field];
+        if (![value isKindOfClass:NSString.class] || value.length == 0) {
+            continue;
+        }
+        if ([field caseInsensitiveCompare:@"ETag"] == NSOrderedSame) {
+            validators[@"ETag"] = value;
+        } else if ([field caseInsensitiveCompare:@"Last-Modified"] == NSOrderedSame) {
+            validators[@"Last-Modified"] = value;
+        }
+    }
+    return validators.count > 0 ? [validators copy] : nil;
+}
+
 UIImage * _Nullable SDImageLoaderDecodeImageData(NSData * _Nonnull imageData, NSURL * _Nonnull imageURL, SDWebImageOptions options, SDWebImageContext * _Nullable context) {
     NSCParameterAssert(imageData);
     NSCParameterAssert(imageURL);
@@ -0,0 +1,54 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+/**
+ The variant table used by `SDWebImageManager` to record which thumbnail pixel sizes are cached for each original cache key.
+ The thumbnail cache key from `SDThumbnailedKeyForKey` is exact, so a request for 200x200 thumbnail misses even when the 400x400 one is cached. With this table, the manager can find the nearest larger variant, and downscale it instead of decoding the full size image, or downloading again.
+ The table is a hint only, the variant may be evicted from the image cache at any time. The table is bounded by `countLimit`, the least recently used key is evicted first.
+ @note This class is thread-safe.
+ */
+@interface SDImageThumbnailVariantTable : NSObject
+
+/// The maximum number of original cache keys in the table. Defaults to 1000. Pass 0 means no limit.
+@property (nonatomic, assign) NSUInteger countLimit;
+
+/// The number of original cache keys in the table.
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/// Record the thumbnail variant is cached.
+/// @param pixelSize The thumbnail pixel size used to generate the thumbnail cache key, see `SDThumbnailedKeyForKey`
+/// @param preserveAspectRatio Whether the thumbnail preserve aspect ratio
+/// @param key The original cache key, without thumbnail or transformer
+- (void)addVariantWithPixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio forKey:(nonnull NSString *)key;
+
+/// Remove the thumbnail variant, such as when it's no longer in the image cache.
+- (void)removeVariantWithPixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio forKey:(nonnull NSString *)key;
+
+/// All the recorded thumbnail pixel sizes for the original cache key, in no particular order.
+- (nonnull NSArray<NSValue *> *)variantPixelSizesForKey:(nonnull NSString *)key preserveAspectRatio:(BOOL)preserveAspectRatio;
+
+/**
+ Find the smallest recorded variant which can be downscaled to the requested thumbnail, which means both width and height are not less than the requested pixel size. The variant exactly equal to the requested pixel size is ignored, because that's the cache key which already missed.
+
+ @param key The original cache key
+ @param pixelSize The requested thumbnail pixel size
+ @param preserveAspectRatio Whether the requested thumbnail preserve aspect ratio, only the variant with the same value matches
+ @return The variant thumbnail pixel size, or `CGSizeZero` if not found
+ */
+- (CGSize)nearestVariantPixelSizeForKey:(nonnull NSString *)key pixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio;
+
+/// Remove all the variants for the original cache key.
+- (void)removeVariantsForKey:(nonnull NSString *)key;
+
+/// Remove all the variants.
+- (void)removeAllVariants;
+
+@end
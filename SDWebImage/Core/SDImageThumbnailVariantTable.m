@@ -0,0 +1,206 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDImageThumbnailVariantTable.h"
+#import "SDInternalMacros.h"
+
+static inline NSValue * SDThumbnailVariantValue(CGSize pixelSize) {
+#if SD_MAC
+    return [NSValue valueWithSize:pixelSize];
+#else
+    return [NSValue valueWithCGSize:pixelSize];
+#endif
+}
+
+static inline CGSize SDThumbnailVariantSize(NSValue *value) {
+#if SD_MAC
+    return value.sizeValue;
+#else
+    return value.CGSizeValue;
+#endif
+}
+
+@interface SDImageThumbnailVariantEntry : NSObject
+
+@property (nonatomic, strong, nonnull) NSMutableSet<NSValue *> *aspectFitSizes; // preserveAspectRatio = YES
+@property (nonatomic, strong, nonnull) NSMutableSet<NSValue *> *stretchSizes; // preserveAspectRatio = NO
+
+@end
+
+@implementation SDImageThumbnailVariantEntry
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _aspectFitSizes = [NSMutableSet set];
+        _stretchSizes = [NSMutableSet set];
+    }
+    return self;
+}
+
+- (NSMutableSet<NSValue *> *)sizesWithPreserveAspectRatio:(BOOL)preserveAspectRatio {
+    return preserveAspectRatio ? self.aspectFitSizes : self.stretchSizes;
+}
+
+- (BOOL)isEmpty {
+    return self.aspectFitSizes.count == 0 && self.stretchSizes.count == 0;
+}
+
+@end
+
+@interface SDImageThumbnailVariantTable ()
+
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSString *, SDImageThumbnailVariantEntry *> *entries;
+@property (nonatomic, strong, nonnull) NSMutableOrderedSet<NSString *> *LRUKeys; // least recently used first
+
+@end
+
+@implementation SDImageThumbnailVariantTable {
+    SD_LOCK_DECLARE(_entriesLock);
+}
+
+- (instancetype)init {
+    self = [super init];
+    if (self) {
+        _countLimit = 1000;
+        _entries = [NSMutableDictionary dictionary];
+        _LRUKeys = [NSMutableOrderedSet orderedSet];
+        SD_LOCK_INIT(_entriesLock);
+    }
+    return self;
+}
+
+#pragma mark - Query
+
+- (NSUInteger)count {
+    SD_LOCK(_entriesLock);
+    NSUInteger count = self.entries.count;
+    SD_UNLOCK(_entriesLock);
+    return count;
+}
+
+- (NSArray<NSValue *> *)variantPixelSizesForKey:(NSString *)key preserveAspectRatio:(BOOL)preserveAspectRatio {
+    if (!key) {
+        return @[];
+    }
+    SD_LOCK(_entriesLock);
+    NSArray<NSValue *> *sizes = [[self.entries[key] sizesWithPreserveAspectRatio:preserveAspectRatio] allObjects];
+    SD_UNLOCK(_entriesLock);
+    return sizes ?: @[];
+}
+
+- (CGSize)nearestVariantPixelSizeForKey:(NSString *)key pixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio {
+    if (!key || !(pixelSize.width > 0 && pixelSize.height > 0)) {
+        return CGSizeZero;
+    }
+    CGSize nearestSize = CGSizeZero;
+    CGFloat nearestArea = CGFLOAT_MAX;
+    SD_LOCK(_entriesLock);
+    SDImageThumbnailVariantEntry *entry = self.entries[key];
+    if (entry) {
+        [self touchKey:key];
+        for (NSValue *value in [entry sizesWithPreserveAspectRatio:preserveAspectRatio]) {
+            CGSize size = SDThumbnailVariantSize(value);
+            if (size.width < pixelSize.width || size.height < pixelSize.height) {
+                // Can not scale up
+                continue;
+            }
+            if (CGSizeEqualToSize(size, pixelSize)) {
+                // The exact key, already missed
+                continue;
+            }
+            CGFloat area = size.width * size.height;
+            if (area < nearestArea) {
+                nearestArea = area;
+                nearestSize = size;
+            }
+        }
+    }
+    SD_UNLOCK(_entriesLock);
+    return nearestSize;
+}
+
+#pragma mark - Update
+
+- (void)addVariantWithPixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio forKey:(NSString *)key {
+    if (!key || !(pixelSize.width > 0 && pixelSize.height > 0)) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    SDImageThumbnailVariantEntry *entry = self.entries[key];
+    if (!entry) {
+        entry = [SDImageThumbnailVariantEntry new];
+        self.entries[key] = entry;
+    }
+    [[entry sizesWithPreserveAspectRatio:preserveAspectRatio] addObject:SDThumbnailVariantValue(pixelSize)];
+    [self touchKey:key];
+    [self trimToCountLimit];
+    SD_UNLOCK(_entriesLock);
+}
+
+- (void)removeVariantWithPixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio forKey:(NSString *)key {
+    if (!key) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    SDImageThumbnailVariantEntry *entry = self.entries[key];
+    if (entry) {
+        [[entry sizesWithPreserveAspectRatio:preserveAspectRatio] removeObject:SDThumbnailVariantValue(pixelSize)];
+        if ([entry isEmpty]) {
+            [self.entries removeObjectForKey:key];
+            [self.LRUKeys removeObject:key];
+        }
+    }
+    SD_UNLOCK(_entriesLock);
+}
+
+- (void)removeVariantsForKey:(NSString *)key {
+    if (!key) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    [self.entries removeObjectForKey:key];
+    [self.LRUKeys removeObject:key];
+    SD_UNLOCK(_entriesLock);
+}
+
+- (void)removeAllVariants {
+    SD_LOCK(_entriesLock);
+    [self.entries removeAllObjects];
+    [self.LRUKeys removeAllObjects];
+    SD_UNLOCK(_entriesLock);
+}
+
+- (void)setCountLimit:(NSUInteger)countLimit {
+    SD_LOCK(_entriesLock);
+    _countLimit = countLimit;
+    [self trimToCountLimit];
+    SD_UNLOCK(_entriesLock);
+}
+
+#pragma mark - Helper
+
+// Must be called under `_entriesLock`
+- (void)touchKey:(NSString *)key {
+    [self.LRUKeys removeObject:key];
+    [self.LRUKeys addObject:key];
+}
+
+// Must be called under `_entriesLock`
+- (void)trimToCountLimit {
+    if (_countLimit == 0) {
+        return;
+    }
+    while (self.LRUKeys.count > _countLimit) {
+        NSString *key = self.LRUKeys.firstObject;
+        [self.LRUKeys removeObjectAtIndex:0];
+        [self.entries removeObjectForKey:key];
+    }
+}
+
+@end
@@ -0,0 +1,79 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import <ImageIO/ImageIO.h>
+#import "SDWebImageCompat.h"
+
+/**
+ The tile source to decode arbitrary rectangles of a very large image (such as 100 megapixels map or scan) at a chosen level of detail, without decoding the whole image into memory. It's designed to be used from a tiled layer like `CATiledLayer`, which draws the visible tiles on demand from multiple threads.
+ Level of detail 0 is the full resolution, and each level halves the width and height. Each level is backed by a lazy `CGImage` created with `CGImageSource` subsampling (`kCGImageSourceSubsampleFactor` up to 8, then the ImageIO thumbnail for the coarser levels), and the tile is decoded by drawing only the requested rectangle into a small bitmap, the same tiling approach as `+[SDImageCoderHelper decodedAndScaledDownImageWithImage:limitBytes:]`.
+ The decoded tiles are kept in a per-source tile cache, bounded by `totalCostLimit`, and the tile decoding shares the global budget of `SDImageDecodeScheduler`.
+ @note The tile rectangle is in the level's pixel coordinate, with origin at top-left, and the EXIF orientation is not applied. Use `orientation` to transform the drawing if needed.
+ @note This class is thread-safe.
+ */
+@interface SDImageTileSource : NSObject
+
+/// The full resolution pixel size (level of detail 0), without EXIF orientation applied.
+@property (nonatomic, assign, readonly) CGSize pixelSize;
+
+/// The EXIF orientation of the image.
+@property (nonatomic, assign, readonly) CGImagePropertyOrientation orientation;
+
+/// The tile pixel size used by `tileImageAtColumn:row:levelOfDetail:`. Defaults to 256x256.
+@property (nonatomic, assign) CGSize tileSize;
+
+/// The max level of detail, which is the first level that the whole image fits in one tile.
+@property (nonatomic, assign, readonly) NSUInteger maxLevelOfDetail;
+
+/// The max total bytes of the decoded tiles in the tile cache. Defaults to 1/32 of the physical memory. Pass 0 means no limit (still purged under memory pressure).
+@property (nonatomic, assign) NSUInteger totalCostLimit;
+
+/// Create the tile source with the image data. Only the first frame is used for animated image.
+/// @param data The image data
+/// @return The tile source, or nil if the data can not be decoded by ImageIO
+- (nullable instancetype)initWithData:(nonnull NSData *)data;
+
+/// Create the tile source with the image file. The file is read on demand by ImageIO, not loaded into memory at once.
+/// @param path The image file path
+/// @return The tile source, or nil if the file can not be decoded by ImageIO
+- (nullable instancetype)initWithContentsOfFile:(nonnull NSString *)path;
+
+- (nonnull instancetype)init NS_UNAVAILABLE;
++ (nonnull instancetype)new  NS_UNAVAILABLE;
+
+/// The pixel size of the level of detail, which is the full resolution pixel size divided by `2^levelOfDetail` and rounded up.
+- (CGSize)pixelSizeForLevelOfDetail:(NSUInteger)levelOfDetail;
+
+/// The level of detail for the drawing scale (such as the current context transform scale of tiled layer), which is the coarsest level whose pixel density is still enough for the scale. The result is clamped to `maxLevelOfDetail`.
+/// @param scale The drawing scale, 1 means full resolution
+- (NSUInteger)levelOfDetailForScale:(CGFloat)scale;
+
+/**
+ Decode the rectangle of the level of detail. The result is cached, so the same rectangle (such as the grid tile from tiled layer) returns immediately.
+
+ @param rect The rectangle in the level's pixel coordinate. It's rounded to integral and clipped to the level bounds.
+ @param levelOfDetail The level of detail, must not be greater than `maxLevelOfDetail`
+ @return The decoded tile image with scale 1, or nil if the rectangle is empty or decoding failed
+ */
+- (nullable UIImage *)tileImageForRect:(CGRect)rect levelOfDetail:(NSUInteger)levelOfDetail;
+
+/**
+ Decode the grid tile of the level of detail, with the `tileSize`. The tiles on the right and bottom edge may be smaller.
+
+ @param column The column index
+ @param row The row index
+ @param levelOfDetail The level of detail, must not be greater than `maxLevelOfDetail`
+ @return The decoded tile image with scale 1, or nil if the tile is out of bounds or decoding failed
+ */
+- (nullable UIImage *)tileImageAtColumn:(NSUInteger)column row:(NSUInteger)row levelOfDetail:(NSUInteger)levelOfDetail;
+
+/// Remove all the decoded tiles and level images from memory.
+- (void)removeAllTiles;
+
+@end
@@ -0,0 +1,274 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDImageTileSource.h"
+#import "SDImageCoderHelper.h"
+#import "SDImageDecodeScheduler.h"
+#import "NSImage+Compatibility.h"
+#import "SDInternalMacros.h"
+#import "SDDeviceHelper.h"
+
+static const size_t kTileBytesPerPixel = 4;
+static const size_t kTileBitsPerComponent = 8;
+// The max subsample factor supported by `kCGImageSourceSubsampleFactor`, the coarser levels use ImageIO thumbnail
+static const NSUInteger kMaxSubsampleFactor = 8;
+
+@interface SDImageTileSource ()
+
+@property (nonatomic, strong, nonnull) NSCache<NSString *, UIImage *> *tileCache;
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSNumber *, id> *levelImages; // CGImageRef
+
+@end
+
+@implementation SDImageTileSource {
+    CGImageSourceRef _source;
+    SD_LOCK_DECLARE(_lock);
+}
+
+- (instancetype)initWithData:(NSData *)data {
+    if (!data) {
+        return nil;
+    }
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    return [self initWithImageSource:source];
+}
+
+- (instancetype)initWithContentsOfFile:(NSString *)path {
+    if (!path) {
+        return nil;
+    }
+    CGImageSourceRef source = CGImageSourceCreateWithURL((__bridge CFURLRef)[NSURL fileURLWithPath:path], NULL);
+    return [self initWithImageSource:source];
+}
+
+// Take the ownership of source
+- (instancetype)initWithImageSource:(CGImageSourceRef)source {
+    if (!source) {
+        return nil;
+    }
+    if (CGImageSourceGetCount(source) == 0) {
+        CFRelease(source);
+        return nil;
+    }
+    NSDictionary *properties = (__bridge_transfer NSDictionary *)CGImageSourceCopyPropertiesAtIndex(source, 0, NULL);
+    CGFloat pixelWidth = [properties[(__bridge NSString *)kCGImagePropertyPixelWidth] doubleValue];
+    CGFloat pixelHeight = [properties[(__bridge NSString *)kCGImagePropertyPixelHeight] doubleValue];
+    if (pixelWidth <= 0 || pixelHeight <= 0) {
+        CFRelease(source);
+        return nil;
+    }
+    self = [super init];
+    if (self) {
+        _source = source;
+        _pixelSize = CGSizeMake(pixelWidth, pixelHeight);
+        _orientation = kCGImagePropertyOrientationUp;
+        NSNumber *exifOrientationValue = properties[(__bridge NSString *)kCGImagePropertyOrientation];
+        if (exifOrientationValue != nil) {
+            _orientation = [exifOrientationValue unsignedIntValue];
+        }
+        _tileSize = CGSizeMake(256, 256);
+        _tileCache = [[NSCache alloc] init];
+        _tileCache.name = @"com.hackemist.SDImageTileSource.tileCache";
+        _tileCache.totalCostLimit = [SDDeviceHelper totalMemory] / 32;
+        _levelImages = [NSMutableDictionary dictionary];
+        SD_LOCK_INIT(_lock);
+    } else {
+        CFRelease(source);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    if (_source) {
+        CFRelease(_source);
+        _source = NULL;
+    }
+}
+
+#pragma mark - Properties
+
+- (CGSize)tileSize {
+    SD_LOCK(_lock);
+    CGSize tileSize = _tileSize;
+    SD_UNLOCK(_lock);
+    return tileSize;
+}
+
+- (void)setTileSize:(CGSize)tileSize {
+    SD_LOCK(_lock);
+    _tileSize = CGSizeMake(MAX(1, floor(tileSize.width)), MAX(1, floor(tileSize.height)));
+    SD_UNLOCK(_lock);
+}
+
+- (NSUInteger)totalCostLimit {
+    return self.tileCache.totalCostLimit;
+}
+
+- (void)setTotalCostLimit:(NSUInteger)totalCostLimit {
+    self.tileCache.totalCostLimit = totalCostLimit;
+}
+
+- (NSUInteger)maxLevelOfDetail {
+    CGSize tileSize = self.tileSize;
+    NSUInteger levelOfDetail = 0;
+    CGSize levelSize = self.pixelSize;
+    while (levelSize.width > tileSize.width || levelSize.height > tileSize.height) {
+        levelOfDetail++;
+        levelSize = [self pixelSizeForLevelOfDetail:levelOfDetail];
+    }
+    return levelOfDetail;
+}
+
+#pragma mark - Level of Detail
+
+- (CGSize)pixelSizeForLevelOfDetail:(NSUInteger)levelOfDetail {
+    CGFloat factor = exp2((double)levelOfDetail);
+    return CGSizeMake(MAX(1, ceil(self.pixelSize.width / factor)), MAX(1, ceil(self.pixelSize.height / factor)));
+}
+
+- (NSUInteger)levelOfDetailForScale:(CGFloat)scale {
+    NSUInteger maxLevelOfDetail = self.maxLevelOfDetail;
+    if (!(scale > 0)) {
+        return maxLevelOfDetail;
+    }
+    if (scale >= 1) {
+        return 0;
+    }
+    NSUInteger levelOfDetail = (NSUInteger)floor(log2(1 / scale));
+    return MIN(levelOfDetail, maxLevelOfDetail);
+}
+
+// The lazy image of the level, the pixel size may not exactly match the level (such as the format does not support subsampling)
+- (id)levelImageForLevelOfDetail:(NSUInteger)levelOfDetail {
+    SD_LOCK(_lock);
+    id levelImage = self.levelImages[@(levelOfDetail)];
+    SD_UNLOCK(_lock);
+    if (levelImage) {
+        return levelImage;
+    }
+    CGImageRef imageRef;
+    NSUInteger factor = (NSUInteger)1 << MIN(levelOfDetail, 31);
+    if (factor <= kMaxSubsampleFactor) {
+        NSMutableDictionary *options = [NSMutableDictionary dictionary];
+        // Keep lazy, only the drawn rectangle is decoded each time
+        options[(__bridge NSString *)kCGImageSourceShouldCache] = @(NO);
+        if (factor > 1) {
+            options[(__bridge NSString *)kCGImageSourceSubsampleFactor] = @(factor);
+        }
+        imageRef = CGImageSourceCreateImageAtIndex(_source, 0, (__bridge CFDictionaryRef)options);
+    } else {
+        // The coarse level is small enough to decode at once
+        CGSize levelSize = [self pixelSizeForLevelOfDetail:levelOfDetail];
+        NSDictionary *options = @{
+            (__bridge NSString *)kCGImageSourceCreateThumbnailFromImageAlways : @(YES),
+            (__bridge NSString *)kCGImageSourceCreateThumbnailWithTransform : @(NO),
+            (__bridge NSString *)kCGImageSourceThumbnailMaxPixelSize : @(MAX(levelSize.width, levelSize.height)),
+            (__bridge NSString *)kCGImageSourceShouldCacheImmediately : @(YES),
+        };
+        imageRef = CGImageSourceCreateThumbnailAtIndex(_source, 0, (__bridge CFDictionaryRef)options);
+    }
+    if (!imageRef) {
+        return nil;
+    }
+    levelImage = (__bridge_transfer id)imageRef;
+    SD_LOCK(_lock);
+    // Another thread may create at the same time, keep the first one
+    id existingLevelImage = self.levelImages[@(levelOfDetail)];
+    if (existingLevelImage) {
+        levelImage = existingLevelImage;
+    } else {
+        self.levelImages[@(levelOfDetail)] = levelImage;
+    }
+    SD_UNLOCK(_lock);
+    return levelImage;
+}
+
+#pragma mark - Tile
+
+- (UIImage *)tileImageAtColumn:(NSUInteger)column row:(NSUInteger)row levelOfDetail:(NSUInteger)levelOfDetail {
+    CGSize tileSize = self.tileSize;
+    CGRect rect = CGRectMake(column * tileSize.width, row * tileSize.height, tileSize.width, tileSize.height);
+    return [self tileImageForRect:rect levelOfDetail:levelOfDetail];
+}
+
+- (UIImage *)tileImageForRect:(CGRect)rect levelOfDetail:(NSUInteger)levelOfDetail {
+    if (levelOfDetail > self.maxLevelOfDetail) {
+        return nil;
+    }
+    CGSize levelSize = [self pixelSizeForLevelOfDetail:levelOfDetail];
+    rect = CGRectIntersection(CGRectIntegral(rect), CGRectMake(0, 0, levelSize.width, levelSize.height));
+    if (CGRectIsEmpty(rect)) {
+        return nil;
+    }
+    NSString *key = [NSString stringWithFormat:@"%lu-%.0f-%.0f-%.0f-%.0f", (unsigned long)levelOfDetail, rect.origin.x, rect.origin.y, rect.size.width, rect.size.height];
+    UIImage *tileImage = [self.tileCache objectForKey:key];
+    if (tileImage) {
+        return tileImage;
+    }
+    id levelImage = [self levelImageForLevelOfDetail:levelOfDetail];
+    if (!levelImage) {
+        return nil;
+    }
+    CGImageRef levelImageRef = (__bridge CGImageRef)levelImage;
+    size_t width = rect.size.width;
+    size_t height = rect.size.height;
+    NSUInteger cost = width * height * kTileBytesPerPixel;
+    __block CGImageRef tileImageRef = NULL;
+    [SDImageDecodeScheduler.sharedScheduler performWithCost:cost priority:SDImageDecodePriorityNormal block:^{
+        @autoreleasepool {
+            tileImageRef = [self createTileImageWithLevelImage:levelImageRef levelSize:levelSize rect:rect];
+        }
+    }];
+    if (!tileImageRef) {
+        return nil;
+    }
+#if SD_MAC
+    tileImage = [[UIImage alloc] initWithCGImage:tileImageRef scale:1 orientation:kCGImagePropertyOrientationUp];
+#else
+    tileImage = [[UIImage alloc] initWithCGImage:tileImageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(tileImageRef);
+    [self.tileCache setObject:tileImage forKey:key cost:cost];
+    return tileImage;
+}
+
+- (CGImageRef)createTileImageWithLevelImage:(CGImageRef)levelImageRef levelSize:(CGSize)levelSize rect:(CGRect)rect CF_RETURNS_RETAINED {
+    // Map to the level image, which may be larger than the level size when the subsampling is not supported
+    CGFloat scaleX = CGImageGetWidth(levelImageRef) / levelSize.width;
+    CGFloat scaleY = CGImageGetHeight(levelImageRef) / levelSize.height;
+    CGRect sourceRect = CGRectIntegral(CGRectMake(rect.origin.x * scaleX, rect.origin.y * scaleY, rect.size.width * scaleX, rect.size.height * scaleY));
+    // Only the rectangle of the lazy image is decoded when drawing, see `decodedAndScaledDownImageWithImage:limitBytes:`
+    CGImageRef sourceTileImageRef = CGImageCreateWithImageInRect(levelImageRef, sourceRect);
+    if (!sourceTileImageRef) {
+        return NULL;
+    }
+    size_t width = rect.size.width;
+    size_t height = rect.size.height;
+    BOOL hasAlpha = [SDImageCoderHelper CGImageContainsAlpha:sourceTileImageRef];
+    CGBitmapInfo bitmapInfo = [SDImageCoderHelper preferredPixelFormat:hasAlpha].bitmapInfo;
+    CGContextRef context = CGBitmapContextCreate(NULL, width, height, kTileBitsPerComponent, 0, [SDImageCoderHelper colorSpaceGetDeviceRGB], bitmapInfo);
+    if (!context) {
+        CGImageRelease(sourceTileImageRef);
+        return NULL;
+    }
+    CGContextSetInterpolationQuality(context, kCGInterpolationHigh);
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), sourceTileImageRef);
+    CGImageRelease(sourceTileImageRef);
+    CGImageRef tileImageRef = CGBitmapContextCreateImage(context);
+    CGContextRelease(context);
+    return tileImageRef;
+}
+
+- (void)removeAllTiles {
+    [self.tileCache removeAllObjects];
+    SD_LOCK(_lock);
+    [self.levelImages removeAllObjects];
+    SD_UNLOCK(_lock);
+}
+
+@end
@@ -28,6 +28,14 @@ FOUNDATION_EXPORT NSString * _Nullable SDTransformedKeyForKey(NSString * _Nullab
  */
 FOUNDATION_EXPORT NSString * _Nullable SDThumbnailedKeyForKey(NSString * _Nullable key, CGSize thumbnailPixelSize, BOOL preserveAspectRatio);
 
+/**
+ Return the bucketed thumbnail pixel size, each dimension is rounded up to the nearest bucket (32, 48, 64, 96, 128, 192, 256, ..., which is power of 2 and 1.5x of it).
+ This is used to keep the thumbnailed cache keys few and reusable, the nearby sizes share the same thumbnail, at most 1.5x larger than the requested one.
+ @param thumbnailPixelSize The thumbnail pixel size
+ @return The bucketed thumbnail pixel size, or `CGSizeZero` if any dimension is not positive
+ */
+FOUNDATION_EXPORT CGSize SDBucketedThumbnailPixelSize(CGSize thumbnailPixelSize);
+
 /**
  A transformer protocol to transform the image load from cache or from download.
  You can provide transformer to cache and manager (Through the `transformer` property or context option `SDWebImageContextImageTransformer`).
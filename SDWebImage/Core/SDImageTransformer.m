@@ -44,6 +44,26 @@ NSString * _Nullable SDThumbnailedKeyForKey(NSString * _Nullable key, CGSize thu
     return SDTransformedKeyForKey(key, thumbnailKey);
 }
 
+static CGFloat SDBucketedThumbnailPixelLength(CGFloat length) {
+    // Buckets: 32, 48, 64, 96, 128, 192, 256...
+    CGFloat bucket = 32;
+    while (bucket < length) {
+        CGFloat halfStep = bucket * 1.5;
+        if (halfStep >= length) {
+            return halfStep;
+        }
+        bucket *= 2;
+    }
+    return bucket;
+}
+
+CGSize SDBucketedThumbnailPixelSize(CGSize thumbnailPixelSize) {
+    if (!(thumbnailPixelSize.width > 0 && thumbnailPixelSize.height > 0) || isinf(thumbnailPixelSize.width) || isinf(thumbnailPixelSize.height)) {
+        return CGSizeZero;
+    }
+    return CGSizeMake(SDBucketedThumbnailPixelLength(thumbnailPixelSize.width), SDBucketedThumbnailPixelLength(thumbnailPixelSize.height));
+}
+
 @interface SDImagePipelineTransformer ()
 
 @property (nonatomic, copy, readwrite, nonnull) NSArray<id<SDImageTransformer>> *transformers;
@@ -9,6 +9,7 @@
 #import "SDMemoryCache.h"
 #import "SDImageCacheConfig.h"
 #import "UIImage+MemoryCacheCost.h"
+#import "SDAnimatedImage.h"
 #import "SDInternalMacros.h"
 
 static void * SDMemoryCacheContext = &SDMemoryCacheContext;
@@ -17,9 +18,11 @@ static void * SDMemoryCacheContext = &SDMemoryCacheContext;
 #if SD_UIKIT
     SD_LOCK_DECLARE(_weakCacheLock); // a lock to keep the access to `weakCache` thread-safe
 #endif
+    SD_LOCK_DECLARE(_costKeyLock); // a lock to keep the access to `costKeys` thread-safe
 }
 
 @property (nonatomic, strong, nullable) SDImageCacheConfig *config;
+@property (nonatomic, strong, nonnull) NSMapTable<ObjectType, KeyType> *costKeys; // weak-strong, the key of image whose memory cost may change
 #if SD_UIKIT
 @property (nonatomic, strong, nonnull) NSMapTable<KeyType, ObjectType> *weakCache; // strong-weak cache
 #endif
@@ -33,6 +36,7 @@ static void * SDMemoryCacheContext = &SDMemoryCacheContext;
 #if SD_UIKIT
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 #endif
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:SDImageMemoryCostDidChangeNotification object:nil];
     self.delegate = nil;
 }
 
@@ -61,6 +65,13 @@ static void * SDMemoryCacheContext = &SDMemoryCacheContext;
 
     [config addObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCost)) options:0 context:SDMemoryCacheContext];
     [config addObserver:self forKeyPath:NSStringFromSelector(@selector(maxMemoryCount)) options:0 context:SDMemoryCacheContext];
+    
+    self.costKeys = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsWeakMemory | NSPointerFunctionsObjectPointerPersonality valueOptions:NSPointerFunctionsStrongMemory];
+    SD_LOCK_INIT(_costKeyLock);
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(imageMemoryCostDidChange:)
+                                                 name:SDImageMemoryCostDidChangeNotification
+                                               object:nil];
 
 #if SD_UIKIT
     self.weakCache = [[NSMapTable alloc] initWithKeyOptions:NSPointerFunctionsStrongMemory valueOptions:NSPointerFunctionsWeakMemory capacity:0];
@@ -73,16 +84,88 @@ static void * SDMemoryCacheContext = &SDMemoryCacheContext;
 #endif
 }
 
+#pragma mark - Memory Cost
+
+// `setObject:forKey:` just call this with 0 cost. Override this is enough
+// The mutations of cache are serialized by `@synchronized (self)` (recursive, the `NSCacheDelegate` may mutate during eviction), so the cost update below does not put back a replaced or removed image
+- (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)g {
+    @synchronized (self) {
+        [super setObject:obj forKey:key cost:g];
+    }
+    if (key && [obj conformsToProtocol:@protocol(SDAnimatedImage)]) {
+        // Only animated image's cost changes during its lifetime
+        SD_LOCK(_costKeyLock);
+        [self.costKeys setObject:key forKey:obj];
+        SD_UNLOCK(_costKeyLock);
+    }
+#if SD_UIKIT
+    [self setWeakObject:obj forKey:key];
+#endif
+}
+
+- (void)imageMemoryCostDidChange:(NSNotification *)notification {
+    UIImage *image = notification.object;
+    if (![image isKindOfClass:[UIImage class]]) {
+        return;
+    }
+    SD_LOCK(_costKeyLock);
+    id key = [self.costKeys objectForKey:image];
+    SD_UNLOCK(_costKeyLock);
+    if (!key) {
+        return;
+    }
+    // Only update when the image is still cached with the key. Set again to update the cost, which also evicts others if exceed the `totalCostLimit`
+    // Check and set atomically, another thread may store a new image for the key at the same time
+    @synchronized (self) {
+        if ([super objectForKey:key] != image) {
+            return;
+        }
+        [super setObject:image forKey:key cost:image.sd_memoryCost];
+    }
+}
+
+- (void)removeObjectForKey:(id)key {
+    @synchronized (self) {
+        [super removeObjectForKey:key];
+    }
+#if SD_UIKIT
+    if (!self.config.shouldUseWeakMemoryCache) {
+        return;
+    }
+    if (key) {
+        // Remove weak cache
+        SD_LOCK(_weakCacheLock);
+        [self.weakCache removeObjectForKey:key];
+        SD_UNLOCK(_weakCacheLock);
+    }
+#endif
+}
+
+- (void)removeAllObjects {
+    @synchronized (self) {
+        [super removeAllObjects];
+    }
+#if SD_UIKIT
+    if (!self.config.shouldUseWeakMemoryCache) {
+        return;
+    }
+    // Manually remove should also remove weak cache
+    SD_LOCK(_weakCacheLock);
+    [self.weakCache removeAllObjects];
+    SD_UNLOCK(_weakCacheLock);
+#endif
+}
+
 // Current this seems no use on macOS (macOS use virtual memory and do not clear cache when memory warning). So we only override on iOS/tvOS platform.
 #if SD_UIKIT
 - (void)didReceiveMemoryWarning:(NSNotification *)notification {
     // Only remove cache, but keep weak cache
-    [super removeAllObjects];
+    @synchronized (self) {
+        [super removeAllObjects];
+    }
 }
 
-// `setObject:forKey:` just call this with 0 cost. Override this is enough
-- (void)setObject:(id)obj forKey:(id)key cost:(NSUInteger)g {
-    [super setObject:obj forKey:key cost:g];
+- (void)setWeakObject:(id)obj forKey:(id)key {
     if (!self.config.shouldUseWeakMemoryCache) {
         return;
     }
@@ -105,40 +188,20 @@ static void * SDMemoryCacheContext = &SDMemoryCacheContext;
         obj = [self.weakCache objectForKey:key];
         SD_UNLOCK(_weakCacheLock);
         if (obj) {
-            // Sync cache
+            // Sync cache, unless another thread stored a new one for the key meanwhile
             NSUInteger cost = 0;
             if ([obj isKindOfClass:[UIImage class]]) {
                 cost = [(UIImage *)obj sd_memoryCost];
             }
-            [super setObject:obj forKey:key cost:cost];
+            @synchronized (self) {
+                if (![super objectForKey:key]) {
+                    [super setObject:obj forKey:key cost:cost];
+                }
+            }
         }
     }
     return obj;
 }
-
-- (void)removeObjectForKey:(id)key {
-    [super removeObjectForKey:key];
-    if (!self.config.shouldUseWeakMemoryCache) {
-        return;
-    }
-    if (key) {
-        // Remove weak cache
-        SD_LOCK(_weakCacheLock);
-        [self.weakCache removeObjectForKey:key];
-        SD_UNLOCK(_weakCacheLock);
-    }
-}
-
-- (void)removeAllObjects {
-    [super removeAllObjects];
-    if (!self.config.shouldUseWeakMemoryCache) {
-        return;
-    }
-    // Manually remove should also remove weak cache
-    SD_LOCK(_weakCacheLock);
-    [self.weakCache removeAllObjects];
-    SD_UNLOCK(_weakCacheLock);
-}
 #endif
 
 #pragma mark - KVO
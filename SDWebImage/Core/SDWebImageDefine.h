@@ -52,7 +52,7 @@ FOUNDATION_EXPORT UIImage * _Nullable SDScaledImageForScaleFactor(CGFloat scale,
 /// WebCache options
 typedef NS_OPTIONS(NSUInteger, SDWebImageOptions) {
     /**
-     * By default, when a URL fail to be downloaded, the URL is blacklisted so the library won't keep trying.
+     * By default, when a URL fail to be downloaded, the URL is blacklisted so the library won't keep trying until its retry date (exponential backoff, see `SDWebImageManager.failedURLTable`).
      * This flag disable this blacklisting.
      */
     SDWebImageRetryFailed = 1 << 0,
@@ -228,6 +228,38 @@ typedef NS_OPTIONS(NSUInteger, SDWebImageOptions) {
      * @note If you have complicated transition animation, just use `SDWebImageManager` and do UI state management by yourself, do not use the top-level API (`sd_setImageWithURL:`)
      */
     SDWebImageWaitTransition = 1 << 25,
+    
+    /**
+     * By default, `SDWebImageRefreshCached` relies on NSURLCache to revalidate the image, which keeps a second copy of the image data beside our disk cache.
+     * Use this flag together with `SDWebImageRefreshCached` to revalidate with the HTTP validators (`ETag` and `Last-Modified`) stored alongside the image in our disk cache instead, and NSURLCache is not used at all.
+     * The refresh request sends `If-None-Match` and `If-Modified-Since` header fields, if the remote location responds 304, the cached entry is marked as fresh without rewriting the image data, and the completion block is not called again.
+     * @note If the cached image does not have validators (such as stored before using this flag), a full download happens and the validators are stored with the new image.
+     */
+    SDWebImageRefreshCachedWithValidators = 1 << 26,
+    
+    /**
+     * By default, the downloader only reuse the in-flight download operation for the exact same URL.
+     * Use this flag to coalesce the in-flight downloads by the original cache key instead (which is from `cacheKeyFilter`), so the URL variants (such as signed query strings or tracking parameters) mapped to the same cache key share one network fetch.
+     * The later requests attach their callbacks to the running operation, and receive the image downloaded from the first URL.
+     * @note This fills `SDWebImageContextDownloadCoalescingKey` if not provided. See that for details.
+     * @note The requests without this flag are de-duplicated by the URL string, so they share the same operation with the coalesced requests when the cache key is the URL string (no `cacheKeyFilter`).
+     */
+    SDWebImageCoalesceDownloadsByCacheKey = 1 << 27,
+    
+    /**
+     * By default, the image is decoded in full pixel size, unless you provide `SDWebImageContextImageThumbnailPixelSize`.
+     * Use this flag to derive the thumbnail pixel size from the target view's bounds, content mode and screen scale automatically, so a large image is not decoded into a small view in full size. See `-[UIView sd_automaticThumbnailPixelSize]` for details.
+     * The derived size is bucketed by `SDBucketedThumbnailPixelSize`, so the thumbnailed cache keys stay few and reusable among the similar views.
+     * @note This options is UI level options, has no usage on ImageManager or other components. It does nothing when you provide the thumbnail pixel size in context, or the view has not been laid out (zero bounds).
+     */
+    SDWebImageAutomaticThumbnailPixelSize = 1 << 28,
+    
+    /**
+     * By default, the transformer on animated image (with `SDWebImageTransformAnimatedImage`) is called with the whole image, which most transformers only process the poster frame.
+     * Use this flag to transform each frame of the animated image once at load time, then encode the transformed frames into a new animated image data (the same format as original, or APNG if that format can not be encoded). The data is stored into disk cache with the transformed cache key, so later loading decode the already-transformed frames without transforming again.
+     * @note This implies `SDWebImageTransformAnimatedImage`. This consume more time and memory during loading, because all frames are decoded and transformed at once. For the transform during playback, use `SDAnimatedImageView.animationTransformer` instead.
+     */
+    SDWebImageTransformAnimatedImageFrames = 1 << 29,
 };
 
 
@@ -409,6 +441,13 @@ FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextDownlo
  */
 FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextDownloadDecryptor;
 
+/**
+ A string key to coalesce in-flight downloads. If provided, the downloader reuse the running download operation with the same key instead of the same URL, and attach the callbacks to it. Each download token still cancel its own callbacks only. (NSString)
+ @note The manager fills this with the original cache key when using `SDWebImageCoalesceDownloadsByCacheKey`. Only provide the key for URLs which return the same image, else the callbacks receive the image of another URL.
+ @note The download without this key is keyed by the URL string (`absoluteString`), which shares the same key space. So the key equals to an URL string reuse the plain download of that URL, and vice versa.
+ */
+FOUNDATION_EXPORT SDWebImageContextOption _Nonnull const SDWebImageContextDownloadCoalescingKey;
+
 /**
  A id<SDWebImageCacheKeyFilter> instance to convert an URL into a cache key. It's used when manager need cache key to use image cache. If you provide one, it will ignore the `cacheKeyFilter` in manager and use provided one instead. (id<SDWebImageCacheKeyFilter>)
  */
@@ -159,5 +159,6 @@ SDWebImageContextOption const SDWebImageContextAnimatedImageClass = @"animatedIm
 SDWebImageContextOption const SDWebImageContextDownloadRequestModifier = @"downloadRequestModifier";
 SDWebImageContextOption const SDWebImageContextDownloadResponseModifier = @"downloadResponseModifier";
 SDWebImageContextOption const SDWebImageContextDownloadDecryptor = @"downloadDecryptor";
+SDWebImageContextOption const SDWebImageContextDownloadCoalescingKey = @"downloadCoalescingKey";
 SDWebImageContextOption const SDWebImageContextCacheKeyFilter = @"cacheKeyFilter";
 SDWebImageContextOption const SDWebImageContextCacheSerializer = @"cacheSerializer";
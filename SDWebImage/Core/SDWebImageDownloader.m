@@ -12,6 +12,7 @@
 #import "SDWebImageError.h"
 #import "SDWebImageCacheKeyFilter.h"
 #import "SDImageCacheDefine.h"
+#import "UIImage+ExtendedCacheData.h"
 #import "SDInternalMacros.h"
 #import "objc/runtime.h"
 
@@ -41,8 +42,9 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
 @interface SDWebImageDownloader () <NSURLSessionTaskDelegate, NSURLSessionDataDelegate>
 
 @property (strong, nonatomic, nonnull) NSOperationQueue *downloadQueue;
-@property (strong, nonatomic, nonnull) NSMutableDictionary<NSURL *, NSOperation<SDWebImageDownloaderOperation> *> *URLOperations;
+@property (strong, nonatomic, nonnull) NSMutableDictionary<NSString *, NSOperation<SDWebImageDownloaderOperation> *> *URLOperations; // keyed by URL string, or by coalescing key if provided
 @property (strong, nonatomic, nullable) NSMutableDictionary<NSString *, NSString *> *HTTPHeaders;
+@property (assign, nonatomic) NSInteger adaptiveConcurrentDownloads; // decided by `config.concurrencyController`, 0 if not decided yet
 
 // The session in which data tasks will run
 @property (strong, nonatomic) NSURLSession *session;
@@ -52,6 +54,7 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
 @implementation SDWebImageDownloader {
     SD_LOCK_DECLARE(_HTTPHeadersLock); // A lock to keep the access to `HTTPHeaders` thread-safe
     SD_LOCK_DECLARE(_operationsLock); // A lock to keep the access to `URLOperations` thread-safe
+    SD_LOCK_DECLARE(_concurrentDownloadsLock); // A lock to keep the access to `adaptiveConcurrentDownloads` and the download queue concurrency thread-safe
 }
 
 + (void)initialize {
@@ -127,6 +130,7 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
         _HTTPHeaders = headerDictionary;
         SD_LOCK_INIT(_HTTPHeadersLock);
         SD_LOCK_INIT(_operationsLock);
+        SD_LOCK_INIT(_concurrentDownloadsLock);
         NSURLSessionConfiguration *sessionConfiguration = _config.sessionConfiguration;
         if (!sessionConfiguration) {
             sessionConfiguration = [NSURLSessionConfiguration defaultSessionConfiguration];
@@ -218,14 +222,28 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
         cacheKey = url.absoluteString;
     }
     SDImageCoderOptions *decodeOptions = SDGetDecodeOptionsFromContext(context, [self.class imageOptionsFromDownloaderOptions:options], cacheKey);
+    // The in-flight operations are de-duplicated by URL string, or the coalescing key (such as cache key) if provided
+    // Both are string, so the coalesced request share the operation with the plain request when the key equals to URL string (the default cache key)
+    NSString *operationKey = url.absoluteString;
+    NSString *coalescingKey = context[SDWebImageContextDownloadCoalescingKey];
+    if ([coalescingKey isKindOfClass:NSString.class] && coalescingKey.length > 0) {
+        operationKey = coalescingKey;
+    }
+    BOOL conditionalRequest = [self conditionalHTTPHeadersWithOptions:options context:context] != nil;
     SD_LOCK(_operationsLock);
-    NSOperation<SDWebImageDownloaderOperation> *operation = [self.URLOperations objectForKey:url];
+    NSOperation<SDWebImageDownloaderOperation> *operation = [self.URLOperations objectForKey:operationKey];
     // There is a case that the operation may be marked as finished or cancelled, but not been removed from `self.URLOperations`.
     BOOL shouldNotReuseOperation;
     if (operation) {
         @synchronized (operation) {
             shouldNotReuseOperation = operation.isFinished || operation.isCancelled;
         }
+        // The conditional request may be responded '304 Not Modified' without image data, which only the revalidation expects, so the plain request does not share it
+        // The conditional request can share the plain request, which is responded with the image data
+        if (!shouldNotReuseOperation && !conditionalRequest) {
+            NSURLRequest *operationRequest = operation.request;
+            shouldNotReuseOperation = [operationRequest valueForHTTPHeaderField:@"If-None-Match"] || [operationRequest valueForHTTPHeaderField:@"If-Modified-Since"];
+        }
     } else {
         shouldNotReuseOperation = YES;
     }
@@ -240,16 +258,20 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
             return nil;
         }
         @weakify(self);
+        __weak typeof(operation) weakOperation = operation;
         operation.completionBlock = ^{
             @strongify(self);
             if (!self) {
                 return;
             }
             SD_LOCK(self->_operationsLock);
-            [self.URLOperations removeObjectForKey:url];
+            // The key may be taken by a newer operation, which does not reuse this one
+            if ([self.URLOperations objectForKey:operationKey] == weakOperation) {
+                [self.URLOperations removeObjectForKey:operationKey];
+            }
             SD_UNLOCK(self->_operationsLock);
         };
-        [self.URLOperations setObject:operation forKey:url];
+        [self.URLOperations setObject:operation forKey:operationKey];
         // Add the handlers before submitting to operation queue, avoid the race condition that operation finished before setting handlers.
         downloadOperationCancelToken = [operation addHandlersForProgress:progressBlock completed:completedBlock decodeOptions:decodeOptions];
         // Add operation to operation queue only after all configuration done according to Apple's doc.
@@ -287,6 +309,19 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
 }
 #pragma clang diagnostic pop
 
+// The conditional request headers built from the validators stored alongside the cached image, nil if not revalidate with our own validators
+- (nullable NSDictionary<NSString *, NSString *> *)conditionalHTTPHeadersWithOptions:(SDWebImageDownloaderOptions)options context:(nullable SDWebImageContext *)context {
+    if (options & SDWebImageDownloaderUseNSURLCache) {
+        return nil;
+    }
+    UIImage *cachedImage = context[SDWebImageContextLoaderCachedImage];
+    NSDictionary<NSString *, NSString *> *cacheValidators = cachedImage.sd_cacheValidators;
+    NSMutableDictionary<NSString *, NSString *> *HTTPHeaders = [NSMutableDictionary dictionary];
+    HTTPHeaders[@"If-None-Match"] = cacheValidators[@"ETag"];
+    HTTPHeaders[@"If-Modified-Since"] = cacheValidators[@"Last-Modified"];
+    return HTTPHeaders.count > 0 ? [HTTPHeaders copy] : nil;
+}
+
 - (nullable NSOperation<SDWebImageDownloaderOperation> *)createDownloaderOperationWithUrl:(nonnull NSURL *)url
                                                                                   options:(SDWebImageDownloaderOptions)options
                                                                                   context:(nullable SDWebImageContext *)context {
@@ -304,6 +339,12 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
     mutableRequest.allHTTPHeaderFields = self.HTTPHeaders;
     SD_UNLOCK(_HTTPHeadersLock);
     
+    // Conditional request, using the validators stored alongside the cached image
+    NSDictionary<NSString *, NSString *> *conditionalHTTPHeaders = [self conditionalHTTPHeadersWithOptions:options context:context];
+    [conditionalHTTPHeaders enumerateKeysAndObjectsUsingBlock:^(NSString * _Nonnull field, NSString * _Nonnull value, BOOL * _Nonnull stop) {
+        [mutableRequest setValue:value forHTTPHeaderField:field];
+    }];
+    
     // Context Option
     SDWebImageMutableContext *mutableContext;
     if (context) {
@@ -427,7 +468,9 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
 - (void)observeValueForKeyPath:(NSString *)keyPath ofObject:(id)object change:(NSDictionary<NSKeyValueChangeKey,id> *)change context:(void *)context {
     if (context == SDWebImageDownloaderContext) {
         if ([keyPath isEqualToString:NSStringFromSelector(@selector(maxConcurrentDownloads))]) {
-            self.downloadQueue.maxConcurrentOperationCount = self.config.maxConcurrentDownloads;
+            SD_LOCK(_concurrentDownloadsLock);
+            [self updateConcurrentDownloads];
+            SD_UNLOCK(_concurrentDownloadsLock);
         }
     } else {
         [super observeValueForKeyPath:keyPath ofObject:object change:change context:context];
@@ -436,6 +479,19 @@ static void * SDWebImageDownloaderContext = &SDWebImageDownloaderContext;
 
 #pragma mark Helper methods
 
+// Apply the adaptive concurrent downloads capped at `config.maxConcurrentDownloads`, should be called inside `_concurrentDownloadsLock`
+- (void)updateConcurrentDownloads {
+    NSInteger concurrentDownloads = self.config.maxConcurrentDownloads;
+    NSInteger adaptiveConcurrentDownloads = self.adaptiveConcurrentDownloads;
+    if (self.config.concurrencyController && adaptiveConcurrentDownloads > 0) {
+        // Non-positive means no limit (such as `NSOperationQueueDefaultMaxConcurrentOperationCount`)
+        concurrentDownloads = concurrentDownloads > 0 ? MIN(adaptiveConcurrentDownloads, concurrentDownloads) : adaptiveConcurrentDownloads;
+    }
+    if (self.downloadQueue.maxConcurrentOperationCount != concurrentDownloads) {
+        self.downloadQueue.maxConcurrentOperationCount = concurrentDownloads;
+    }
+}
+
 - (NSOperation<SDWebImageDownloaderOperation> *)operationWithTask:(NSURLSessionTask *)task {
     NSOperation<SDWebImageDownloaderOperation> *returnOperation = nil;
     for (NSOperation<SDWebImageDownloaderOperation> *operation in self.downloadQueue.operations) {
@@ -541,6 +597,21 @@ didReceiveResponse:(NSURLResponse *)response
     if ([dataOperation respondsToSelector:@selector(URLSession:task:didFinishCollectingMetrics:)]) {
         [dataOperation URLSession:session task:task didFinishCollectingMetrics:metrics];
     }
+    
+    // Adjust the concurrent downloads from the finished task's metrics
+    id<SDWebImageDownloaderConcurrencyController> concurrencyController = self.config.concurrencyController;
+    if (concurrencyController) {
+        SD_LOCK(_concurrentDownloadsLock);
+        // The controller continues from its own decision, which may be above the current cap
+        NSInteger concurrentDownloads = self.adaptiveConcurrentDownloads > 0 ? self.adaptiveConcurrentDownloads : self.downloadQueue.maxConcurrentOperationCount;
+        NSInteger newConcurrentDownloads = [concurrencyController concurrentDownloadsWithMetrics:metrics receivedBytes:task.countOfBytesReceived currentConcurrentDownloads:concurrentDownloads];
+        if (newConcurrentDownloads > 0) {
+            // Do not write `config.maxConcurrentDownloads`, which is the user's upper bound
+            self.adaptiveConcurrentDownloads = newConcurrentDownloads;
+            [self updateConcurrentDownloads];
+        }
+        SD_UNLOCK(_concurrentDownloadsLock);
+    }
 }
 
 @end
@@ -615,7 +686,7 @@ didReceiveResponse:(NSURLResponse *)response
     SDWebImageDownloaderOptions downloaderOptions = 0;
     if (options & SDWebImageLowPriority) downloaderOptions |= SDWebImageDownloaderLowPriority;
     if (options & SDWebImageProgressiveLoad) downloaderOptions |= SDWebImageDownloaderProgressiveLoad;
-    if (options & SDWebImageRefreshCached) downloaderOptions |= SDWebImageDownloaderUseNSURLCache;
+    if (options & SDWebImageRefreshCached && !(options & SDWebImageRefreshCachedWithValidators)) downloaderOptions |= SDWebImageDownloaderUseNSURLCache;
     if (options & SDWebImageContinueInBackground) downloaderOptions |= SDWebImageDownloaderContinueInBackground;
     if (options & SDWebImageHandleCookies) downloaderOptions |= SDWebImageDownloaderHandleCookies;
     if (options & SDWebImageAllowInvalidSSLCertificates) downloaderOptions |= SDWebImageDownloaderAllowInvalidSSLCertificates;
@@ -630,7 +701,10 @@ didReceiveResponse:(NSURLResponse *)response
         // force progressive off if image already cached but forced refreshing
         downloaderOptions &= ~SDWebImageDownloaderProgressiveLoad;
         // ignore image read from NSURLCache if image if cached but force refreshing
-        downloaderOptions |= SDWebImageDownloaderIgnoreCachedResponse;
+        // When revalidate with our own validators, NSURLCache is not used, the 304 response is reported instead
+        if (!(options & SDWebImageRefreshCachedWithValidators)) {
+            downloaderOptions |= SDWebImageDownloaderIgnoreCachedResponse;
+        }
     }
     
     return [self downloadImageWithURL:url options:downloaderOptions context:context progress:progressBlock completed:completedBlock];
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+/**
+ This is the protocol for downloader concurrency controller.
+ The downloader pass the network metrics of each finished download task to the controller, and the controller decide the new value of concurrent downloads, which is applied to the download queue.
+ @note The controller is called on the URLSession delegate queue serially, but you should still keep the implementation thread-safe if shared between multiple downloaders.
+ */
+@protocol SDWebImageDownloaderConcurrencyController <NSObject>
+
+/// Return the concurrent downloads count which the downloader should use after the task finished.
+/// @param metrics The task metrics collected by URLSession.
+/// @param receivedBytes The response body bytes received by the task.
+/// @param concurrentDownloads The current concurrent downloads count in use.
+/// @return The new concurrent downloads count. Return `concurrentDownloads` to keep it unchanged.
+- (NSInteger)concurrentDownloadsWithMetrics:(nonnull NSURLSessionTaskMetrics *)metrics receivedBytes:(int64_t)receivedBytes currentConcurrentDownloads:(NSInteger)concurrentDownloads API_AVAILABLE(macos(10.12), ios(10.0), watchos(3.0), tvos(10.0));
+
+@end
+
+/**
+ A AIMD (Additive Increase Multiplicative Decrease) concurrency controller, which adjusts the concurrent downloads from the rolling throughput and time-to-first-byte (TTFB).
+ When the rolling TTFB grows beyond `latencyTolerance` times of the best TTFB observed, the link is treated as congested and the concurrency is multiplied by `decreaseFactor`. Otherwise, if the rolling throughput does not drop, the concurrency is increased by 1.
+ The concurrency always stay in [`minConcurrentDownloads`, `maxConcurrentDownloads`].
+ */
+@interface SDWebImageDownloaderConcurrencyController : NSObject <SDWebImageDownloaderConcurrencyController>
+
+/// The lower bound of concurrent downloads. Defaults to 2.
+@property (nonatomic, assign, readonly) NSInteger minConcurrentDownloads;
+
+/// The upper bound of concurrent downloads. Defaults to 16.
+@property (nonatomic, assign, readonly) NSInteger maxConcurrentDownloads;
+
+/// The number of finished tasks to collect before each adjustment. Defaults to 4.
+@property (nonatomic, assign) NSUInteger sampleWindow;
+
+/// The smoothing factor for the rolling (exponentially weighted moving average) throughput and TTFB, in (0, 1]. Defaults to 0.3.
+@property (nonatomic, assign) double smoothingFactor;
+
+/// The ratio of rolling TTFB to best TTFB beyond which the link is treated as congested. Defaults to 2.0.
+@property (nonatomic, assign) double latencyTolerance;
+
+/// The multiplicative factor applied to the concurrency when congested, in (0, 1). Defaults to 0.5.
+@property (nonatomic, assign) double decreaseFactor;
+
+/// The current rolling throughput, in bytes per second. 0 before any sample.
+@property (nonatomic, assign, readonly) double throughput;
+
+/// The current rolling time-to-first-byte, in seconds. 0 before any sample.
+@property (nonatomic, assign, readonly) NSTimeInterval timeToFirstByte;
+
+/// Create the controller with bounds.
+/// @param minConcurrentDownloads The lower bound, at least 1.
+/// @param maxConcurrentDownloads The upper bound, at least `minConcurrentDownloads`.
+- (nonnull instancetype)initWithMinConcurrentDownloads:(NSInteger)minConcurrentDownloads maxConcurrentDownloads:(NSInteger)maxConcurrentDownloads NS_DESIGNATED_INITIALIZER;
+
+/// Create the controller with default bounds [2, 16].
+- (nonnull instancetype)init;
+
+/// Feed one sample and return the new concurrent downloads count. This is what `concurrentDownloadsWithMetrics:receivedBytes:currentConcurrentDownloads:` calls after extracting the sample from metrics.
+/// @param timeToFirstByte The time between request start and response start, in seconds.
+/// @param throughput The response body bytes per second of the task.
+/// @param concurrentDownloads The current concurrent downloads count in use.
+- (NSInteger)concurrentDownloadsWithTimeToFirstByte:(NSTimeInterval)timeToFirstByte throughput:(double)throughput currentConcurrentDownloads:(NSInteger)concurrentDownloads;
+
+/// Reset all the collected samples.
+- (void)reset;
+
+@end
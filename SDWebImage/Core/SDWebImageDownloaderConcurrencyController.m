@@ -0,0 +1,117 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDWebImageDownloaderConcurrencyController.h"
+#import "SDInternalMacros.h"
+
+@interface SDWebImageDownloaderConcurrencyController ()
+
+@property (nonatomic, assign, readwrite) double throughput;
+@property (nonatomic, assign, readwrite) NSTimeInterval timeToFirstByte;
+@property (nonatomic, assign) NSTimeInterval bestTimeToFirstByte;
+@property (nonatomic, assign) double lastAggregateThroughput;
+@property (nonatomic, assign) NSUInteger sampleCount;
+
+@end
+
+@implementation SDWebImageDownloaderConcurrencyController {
+    SD_LOCK_DECLARE(_sampleLock);
+}
+
+- (instancetype)init {
+    return [self initWithMinConcurrentDownloads:2 maxConcurrentDownloads:16];
+}
+
+- (instancetype)initWithMinConcurrentDownloads:(NSInteger)minConcurrentDownloads maxConcurrentDownloads:(NSInteger)maxConcurrentDownloads {
+    self = [super init];
+    if (self) {
+        _minConcurrentDownloads = MAX(minConcurrentDownloads, 1);
+        _maxConcurrentDownloads = MAX(maxConcurrentDownloads, _minConcurrentDownloads);
+        _sampleWindow = 4;
+        _smoothingFactor = 0.3;
+        _latencyTolerance = 2.0;
+        _decreaseFactor = 0.5;
+        SD_LOCK_INIT(_sampleLock);
+    }
+    return self;
+}
+
+- (void)reset {
+    SD_LOCK(_sampleLock);
+    self.throughput = 0;
+    self.timeToFirstByte = 0;
+    self.bestTimeToFirstByte = 0;
+    self.lastAggregateThroughput = 0;
+    self.sampleCount = 0;
+    SD_UNLOCK(_sampleLock);
+}
+
+- (NSInteger)concurrentDownloadsWithMetrics:(NSURLSessionTaskMetrics *)metrics receivedBytes:(int64_t)receivedBytes currentConcurrentDownloads:(NSInteger)concurrentDownloads API_AVAILABLE(macos(10.12), ios(10.0), watchos(3.0), tvos(10.0)) {
+    // Use the last transaction, the previous ones are redirections
+    NSURLSessionTaskTransactionMetrics *transactionMetrics = metrics.transactionMetrics.lastObject;
+    // Response loaded from local cache does not reflect the network condition
+    if (!transactionMetrics || transactionMetrics.resourceFetchType != NSURLSessionTaskMetricsResourceFetchTypeNetworkLoad) {
+        return concurrentDownloads;
+    }
+    NSDate *requestStartDate = transactionMetrics.requestStartDate;
+    NSDate *responseStartDate = transactionMetrics.responseStartDate;
+    NSDate *responseEndDate = transactionMetrics.responseEndDate;
+    if (!requestStartDate || !responseStartDate || !responseEndDate || receivedBytes <= 0) {
+        return concurrentDownloads;
+    }
+    NSTimeInterval timeToFirstByte = [responseStartDate timeIntervalSinceDate:requestStartDate];
+    NSTimeInterval transferDuration = [responseEndDate timeIntervalSinceDate:responseStartDate];
+    if (timeToFirstByte < 0) {
+        return concurrentDownloads;
+    }
+    // Avoid dividing by zero for tiny response which arrived in one packet
+    double throughput = receivedBytes / MAX(transferDuration, 0.001);
+    return [self concurrentDownloadsWithTimeToFirstByte:timeToFirstByte throughput:throughput currentConcurrentDownloads:concurrentDownloads];
+}
+
+- (NSInteger)concurrentDownloadsWithTimeToFirstByte:(NSTimeInterval)timeToFirstByte throughput:(double)throughput currentConcurrentDownloads:(NSInteger)concurrentDownloads {
+    NSInteger minConcurrentDownloads = self.minConcurrentDownloads;
+    NSInteger maxConcurrentDownloads = self.maxConcurrentDownloads;
+    NSInteger newConcurrentDownloads = MIN(MAX(concurrentDownloads, minConcurrentDownloads), maxConcurrentDownloads);
+    double alpha = MIN(MAX(self.smoothingFactor, 0.01), 1);
+
+    SD_LOCK(_sampleLock);
+    if (self.sampleCount == 0 && self.timeToFirstByte == 0) {
+        self.timeToFirstByte = timeToFirstByte;
+        self.throughput = throughput;
+    } else {
+        self.timeToFirstByte = alpha * timeToFirstByte + (1 - alpha) * self.timeToFirstByte;
+        self.throughput = alpha * throughput + (1 - alpha) * self.throughput;
+    }
+    if (self.bestTimeToFirstByte == 0 || timeToFirstByte < self.bestTimeToFirstByte) {
+        self.bestTimeToFirstByte = timeToFirstByte;
+    }
+    self.sampleCount++;
+
+    if (self.sampleCount >= MAX(self.sampleWindow, 1)) {
+        self.sampleCount = 0;
+        // Each running task shares the link, so the link throughput is roughly the per-task throughput multiplied by concurrency
+        double aggregateThroughput = self.throughput * newConcurrentDownloads;
+        BOOL congested = self.timeToFirstByte > self.bestTimeToFirstByte * MAX(self.latencyTolerance, 1);
+        if (congested) {
+            double decreaseFactor = MIN(MAX(self.decreaseFactor, 0.1), 0.9);
+            newConcurrentDownloads = MAX((NSInteger)floor(newConcurrentDownloads * decreaseFactor), minConcurrentDownloads);
+        } else if (aggregateThroughput >= self.lastAggregateThroughput * 0.95) {
+            // More parallel tasks still gain throughput, probe one more
+            newConcurrentDownloads = MIN(newConcurrentDownloads + 1, maxConcurrentDownloads);
+        }
+        self.lastAggregateThroughput = aggregateThroughput;
+        // Let the best TTFB drift to the current value slowly, so a permanent network change (Wi-Fi to Cellular) does not stay congested forever
+        self.bestTimeToFirstByte += (self.timeToFirstByte - self.bestTimeToFirstByte) * 0.05;
+    }
+    SD_UNLOCK(_sampleLock);
+
+    return newConcurrentDownloads;
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import <Foundation/Foundation.h>
 #import "SDWebImageCompat.h"
+#import "SDWebImageDownloaderConcurrencyController.h"
 
 /// Operation execution order
 typedef NS_ENUM(NSInteger, SDWebImageDownloaderExecutionOrder) {
@@ -40,6 +41,14 @@ typedef NS_ENUM(NSInteger, SDWebImageDownloaderExecutionOrder) {
  */
 @property (nonatomic, assign) NSInteger maxConcurrentDownloads;
 
+/**
+ * The concurrency controller which adjusts the concurrent downloads from the network metrics of finished downloads (bandwidth and time-to-first-byte). See `SDWebImageDownloaderConcurrencyController` for the built-in AIMD policy.
+ * When set, `maxConcurrentDownloads` is the initial value and the upper bound, the controller's decision takes over below it after each download task finished. `maxConcurrentDownloads` itself is not changed by the controller.
+ * Defaults to nil, which means the concurrent downloads is always `maxConcurrentDownloads`.
+ * @note The network metrics is only available on iOS 10+/macOS 10.12+/tvOS 10+/watchOS 3+, the controller is not used on lower firmware.
+ */
+@property (nonatomic, strong, nullable) id<SDWebImageDownloaderConcurrencyController> concurrencyController;
+
 /**
  * The timeout value (in seconds) for each download operation.
  * Defaults to 15.0.
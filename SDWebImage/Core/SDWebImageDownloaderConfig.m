@@ -35,6 +35,7 @@ static SDWebImageDownloaderConfig * _defaultDownloaderConfig;
 - (id)copyWithZone:(NSZone *)zone {
     SDWebImageDownloaderConfig *config = [[[self class] allocWithZone:zone] init];
     config.maxConcurrentDownloads = self.maxConcurrentDownloads;
+    config.concurrencyController = self.concurrencyController;
     config.downloadTimeout = self.downloadTimeout;
     config.minimumProgressInterval = self.minimumProgressInterval;
     config.sessionConfiguration = [self.sessionConfiguration copyWithZone:zone];
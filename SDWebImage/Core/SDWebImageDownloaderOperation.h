@@ -77,6 +77,17 @@
  */
 @property (strong, nonatomic, readonly, nullable) NSURLSessionTaskMetrics *metrics API_AVAILABLE(macos(10.12), ios(10.0), watchos(3.0), tvos(10.0));
 
+/**
+ * The progressive decoding metrics, only available when using `SDWebImageDownloaderProgressiveLoad`.
+ * For JPEG and PNG, the progressive decoding is triggered only when a new scan or enough new rows arrived, instead of every received data. `skippedProgressiveDecodeCount` is the number of times we avoided a decoding because no visible change expected.
+ * `progressiveDecodeDuration` is the total CPU time of progressive decoding, and `wastedProgressiveDecodeDuration` is the part which produced no image or whose image is discarded because the download already completed.
+ * @note These values are updated during downloading, read them after the operation finished for accurate result.
+ */
+@property (assign, nonatomic, readonly) NSUInteger progressiveDecodeCount;
+@property (assign, nonatomic, readonly) NSUInteger skippedProgressiveDecodeCount;
+@property (assign, nonatomic, readonly) NSTimeInterval progressiveDecodeDuration;
+@property (assign, nonatomic, readonly) NSTimeInterval wastedProgressiveDecodeDuration;
+
 /**
  * The credential used for authentication challenges in `-URLSession:task:didReceiveChallenge:completionHandler:`.
  *
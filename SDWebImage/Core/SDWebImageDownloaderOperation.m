@@ -13,6 +13,9 @@
 #import "SDWebImageDownloaderDecryptor.h"
 #import "SDImageCacheDefine.h"
 #import "SDCallbackQueue.h"
+#import "SDImageProgressiveScanner.h"
+#import "SDImageDecodeScheduler.h"
+#import "UIImage+ExtendedCacheData.h"
 
 // A handler to represent individual request
 @interface SDWebImageDownloaderOperationToken : NSObject
@@ -76,6 +79,11 @@
 @property (strong, nonatomic, readwrite, nullable) NSURLSessionTaskMetrics *metrics API_AVAILABLE(macos(10.12), ios(10.0), watchos(3.0), tvos(10.0));
 
 @property (strong, nonatomic, nonnull) NSOperationQueue *coderQueue; // the serial operation queue to do image decoding
+@property (strong, nonatomic, nullable) SDImageProgressiveScanner *progressiveScanner; // decide when progressive decoding produces visible change
+@property (assign, nonatomic, readwrite) NSUInteger progressiveDecodeCount;
+@property (assign, nonatomic, readwrite) NSUInteger skippedProgressiveDecodeCount;
+@property (assign, nonatomic, readwrite) NSTimeInterval progressiveDecodeDuration;
+@property (assign, nonatomic, readwrite) NSTimeInterval wastedProgressiveDecodeDuration;
 
 @property (strong, nonatomic, nonnull) NSMapTable<SDImageCoderOptions *, UIImage *> *imageMap; // each variant of image is weak-referenced to avoid too many re-decode during downloading
 #if SD_UIKIT
@@ -386,10 +394,19 @@
                 } else {
                     context = self.context;
                 }
-                if (progressiveCoder) {
-                    image = SDImageLoaderDecodeProgressiveImageData(imageData, self.request.URL, YES, self, options, context);
-                } else {
-                    image = SDImageLoaderDecodeImageData(imageData, self.request.URL, options, context);
+                NSUInteger cost = [SDImageDecodeScheduler decodeCostForImageData:imageData options:SDGetDecodeOptionsFromContext(context, options, self.request.URL.absoluteString)];
+                __block UIImage *decodedImage;
+                [SDImageDecodeScheduler.sharedScheduler performWithCost:cost priority:[self decodePriority] block:^{
+                    if (progressiveCoder) {
+                        decodedImage = SDImageLoaderDecodeProgressiveImageData(imageData, self.request.URL, YES, self, options, context);
+                    } else {
+                        decodedImage = SDImageLoaderDecodeImageData(imageData, self.request.URL, options, context);
+                    }
+                }];
+                image = decodedImage;
+                if (image) {
+                    // Bind the HTTP validators, which is stored alongside the image by cache for revalidation
+                    image.sd_cacheValidators = SDImageLoaderGetCacheValidators(self.response);
                 }
                 if (image && token.decodeOptions) {
                     [self.imageMap setObject:image forKey:token.decodeOptions];
@@ -452,8 +469,11 @@ didReceiveResponse:(NSURLResponse *)response
     
     // Check status code valid (defaults [200,400))
     NSInteger statusCode = [response isKindOfClass:NSHTTPURLResponse.class] ? ((NSHTTPURLResponse *)response).statusCode : 0;
+    // Conditional request with our own validators, '304 Not Modified' means the cached image is still fresh, which is not an invalid status code
+    BOOL conditionalRequest = [self.request valueForHTTPHeaderField:@"If-None-Match"] || [self.request valueForHTTPHeaderField:@"If-Modified-Since"];
+    BOOL conditionalNotModified = conditionalRequest && statusCode == 304;
     BOOL statusCodeValid = YES;
-    if (valid && statusCode > 0 && self.acceptableStatusCodes) {
+    if (valid && statusCode > 0 && self.acceptableStatusCodes && !conditionalNotModified) {
         statusCodeValid = [self.acceptableStatusCodes containsIndex:statusCode];
     }
     if (!statusCodeValid) {
@@ -467,7 +487,7 @@ didReceiveResponse:(NSURLResponse *)response
     // Check content type valid (defaults nil)
     NSString *contentType = [response isKindOfClass:NSHTTPURLResponse.class] ? ((NSHTTPURLResponse *)response).MIMEType : nil;
     BOOL contentTypeValid = YES;
-    if (valid && contentType.length > 0 && self.acceptableContentTypes) {
+    if (valid && contentType.length > 0 && self.acceptableContentTypes && !conditionalNotModified) {
         contentTypeValid = [self.acceptableContentTypes containsObject:contentType];
     }
     if (!contentTypeValid) {
@@ -480,11 +500,14 @@ didReceiveResponse:(NSURLResponse *)response
     }
     //'304 Not Modified' is an exceptional one
     //URLSession current behavior will return 200 status code when the server respond 304 and URLCache hit. But this is not a standard behavior and we just add a check
+    //For conditional request, this is the expected result of revalidation. The downloader does not share the conditional request with the plain request, so all the callbacks expect it
     if (valid && statusCode == 304 && !self.cachedData) {
         valid = NO;
+        NSString *description = conditionalNotModified ? @"Download response status code is 304 not modified for conditional request" : @"Download response status code is 304 not modified and ignored";
         self.responseError = [NSError errorWithDomain:SDWebImageErrorDomain
                                                  code:SDWebImageErrorCacheNotModified
-                                             userInfo:@{NSLocalizedDescriptionKey: @"Download response status code is 304 not modified and ignored",
+                                             userInfo:@{NSLocalizedDescriptionKey: description,
+                                                        SDWebImageErrorDownloadStatusCodeKey : @(statusCode),
                                                         SDWebImageErrorDownloadResponseKey : response}];
     }
     
@@ -554,8 +577,17 @@ didReceiveResponse:(NSURLResponse *)response
         // Get the image data
         NSData *imageData = self.imageData;
         
+        if (!self.progressiveScanner) {
+            self.progressiveScanner = [[SDImageProgressiveScanner alloc] initWithExpectedSize:self.expectedSize];
+        }
         // keep maximum one progressive decode process during download
-        if (imageData && self.coderQueue.operationCount == 0) {
+        BOOL shouldDecode = imageData && self.coderQueue.operationCount == 0;
+        // only decode when a new scan or enough rows arrived, which produce visible change
+        if (shouldDecode && ![self.progressiveScanner shouldDecodeWithData:imageData]) {
+            shouldDecode = NO;
+            self.skippedProgressiveDecodeCount++;
+        }
+        if (shouldDecode) {
             // NSOperation have autoreleasepool, don't need to create extra one
             @weakify(self);
             [self.coderQueue addOperationWithBlock:^{
@@ -569,7 +601,36 @@ didReceiveResponse:(NSURLResponse *)response
                         return;
                     }
                 }
-                UIImage *image = SDImageLoaderDecodeProgressiveImageData(imageData, self.request.URL, NO, self, [[self class] imageOptionsFromDownloaderOptions:self.options], self.context);
+                SDWebImageOptions options = [[self class] imageOptionsFromDownloaderOptions:self.options];
+                NSUInteger cost = [SDImageDecodeScheduler decodeCostForImageData:imageData options:SDGetDecodeOptionsFromContext(self.context, options, self.request.URL.absoluteString)];
+                __block UIImage *image;
+                __block NSTimeInterval duration = 0;
+                __block BOOL decoded = NO;
+                // Progressive decoding is the first to wait when the decode budget is exhausted
+                [SDImageDecodeScheduler.sharedScheduler performWithCost:cost priority:SDImageDecodePriorityLow block:^{
+                    // The transfer may finish during waiting, skip the outdated decoding
+                    @synchronized (self) {
+                        if (self.isCancelled || self.isDownloadCompleted) {
+                            return;
+                        }
+                    }
+                    CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+                    image = SDImageLoaderDecodeProgressiveImageData(imageData, self.request.URL, NO, self, options, self.context);
+                    duration = CFAbsoluteTimeGetCurrent() - startTime;
+                    decoded = YES;
+                }];
+                if (!decoded) {
+                    return;
+                }
+                BOOL wasted = !image;
+                @synchronized (self) {
+                    wasted = wasted || self.isCancelled || self.isDownloadCompleted;
+                }
+                self.progressiveDecodeCount++;
+                self.progressiveDecodeDuration += duration;
+                if (wasted) {
+                    self.wastedProgressiveDecodeDuration += duration;
+                }
                 if (image) {
                     // We do not keep the progressive decoding image even when `finished`=YES. Because they are for view rendering but not take full function from downloader options. And some coders implementation may not keep consistent between progressive decoding and normal decoding.
                     
@@ -718,6 +779,15 @@ didReceiveResponse:(NSURLResponse *)response
 }
 #pragma clang diagnostic pop
 
+- (SDImageDecodePriority)decodePriority {
+    if (SD_OPTIONS_CONTAINS(self.options, SDWebImageDownloaderHighPriority)) {
+        return SDImageDecodePriorityHigh;
+    } else if (SD_OPTIONS_CONTAINS(self.options, SDWebImageDownloaderLowPriority)) {
+        return SDImageDecodePriorityLow;
+    }
+    return SDImageDecodePriorityNormal;
+}
+
 - (BOOL)shouldContinueWhenAppEntersBackground {
     return SD_OPTIONS_CONTAINS(self.options, SDWebImageDownloaderContinueInBackground);
 }
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+/**
+ The failure table used by `SDWebImageManager` to block the failed URLs.
+ Each failed URL is blocked until its retry date, which grows with jittered exponential backoff for each consecutive failure: `min(baseRetryInterval * 2^(failureCount - 1), maxRetryInterval)`, reduced by a random ratio up to `jitterRatio`. So the transient errors do not block the URL forever, and the retry does not hammer the origin.
+ The table is bounded by `countLimit`, the least recently failed URL is evicted first.
+ @note This class is thread-safe.
+ */
+@interface SDWebImageFailedURLTable : NSObject
+
+/// The base retry interval after the first failure, in seconds. Defaults to 10.
+@property (nonatomic, assign) NSTimeInterval baseRetryInterval;
+
+/// The upper bound of retry interval, in seconds. Defaults to 3600 (1 hour). Pass a negative value to block the failed URL forever, which is the behavior before backoff.
+@property (nonatomic, assign) NSTimeInterval maxRetryInterval;
+
+/// The ratio of random jitter subtracted from retry interval, in [0, 1]. Used to avoid lots of URLs retry at the same time. Defaults to 0.5.
+@property (nonatomic, assign) double jitterRatio;
+
+/// The maximum number of URLs in the table. Defaults to 1000. Pass 0 means no limit.
+@property (nonatomic, assign) NSUInteger countLimit;
+
+/// The path to persist the table across launches, nil if the table is in memory only.
+@property (nonatomic, copy, readonly, nullable) NSString *path;
+
+/// The number of URLs in the table, including the ones whose retry date has passed.
+@property (nonatomic, assign, readonly) NSUInteger count;
+
+/// Create an in-memory table.
+- (nonnull instancetype)init;
+
+/// Create a table persisted at the path. The table is loaded from the path if exists, and written back asynchronously after each change.
+/// @param path The file path to persist, pass nil for in-memory table.
+- (nonnull instancetype)initWithPath:(nullable NSString *)path NS_DESIGNATED_INITIALIZER;
+
+/// Whether the URL is blocked currently, which means it failed and the retry date has not passed.
+- (BOOL)isBlockedURL:(nonnull NSURL *)url;
+
+/// Record one failure for the URL, which increases the failure count and reschedules the retry date.
+- (void)recordFailureForURL:(nonnull NSURL *)url;
+
+/// The consecutive failure count of the URL, 0 if not in the table.
+- (NSUInteger)failureCountForURL:(nonnull NSURL *)url;
+
+/// The retry date of the URL, nil if not in the table. `distantFuture` if blocked forever.
+- (nullable NSDate *)retryDateForURL:(nonnull NSURL *)url;
+
+/// Remove the URL, such as when it succeeded.
+- (void)removeURL:(nonnull NSURL *)url;
+
+/// Remove all the URLs.
+- (void)removeAllURLs;
+
+@end
@@ -0,0 +1,253 @@
+/*
+ * This file is part of the SDWebImage package.
+ * (c) Olivier Poitrey <rs@dailymotion.com>
+ *
+ * For the full copyright and license information, please view the LICENSE
+ * file that was distributed with this source code.
+ */
+
+#import "SDWebImageFailedURLTable.h"
+#import "SDInternalMacros.h"
+
+static NSString * const SDFailedURLTableURLKey = @"url";
+static NSString * const SDFailedURLTableFailureCountKey = @"failureCount";
+static NSString * const SDFailedURLTableRetryTimeKey = @"retryTime";
+
+@interface SDWebImageFailedURLEntry : NSObject
+
+@property (nonatomic, assign) NSUInteger failureCount;
+@property (nonatomic, assign) NSTimeInterval retryTime; // since 1970, `DBL_MAX` for forever
+
+@end
+
+@implementation SDWebImageFailedURLEntry
+@end
+
+@interface SDWebImageFailedURLTable ()
+
+@property (nonatomic, copy, readwrite, nullable) NSString *path;
+@property (nonatomic, strong, nonnull) NSMutableDictionary<NSURL *, SDWebImageFailedURLEntry *> *entries;
+@property (nonatomic, strong, nonnull) NSMutableOrderedSet<NSURL *> *LRUURLs; // least recently failed first
+@property (nonatomic, strong, nullable) dispatch_queue_t ioQueue;
+@property (nonatomic, assign) BOOL saveScheduled;
+
+@end
+
+@implementation SDWebImageFailedURLTable {
+    SD_LOCK_DECLARE(_entriesLock);
+}
+
+- (instancetype)init {
+    return [self initWithPath:nil];
+}
+
+- (instancetype)initWithPath:(NSString *)path {
+    self = [super init];
+    if (self) {
+        _baseRetryInterval = 10;
+        _maxRetryInterval = 3600;
+        _jitterRatio = 0.5;
+        _countLimit = 1000;
+        _path = [path copy];
+        _entries = [NSMutableDictionary dictionary];
+        _LRUURLs = [NSMutableOrderedSet orderedSet];
+        SD_LOCK_INIT(_entriesLock);
+        if (path) {
+            _ioQueue = dispatch_queue_create("com.hackemist.SDWebImageFailedURLTable.ioQueue", DISPATCH_QUEUE_SERIAL);
+            [self loadFromPath:path];
+        }
+    }
+    return self;
+}
+
+#pragma mark - Query
+
+- (NSUInteger)count {
+    SD_LOCK(_entriesLock);
+    NSUInteger count = self.entries.count;
+    SD_UNLOCK(_entriesLock);
+    return count;
+}
+
+- (BOOL)isBlockedURL:(NSURL *)url {
+    if (!url) {
+        return NO;
+    }
+    SD_LOCK(_entriesLock);
+    SDWebImageFailedURLEntry *entry = self.entries[url];
+    SD_UNLOCK(_entriesLock);
+    if (!entry) {
+        return NO;
+    }
+    return [NSDate date].timeIntervalSince1970 < entry.retryTime;
+}
+
+- (NSUInteger)failureCountForURL:(NSURL *)url {
+    if (!url) {
+        return 0;
+    }
+    SD_LOCK(_entriesLock);
+    NSUInteger failureCount = self.entries[url].failureCount;
+    SD_UNLOCK(_entriesLock);
+    return failureCount;
+}
+
+- (NSDate *)retryDateForURL:(NSURL *)url {
+    if (!url) {
+        return nil;
+    }
+    SD_LOCK(_entriesLock);
+    SDWebImageFailedURLEntry *entry = self.entries[url];
+    SD_UNLOCK(_entriesLock);
+    if (!entry) {
+        return nil;
+    }
+    if (entry.retryTime == DBL_MAX) {
+        return [NSDate distantFuture];
+    }
+    return [NSDate dateWithTimeIntervalSince1970:entry.retryTime];
+}
+
+#pragma mark - Update
+
+- (void)recordFailureForURL:(NSURL *)url {
+    if (!url) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    SDWebImageFailedURLEntry *entry = self.entries[url];
+    if (!entry) {
+        entry = [SDWebImageFailedURLEntry new];
+        self.entries[url] = entry;
+    }
+    entry.failureCount++;
+    entry.retryTime = [self retryTimeWithFailureCount:entry.failureCount];
+    // Move to the most recent
+    [self.LRUURLs removeObject:url];
+    [self.LRUURLs addObject:url];
+    NSUInteger countLimit = self.countLimit;
+    while (countLimit > 0 && self.LRUURLs.count > countLimit) {
+        NSURL *evictURL = self.LRUURLs.firstObject;
+        [self.LRUURLs removeObjectAtIndex:0];
+        [self.entries removeObjectForKey:evictURL];
+    }
+    SD_UNLOCK(_entriesLock);
+    [self setNeedsSave];
+}
+
+- (void)removeURL:(NSURL *)url {
+    if (!url) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    BOOL exists = self.entries[url] != nil;
+    if (exists) {
+        [self.entries removeObjectForKey:url];
+        [self.LRUURLs removeObject:url];
+    }
+    SD_UNLOCK(_entriesLock);
+    if (exists) {
+        [self setNeedsSave];
+    }
+}
+
+- (void)removeAllURLs {
+    SD_LOCK(_entriesLock);
+    [self.entries removeAllObjects];
+    [self.LRUURLs removeAllObjects];
+    SD_UNLOCK(_entriesLock);
+    [self setNeedsSave];
+}
+
+#pragma mark - Helper
+
+- (NSTimeInterval)retryTimeWithFailureCount:(NSUInteger)failureCount {
+    NSTimeInterval maxRetryInterval = self.maxRetryInterval;
+    if (maxRetryInterval < 0) {
+        // Block forever
+        return DBL_MAX;
+    }
+    // Limit the exponent to avoid overflow, the interval is capped by `maxRetryInterval` anyway
+    NSUInteger exponent = MIN(failureCount - 1, 32);
+    NSTimeInterval retryInterval = MIN(MAX(self.baseRetryInterval, 0) * pow(2, exponent), maxRetryInterval);
+    double jitterRatio = MIN(MAX(self.jitterRatio, 0), 1);
+    double random = (double)arc4random() / UINT32_MAX;
+    retryInterval -= retryInterval * jitterRatio * random;
+    return [NSDate date].timeIntervalSince1970 + retryInterval;
+}
+
+#pragma mark - Persistence
+
+- (void)loadFromPath:(NSString *)path {
+    NSArray *items = [NSArray arrayWithContentsOfFile:path];
+    if (![items isKindOfClass:NSArray.class]) {
+        return;
+    }
+    NSTimeInterval now = [NSDate date].timeIntervalSince1970;
+    for (NSDictionary *item in items) {
+        if (![item isKindOfClass:NSDictionary.class]) {
+            continue;
+        }
+        NSString *URLString = item[SDFailedURLTableURLKey];
+        NSNumber *failureCount = item[SDFailedURLTableFailureCountKey];
+        NSNumber *retryTime = item[SDFailedURLTableRetryTimeKey];
+        if (![URLString isKindOfClass:NSString.class] || ![failureCount isKindOfClass:NSNumber.class] || ![retryTime isKindOfClass:NSNumber.class]) {
+            continue;
+        }
+        NSURL *url = [NSURL URLWithString:URLString];
+        if (!url) {
+            continue;
+        }
+        // Keep the expired entry, the failure count is still used for next backoff
+        SDWebImageFailedURLEntry *entry = [SDWebImageFailedURLEntry new];
+        entry.failureCount = failureCount.unsignedIntegerValue;
+        entry.retryTime = retryTime.doubleValue;
+        if (entry.retryTime != DBL_MAX && entry.retryTime - now > MAX(self.maxRetryInterval, 0)) {
+            // Clock changed, do not block longer than the max interval
+            entry.retryTime = now + MAX(self.maxRetryInterval, 0);
+        }
+        self.entries[url] = entry;
+        [self.LRUURLs removeObject:url];
+        [self.LRUURLs addObject:url];
+    }
+}
+
+- (void)setNeedsSave {
+    if (!self.path) {
+        return;
+    }
+    SD_LOCK(_entriesLock);
+    BOOL saveScheduled = self.saveScheduled;
+    self.saveScheduled = YES;
+    SD_UNLOCK(_entriesLock);
+    if (saveScheduled) {
+        return;
+    }
+    // Coalesce the continuous changes into one write
+    @weakify(self);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(NSEC_PER_SEC)), self.ioQueue, ^{
+        @strongify(self);
+        if (!self) {
+            return;
+        }
+        [self save];
+    });
+}
+
+- (void)save {
+    SD_LOCK(_entriesLock);
+    self.saveScheduled = NO;
+    NSMutableArray<NSDictionary *> *items = [NSMutableArray arrayWithCapacity:self.LRUURLs.count];
+    for (NSURL *url in self.LRUURLs) {
+        SDWebImageFailedURLEntry *entry = self.entries[url];
+        [items addObject:@{SDFailedURLTableURLKey : url.absoluteString,
+                           SDFailedURLTableFailureCountKey : @(entry.failureCount),
+                           SDFailedURLTableRetryTimeKey : @(entry.retryTime)}];
+    }
+    SD_UNLOCK(_entriesLock);
+    NSString *path = self.path;
+    [[NSFileManager defaultManager] createDirectoryAtPath:path.stringByDeletingLastPathComponent withIntermediateDirectories:YES attributes:nil error:nil];
+    [items writeToFile:path atomically:YES];
+}
+
+@end
@@ -14,6 +14,8 @@
 #import "SDWebImageCacheKeyFilter.h"
 #import "SDWebImageCacheSerializer.h"
 #import "SDWebImageOptionsProcessor.h"
+#import "SDWebImageFailedURLTable.h"
+#import "SDImageThumbnailVariantTable.h"
 
 typedef void(^SDExternalCompletionBlock)(UIImage * _Nullable image, NSError * _Nullable error, SDImageCacheType cacheType, NSURL * _Nullable imageURL);
 
@@ -264,6 +266,20 @@ SDWebImageManager *manager = [SDWebImageManager sharedManager];
  */
 - (void)cancelAll;
 
+/**
+ * The failure table to block the failed URLs. Each failed URL is blocked until its retry date, which grows with jittered exponential backoff for consecutive failures, and the table is bounded with LRU eviction. See `SDWebImageFailedURLTable`.
+ * You can replace it with a persisted one (`initWithPath:`) to keep the failures across launches, or set `maxRetryInterval` to negative to block the failed URLs forever.
+ * @note The `SDWebImageRetryFailed` option ignores the table. And the URL is removed from the table once it succeeds.
+ */
+@property (nonatomic, strong, nonnull) SDWebImageFailedURLTable *failedURLTable;
+
+/**
+ * The variant table to record which thumbnail pixel sizes are cached for each URL. When the requested thumbnail misses the cache, the manager downscales the nearest larger cached thumbnail (from memory bitmap, or subsampled decoding from disk data) before querying the full size original image, and stores the result. See `SDImageThumbnailVariantTable`.
+ * Defaults to a new table. Set to nil to disable this behavior.
+ * @note Only the thumbnail without transformer is recorded and served, because the transformed image can not be downscaled as the same result.
+ */
+@property (nonatomic, strong, nullable) SDImageThumbnailVariantTable *thumbnailVariantTable;
+
 /**
  * Remove the specify URL from failed black list.
  * @param url The failed URL.
@@ -10,10 +10,13 @@
 #import "SDImageCache.h"
 #import "SDWebImageDownloader.h"
 #import "UIImage+Metadata.h"
+#import "SDImageCoderHelper.h"
 #import "SDAssociatedObject.h"
 #import "SDWebImageError.h"
 #import "SDInternalMacros.h"
 #import "SDCallbackQueue.h"
+#import "SDImageCodersManager.h"
+#import "SDAnimatedImage.h"
 
 static id<SDImageCache> _defaultImageCache;
 static id<SDImageLoader> _defaultImageLoader;
@@ -28,13 +31,11 @@ static id<SDImageLoader> _defaultImageLoader;
 @end
 
 @interface SDWebImageManager () {
-    SD_LOCK_DECLARE(_failedURLsLock); // a lock to keep the access to `failedURLs` thread-safe
     SD_LOCK_DECLARE(_runningOperationsLock); // a lock to keep the access to `runningOperations` thread-safe
 }
 
 @property (strong, nonatomic, readwrite, nonnull) SDImageCache *imageCache;
 @property (strong, nonatomic, readwrite, nonnull) id<SDImageLoader> imageLoader;
-@property (strong, nonatomic, nonnull) NSMutableSet<NSURL *> *failedURLs;
 @property (strong, nonatomic, nonnull) NSMutableSet<SDWebImageCombinedOperation *> *runningOperations;
 
 @end
@@ -88,8 +89,8 @@ static id<SDImageLoader> _defaultImageLoader;
     if ((self = [super init])) {
         _imageCache = cache;
         _imageLoader = loader;
-        _failedURLs = [NSMutableSet new];
-        SD_LOCK_INIT(_failedURLsLock);
+        _failedURLTable = [SDWebImageFailedURLTable new];
+        _thumbnailVariantTable = [SDImageThumbnailVariantTable new];
         _runningOperations = [NSMutableSet new];
         SD_LOCK_INIT(_runningOperationsLock);
     }
@@ -210,9 +211,7 @@ static id<SDImageLoader> _defaultImageLoader;
 
     BOOL isFailedUrl = NO;
     if (url) {
-        SD_LOCK(_failedURLsLock);
-        isFailedUrl = [self.failedURLs containsObject:url];
-        SD_UNLOCK(_failedURLsLock);
+        isFailedUrl = [self.failedURLTable isBlockedURL:url];
     }
     
     // Preprocess the options and context arg to decide the final the result for manager
@@ -266,15 +265,11 @@ static id<SDImageLoader> _defaultImageLoader;
     if (!url) {
         return;
     }
-    SD_LOCK(_failedURLsLock);
-    [self.failedURLs removeObject:url];
-    SD_UNLOCK(_failedURLsLock);
+    [self.failedURLTable removeURL:url];
 }
 
 - (void)removeAllFailedURLs {
-    SD_LOCK(_failedURLsLock);
-    [self.failedURLs removeAllObjects];
-    SD_UNLOCK(_failedURLsLock);
+    [self.failedURLTable removeAllURLs];
 }
 
 #pragma mark - Private
@@ -321,9 +316,13 @@ static id<SDImageLoader> _defaultImageLoader;
                 // Have a chance to query original cache instead of downloading, then applying transform
                 // Thumbnail decoding is done inside SDImageCache's decoding part, which does not need post processing for transform
                 if (mayInOriginalCache) {
-                    [self callOriginalCacheProcessForOperation:operation url:url options:options context:context progress:progressBlock completed:completedBlock];
+                    // Try the larger thumbnail variant firstly, which is cheaper than the full size original image
+                    [self callThumbnailVariantCacheProcessForOperation:operation url:url options:options context:context progress:progressBlock completed:completedBlock];
                     return;
                 }
+            } else {
+                // The thumbnail hit proves the variant exists, which may be cached before launch
+                [self recordThumbnailVariantForURL:url context:context];
             }
             // Continue download process
             [self callDownloadProcessForOperation:operation url:url options:options context:context cachedImage:cachedImage cachedData:cachedData cacheType:cacheType progress:progressBlock completed:completedBlock];
@@ -337,6 +336,72 @@ static id<SDImageLoader> _defaultImageLoader;
     }
 }
 
+// Query larger thumbnail variant cache process
+- (void)callThumbnailVariantCacheProcessForOperation:(nonnull SDWebImageCombinedOperation *)operation
+                                                 url:(nonnull NSURL *)url
+                                             options:(SDWebImageOptions)options
+                                             context:(nullable SDWebImageContext *)context
+                                            progress:(nullable SDImageLoaderProgressBlock)progressBlock
+                                           completed:(nullable SDInternalCompletionBlock)completedBlock {
+    SDImageThumbnailVariantTable *variantTable = self.thumbnailVariantTable;
+    BOOL preserveAspectRatio = YES;
+    CGSize thumbnailSize = [self thumbnailPixelSizeForContext:context preserveAspectRatio:&preserveAspectRatio];
+    NSString *originKey = [self originalCacheKeyForURL:url context:context];
+    CGSize variantSize = CGSizeZero;
+    if (variantTable && [self shouldUseThumbnailVariantForContext:context]) {
+        variantSize = [variantTable nearestVariantPixelSizeForKey:originKey pixelSize:thumbnailSize preserveAspectRatio:preserveAspectRatio];
+    }
+    if (!(variantSize.width > 0 && variantSize.height > 0)) {
+        // No variant available. Continue original cache process
+        [self callOriginalCacheProcessForOperation:operation url:url options:options context:context progress:progressBlock completed:completedBlock];
+        return;
+    }
+    
+    // Grab the image cache to use
+    id<SDImageCache> imageCache = context[SDWebImageContextImageCache];
+    if (!imageCache) {
+        imageCache = self.imageCache;
+    }
+    // Get the query cache type
+    SDImageCacheType queryCacheType = SDImageCacheTypeAll;
+    if (context[SDWebImageContextQueryCacheType]) {
+        queryCacheType = [context[SDWebImageContextQueryCacheType] integerValue];
+    }
+    // Keep the requested thumbnail context, so the disk data is decoded with subsampling to the requested size
+    // But never sync the decoded image back to memory, which would store the smaller one with the variant key
+    SDWebImageMutableContext *mutableContext = [context mutableCopy];
+    mutableContext[SDWebImageContextStoreCacheType] = @(SDImageCacheTypeNone);
+    NSString *variantKey = SDThumbnailedKeyForKey(originKey, variantSize, preserveAspectRatio);
+    @weakify(operation);
+    id<SDWebImageOperation> cacheOperation = [imageCache queryImageForKey:variantKey options:options context:mutableContext cacheType:queryCacheType completion:^(UIImage * _Nullable cachedImage, NSData * _Nullable cachedData, SDImageCacheType cacheType) {
+        @strongify(operation);
+        if (!operation || operation.isCancelled) {
+            // Image combined operation cancelled by user
+            [self callCompletionBlockForOperation:operation completion:completedBlock error:[NSError errorWithDomain:SDWebImageErrorDomain code:SDWebImageErrorCancelled userInfo:@{NSLocalizedDescriptionKey : @"Operation cancelled by user during querying the cache"}] queue:context[SDWebImageContextCallbackQueue] url:url];
+            [self safelyRemoveOperationFromRunning:operation];
+            return;
+        }
+        UIImage *thumbnailImage = [self thumbnailImageWithVariantImage:cachedImage pixelSize:thumbnailSize preserveAspectRatio:preserveAspectRatio];
+        if (!thumbnailImage) {
+            if (!cachedImage) {
+                // The variant has been evicted
+                [variantTable removeVariantWithPixelSize:variantSize preserveAspectRatio:preserveAspectRatio forKey:originKey];
+            }
+            // Continue original cache process
+            [self callOriginalCacheProcessForOperation:operation url:url options:options context:context progress:progressBlock completed:completedBlock];
+            return;
+        }
+        
+        // Skip downloading and continue transform process (which store the thumbnail), and ignore .refreshCached option for now
+        [self callTransformProcessForOperation:operation url:url options:options context:context originalImage:thumbnailImage originalData:nil cacheType:cacheType finished:YES completed:completedBlock];
+        
+        [self safelyRemoveOperationFromRunning:operation];
+    }];
+    @synchronized (operation) {
+        operation.cacheOperation = cacheOperation;
+    }
+}
+
 // Query original cache process
 - (void)callOriginalCacheProcessForOperation:(nonnull SDWebImageCombinedOperation *)operation
                                          url:(nonnull NSURL *)url
@@ -353,10 +418,16 @@ static id<SDImageLoader> _defaultImageLoader;
             imageCache = self.imageCache;
         }
     }
+    BOOL preserveAspectRatio = YES;
+    CGSize thumbnailSize = [self thumbnailPixelSizeForContext:context preserveAspectRatio:&preserveAspectRatio];
+    BOOL shouldThumbnail = thumbnailSize.width > 0 && thumbnailSize.height > 0;
     // Get the original query cache type
     SDImageCacheType originalQueryCacheType = SDImageCacheTypeDisk;
     if (context[SDWebImageContextOriginalQueryCacheType]) {
         originalQueryCacheType = [context[SDWebImageContextOriginalQueryCacheType] integerValue];
+    } else if (shouldThumbnail) {
+        // The full size original in memory can be downscaled to the thumbnail, which is cheaper than decoding from disk
+        originalQueryCacheType = SDImageCacheTypeAll;
     }
     
     // Check whether we should query original cache
@@ -376,8 +447,21 @@ static id<SDImageLoader> _defaultImageLoader;
                 // Original image cache miss. Continue download process
                 [self callDownloadProcessForOperation:operation url:url options:options context:context cachedImage:nil cachedData:nil cacheType:SDImageCacheTypeNone progress:progressBlock completed:completedBlock];
                 return;
+            } else if (shouldThumbnail && !cachedImage.sd_isThumbnail) {
+                // The full size original from memory cache, downscale to the requested thumbnail
+                UIImage *thumbnailImage = [self thumbnailImageWithVariantImage:cachedImage pixelSize:thumbnailSize preserveAspectRatio:preserveAspectRatio];
+                if (!thumbnailImage) {
+                    // Animated or vector image, decode the thumbnail from disk data instead
+                    SDWebImageMutableContext *mutableContext = [context mutableCopy];
+                    mutableContext[SDWebImageContextOriginalQueryCacheType] = @(SDImageCacheTypeDisk);
+                    [self callOriginalCacheProcessForOperation:operation url:url options:options context:[mutableContext copy] progress:progressBlock completed:completedBlock];
+                    return;
+                }
+                // The original data is not the thumbnail's
+                cachedImage = thumbnailImage;
+                cachedData = nil;
             }
-                        
+            
             // Skip downloading and continue transform process, and ignore .refreshCached option for now
             [self callTransformProcessForOperation:operation url:url options:options context:context originalImage:cachedImage originalData:cachedData cacheType:cacheType finished:YES completed:completedBlock];
             
@@ -437,6 +521,17 @@ static id<SDImageLoader> _defaultImageLoader;
             mutableContext[SDWebImageContextLoaderCachedImage] = cachedImage;
             context = [mutableContext copy];
         }
+        if (options & SDWebImageCoalesceDownloadsByCacheKey && !context[SDWebImageContextDownloadCoalescingKey]) {
+            // Coalesce the in-flight downloads by original cache key, the thumbnail and transformer are applied per callback
+            SDWebImageMutableContext *mutableContext;
+            if (context) {
+                mutableContext = [context mutableCopy];
+            } else {
+                mutableContext = [NSMutableDictionary dictionary];
+            }
+            mutableContext[SDWebImageContextDownloadCoalescingKey] = [self originalCacheKeyForURL:url context:context];
+            context = [mutableContext copy];
+        }
         
         @weakify(operation);
         id<SDWebImageOperation> loaderOperation = [imageLoader requestImageWithURL:url options:options context:context progress:progressBlock completed:^(UIImage *downloadedImage, NSData *downloadedData, NSError *error, BOOL finished) {
@@ -446,6 +541,10 @@ static id<SDImageLoader> _defaultImageLoader;
                 [self callCompletionBlockForOperation:operation completion:completedBlock error:[NSError errorWithDomain:SDWebImageErrorDomain code:SDWebImageErrorCancelled userInfo:@{NSLocalizedDescriptionKey : @"Operation cancelled by user during sending the request"}] queue:context[SDWebImageContextCallbackQueue] url:url];
             } else if (cachedImage && options & SDWebImageRefreshCached && [error.domain isEqualToString:SDWebImageErrorDomain] && error.code == SDWebImageErrorCacheNotModified) {
                 // Image refresh hit the NSURLCache cache, do not call the completion block
+                // Or revalidated by our own validators, mark the cached image as fresh
+                if (options & SDWebImageRefreshCachedWithValidators) {
+                    [self callRefreshCacheProcessForURL:url options:options context:context response:error.userInfo[SDWebImageErrorDownloadResponseKey]];
+                }
             } else if ([error.domain isEqualToString:SDWebImageErrorDomain] && error.code == SDWebImageErrorCancelled) {
                 // Download operation cancelled by user before sending the request, don't block failed URL
                 [self callCompletionBlockForOperation:operation completion:completedBlock error:error queue:context[SDWebImageContextCallbackQueue] url:url];
@@ -454,16 +553,11 @@ static id<SDImageLoader> _defaultImageLoader;
                 BOOL shouldBlockFailedURL = [self shouldBlockFailedURLWithURL:url error:error options:options context:context];
                 
                 if (shouldBlockFailedURL) {
-                    SD_LOCK(self->_failedURLsLock);
-                    [self.failedURLs addObject:url];
-                    SD_UNLOCK(self->_failedURLsLock);
+                    [self.failedURLTable recordFailureForURL:url];
                 }
             } else {
-                if ((options & SDWebImageRetryFailed)) {
-                    SD_LOCK(self->_failedURLsLock);
-                    [self.failedURLs removeObject:url];
-                    SD_UNLOCK(self->_failedURLsLock);
-                }
+                // The URL may be retried after backoff, or with `SDWebImageRetryFailed`, reset the failure count
+                [self.failedURLTable removeURL:url];
                 // Continue transform process
                 [self callTransformProcessForOperation:operation url:url options:options context:context originalImage:downloadedImage originalData:downloadedData cacheType:SDImageCacheTypeNone finished:finished completed:completedBlock];
             }
@@ -501,7 +595,8 @@ static id<SDImageLoader> _defaultImageLoader;
     }
     // transformer check
     BOOL shouldTransformImage = originalImage && transformer;
-    shouldTransformImage = shouldTransformImage && (!originalImage.sd_isAnimated || (options & SDWebImageTransformAnimatedImage));
+    shouldTransformImage = shouldTransformImage && (!originalImage.sd_isAnimated || (options & SDWebImageTransformAnimatedImage) || (options & SDWebImageTransformAnimatedImageFrames));
+    BOOL shouldTransformFrames = originalImage.sd_isAnimated && (options & SDWebImageTransformAnimatedImageFrames);
     shouldTransformImage = shouldTransformImage && (!originalImage.sd_isVector || (options & SDWebImageTransformVectorImage));
     // thumbnail check
     BOOL isThumbnail = originalImage.sd_isThumbnail;
@@ -517,7 +612,13 @@ static id<SDImageLoader> _defaultImageLoader;
         NSString *key = [self cacheKeyForURL:url context:context];
         dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
             // Case that transformer on thumbnail, which this time need full pixel image
-            UIImage *transformedImage = [transformer transformedImageWithImage:cacheImage forKey:key];
+            UIImage *transformedImage;
+            NSData *transformedData;
+            if (shouldTransformFrames) {
+                transformedImage = [self transformedAnimatedImageWithImage:cacheImage transformer:transformer forKey:key options:options context:context data:&transformedData];
+            } else {
+                transformedImage = [transformer transformedImageWithImage:cacheImage forKey:key];
+            }
             if (transformedImage) {
                 // We need keep some metadata from the full size image when needed
                 // Because most of our transformer does not care about these information
@@ -531,7 +632,7 @@ static id<SDImageLoader> _defaultImageLoader;
                 }
                 // Mark the transformed
                 transformedImage.sd_isTransformed = YES;
-                [self callStoreOriginCacheProcessForOperation:operation url:url options:options context:context originalImage:originalImage cacheImage:transformedImage originalData:originalData cacheData:nil cacheType:cacheType finished:finished completed:completedBlock];
+                [self callStoreOriginCacheProcessForOperation:operation url:url options:options context:context originalImage:originalImage cacheImage:transformedImage originalData:originalData cacheData:transformedData cacheType:cacheType finished:finished completed:completedBlock];
             } else {
                 [self callStoreOriginCacheProcessForOperation:operation url:url options:options context:context originalImage:originalImage cacheImage:cacheImage originalData:originalData cacheData:cacheData cacheType:cacheType finished:finished completed:completedBlock];
             }
@@ -541,6 +642,70 @@ static id<SDImageLoader> _defaultImageLoader;
     }
 }
 
+// Transform each frame of the animated image, then encode into new animated image data, so the disk cache keep the transformed animation
+- (nullable UIImage *)transformedAnimatedImageWithImage:(nonnull UIImage *)image
+                                            transformer:(nonnull id<SDImageTransformer>)transformer
+                                                 forKey:(nullable NSString *)key
+                                                options:(SDWebImageOptions)options
+                                                context:(nullable SDWebImageContext *)context
+                                                   data:(NSData * _Nullable * _Nonnull)data {
+    NSArray<SDImageFrame *> *frames;
+    NSUInteger loopCount = image.sd_imageLoopCount;
+    SDImageFormat format = image.sd_imageFormat;
+    if ([image conformsToProtocol:@protocol(SDAnimatedImage)]) {
+        // `SDAnimatedImage` decode the frames just in time
+        id<SDAnimatedImage> animatedImage = (id<SDAnimatedImage>)image;
+        NSUInteger frameCount = animatedImage.animatedImageFrameCount;
+        NSMutableArray<SDImageFrame *> *animatedFrames = [NSMutableArray arrayWithCapacity:frameCount];
+        for (NSUInteger i = 0; i < frameCount; i++) {
+            UIImage *frameImage = [animatedImage animatedImageFrameAtIndex:i];
+            if (!frameImage) {
+                return nil;
+            }
+            [animatedFrames addObject:[SDImageFrame frameWithImage:frameImage duration:[animatedImage animatedImageDurationAtIndex:i]]];
+        }
+        frames = [animatedFrames copy];
+        loopCount = animatedImage.animatedImageLoopCount;
+        if ([image isKindOfClass:SDAnimatedImage.class]) {
+            format = ((SDAnimatedImage *)image).animatedImageFormat;
+        }
+    } else {
+        frames = [SDImageCoderHelper framesFromAnimatedImage:image];
+    }
+    if (frames.count == 0) {
+        return nil;
+    }
+    NSMutableArray<SDImageFrame *> *transformedFrames = [NSMutableArray arrayWithCapacity:frames.count];
+    for (SDImageFrame *frame in frames) {
+        @autoreleasepool {
+            UIImage *transformedImage = [transformer transformedImageWithImage:frame.image forKey:key];
+            if (!transformedImage) {
+                return nil;
+            }
+            [transformedFrames addObject:[SDImageFrame frameWithImage:transformedImage duration:frame.duration]];
+        }
+    }
+    
+    // Encode with the same format, fallback to APNG
+    SDImageCoderOptions *encodeOptions = context[SDWebImageContextImageEncodeOptions];
+    NSData *transformedData = [SDImageCodersManager.sharedManager encodedDataWithFrames:transformedFrames loopCount:loopCount format:format options:encodeOptions];
+    if (!transformedData && format != SDImageFormatPNG) {
+        transformedData = [SDImageCodersManager.sharedManager encodedDataWithFrames:transformedFrames loopCount:loopCount format:SDImageFormatPNG options:encodeOptions];
+    }
+    *data = transformedData;
+    UIImage *transformedImage;
+    if (transformedData && [image conformsToProtocol:@protocol(SDAnimatedImage)]) {
+        // Keep the same animated image class, decode with the same options as loading, like the cache does for the stored data later
+        SDImageCoderOptions *decodeOptions = SDGetDecodeOptionsFromContext(context, options, key ?: @"");
+        transformedImage = [[image.class alloc] initWithData:transformedData scale:image.scale options:decodeOptions];
+    }
+    if (!transformedImage) {
+        transformedImage = [SDImageCoderHelper animatedImageWithFrames:transformedFrames];
+        transformedImage.sd_imageLoopCount = loopCount;
+    }
+    return transformedImage;
+}
+
 // Store origin cache process
 - (void)callStoreOriginCacheProcessForOperation:(nonnull SDWebImageCombinedOperation *)operation
                                             url:(nonnull NSURL *)url
@@ -620,22 +785,60 @@ static id<SDImageLoader> _defaultImageLoader;
     
     // transformed cache key
     NSString *key = [self cacheKeyForURL:url context:context];
+    // Record the thumbnail variant, so the smaller thumbnail request can downscale from it
+    BOOL shouldRecordVariant = finished && image.sd_isThumbnail && storeCacheType != SDImageCacheTypeNone;
     if (finished && cacheSerializer && (storeCacheType == SDImageCacheTypeDisk || storeCacheType == SDImageCacheTypeAll)) {
         dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
             NSData *newData = [cacheSerializer cacheDataWithImage:image originalData:data imageURL:url];
             // Store image and data
             [self storeImage:image imageData:newData forKey:key options:options context:context imageCache:imageCache cacheType:storeCacheType finished:finished completion:^{
+                if (shouldRecordVariant) {
+                    [self recordThumbnailVariantForURL:url context:context];
+                }
                 [self callCompletionBlockForOperation:operation completion:completedBlock image:image data:data error:nil cacheType:cacheType finished:finished queue:context[SDWebImageContextCallbackQueue] url:url];
             }];
         });
     } else {
         // Store image and data
         [self storeImage:image imageData:data forKey:key options:options context:context imageCache:imageCache cacheType:storeCacheType finished:finished completion:^{
+            if (shouldRecordVariant) {
+                [self recordThumbnailVariantForURL:url context:context];
+            }
             [self callCompletionBlockForOperation:operation completion:completedBlock image:image data:data error:nil cacheType:cacheType finished:finished queue:context[SDWebImageContextCallbackQueue] url:url];
         }];
     }
 }
 
+// Refresh cache process, after the cached image revalidated by `304 Not Modified`
+- (void)callRefreshCacheProcessForURL:(nonnull NSURL *)url
+                              options:(SDWebImageOptions)options
+                              context:(SDWebImageContext *)context
+                             response:(nullable NSURLResponse *)response {
+    // The 304 response may contains the updated validators
+    NSDictionary<NSString *, NSString *> *cacheValidators = SDImageLoaderGetCacheValidators(response);
+    // Original cache, choose standalone original cache firstly
+    id<SDImageCache> originalImageCache = context[SDWebImageContextOriginalImageCache];
+    if (!originalImageCache) {
+        originalImageCache = context[SDWebImageContextImageCache];
+        if (!originalImageCache) {
+            originalImageCache = self.imageCache;
+        }
+    }
+    NSString *originalKey = [self originalCacheKeyForURL:url context:context];
+    if ([originalImageCache respondsToSelector:@selector(refreshImageForKey:cacheValidators:completion:)]) {
+        [originalImageCache refreshImageForKey:originalKey cacheValidators:cacheValidators completion:nil];
+    }
+    // Transformed cache, only when the key is different
+    id<SDImageCache> imageCache = context[SDWebImageContextImageCache];
+    if (!imageCache) {
+        imageCache = self.imageCache;
+    }
+    NSString *key = [self cacheKeyForURL:url context:context];
+    if ((imageCache != originalImageCache || ![key isEqualToString:originalKey]) && [imageCache respondsToSelector:@selector(refreshImageForKey:cacheValidators:completion:)]) {
+        [imageCache refreshImageForKey:key cacheValidators:cacheValidators completion:nil];
+    }
+}
+
 #pragma mark - Helper
 
 - (void)safelyRemoveOperationFromRunning:(nullable SDWebImageCombinedOperation*)operation {
@@ -713,6 +916,110 @@ static id<SDImageLoader> _defaultImageLoader;
     }
 }
 
+- (CGSize)thumbnailPixelSizeForContext:(nullable SDWebImageContext *)context preserveAspectRatio:(nonnull BOOL *)preserveAspectRatio {
+    CGSize thumbnailSize = CGSizeZero;
+    NSValue *thumbnailSizeValue = context[SDWebImageContextImageThumbnailPixelSize];
+    if (thumbnailSizeValue != nil) {
+#if SD_MAC
+        thumbnailSize = thumbnailSizeValue.sizeValue;
+#else
+        thumbnailSize = thumbnailSizeValue.CGSizeValue;
+#endif
+    }
+    *preserveAspectRatio = YES;
+    NSNumber *preserveAspectRatioValue = context[SDWebImageContextImagePreserveAspectRatio];
+    if (preserveAspectRatioValue != nil) {
+        *preserveAspectRatio = preserveAspectRatioValue.boolValue;
+    }
+    return thumbnailSize;
+}
+
+- (BOOL)shouldUseThumbnailVariantForContext:(nullable SDWebImageContext *)context {
+    BOOL preserveAspectRatio;
+    CGSize thumbnailSize = [self thumbnailPixelSizeForContext:context preserveAspectRatio:&preserveAspectRatio];
+    if (!(thumbnailSize.width > 0 && thumbnailSize.height > 0)) {
+        return NO;
+    }
+    // The transformed thumbnail can not be downscaled as the same result
+    id<SDImageTransformer> transformer = context[SDWebImageContextImageTransformer];
+    if (transformer && ![transformer isEqual:NSNull.null]) {
+        return NO;
+    }
+    return YES;
+}
+
+- (void)recordThumbnailVariantForURL:(nonnull NSURL *)url context:(nullable SDWebImageContext *)context {
+    SDImageThumbnailVariantTable *variantTable = self.thumbnailVariantTable;
+    if (!variantTable || ![self shouldUseThumbnailVariantForContext:context]) {
+        return;
+    }
+    BOOL preserveAspectRatio = YES;
+    CGSize thumbnailSize = [self thumbnailPixelSizeForContext:context preserveAspectRatio:&preserveAspectRatio];
+    NSString *originKey = [self originalCacheKeyForURL:url context:context];
+    [variantTable addVariantWithPixelSize:thumbnailSize preserveAspectRatio:preserveAspectRatio forKey:originKey];
+}
+
+// Downscale the larger variant to the requested thumbnail, nil if the variant can not be used
+- (nullable UIImage *)thumbnailImageWithVariantImage:(nullable UIImage *)image pixelSize:(CGSize)pixelSize preserveAspectRatio:(BOOL)preserveAspectRatio {
+    if (!image) {
+        return nil;
+    }
+    // Animated or vector variant can not be downscaled as bitmap
+    if (image.sd_isAnimated || image.sd_isVector) {
+        return nil;
+    }
+    SDImageCoderOptions *decodeOptions = image.sd_decodeOptions;
+    NSValue *thumbnailSizeValue = decodeOptions[SDImageCoderDecodeThumbnailPixelSize];
+    NSNumber *preserveAspectRatioValue = decodeOptions[SDImageCoderDecodePreserveAspectRatio];
+    if ([thumbnailSizeValue isEqualToValue:@(pixelSize)] && (preserveAspectRatioValue ? preserveAspectRatioValue.boolValue : YES) == preserveAspectRatio) {
+        // Already decoded from disk data with the requested thumbnail size
+        return image;
+    }
+    CGImageRef imageRef = image.CGImage;
+    if (!imageRef) {
+        return nil;
+    }
+    CGSize imagePixelSize = CGSizeMake(CGImageGetWidth(imageRef), CGImageGetHeight(imageRef));
+    CGSize scaleSize = pixelSize;
+#if !SD_MAC
+    // The thumbnail pixel size is for the oriented image, but the CGImage is not oriented
+    switch (image.imageOrientation) {
+        case UIImageOrientationLeft:
+        case UIImageOrientationRight:
+        case UIImageOrientationLeftMirrored:
+        case UIImageOrientationRightMirrored:
+            scaleSize = CGSizeMake(pixelSize.height, pixelSize.width);
+            break;
+        default:
+            break;
+    }
+#endif
+    CGSize targetSize = [SDImageCoderHelper scaledSizeWithImageSize:imagePixelSize scaleSize:scaleSize preserveAspectRatio:preserveAspectRatio shouldScaleUp:NO];
+    CGImageRef thumbnailImageRef;
+    if (CGSizeEqualToSize(targetSize, imagePixelSize)) {
+        thumbnailImageRef = CGImageRetain(imageRef);
+    } else {
+        thumbnailImageRef = [SDImageCoderHelper CGImageCreateScaled:imageRef size:targetSize];
+    }
+    if (!thumbnailImageRef) {
+        return nil;
+    }
+#if SD_MAC
+    UIImage *thumbnailImage = [[UIImage alloc] initWithCGImage:thumbnailImageRef scale:image.scale orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *thumbnailImage = [[UIImage alloc] initWithCGImage:thumbnailImageRef scale:image.scale orientation:image.imageOrientation];
+#endif
+    CGImageRelease(thumbnailImageRef);
+    SDImageCopyAssociatedObject(image, thumbnailImage);
+    // Mark as the requested thumbnail, the same as decoding from the original data
+    SDImageCoderMutableOptions *mutableDecodeOptions = decodeOptions ? [decodeOptions mutableCopy] : [NSMutableDictionary dictionary];
+    mutableDecodeOptions[SDImageCoderDecodeThumbnailPixelSize] = @(pixelSize);
+    mutableDecodeOptions[SDImageCoderDecodePreserveAspectRatio] = @(preserveAspectRatio);
+    thumbnailImage.sd_decodeOptions = [mutableDecodeOptions copy];
+    
+    return thumbnailImage;
+}
+
 - (BOOL)shouldBlockFailedURLWithURL:(nonnull NSURL *)url
                               error:(nonnull NSError *)error
                             options:(SDWebImageOptions)options
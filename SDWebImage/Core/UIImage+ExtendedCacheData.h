@@ -21,4 +21,11 @@
  */
 @property (nonatomic, strong, nullable) id<NSObject, NSCoding> sd_extendedObject;
 
+/**
+ Read and Write the HTTP cache validators and bind it to the image. The keys are response header field names, currently `ETag` and `Last-Modified`.
+ The image downloaded from network contains the validators from its response, and the disk cache preserve it with the same cache key, which is used to revalidate the cached image. See `SDWebImageRefreshCachedWithValidators`.
+ @note For manual query, use the `SDDiskCache` protocol method `cacheValidatorsForKey:` instead.
+ */
+@property (nonatomic, copy, nullable) NSDictionary<NSString *, NSString *> *sd_cacheValidators;
+
 @end
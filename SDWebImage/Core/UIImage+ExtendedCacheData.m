@@ -20,4 +20,12 @@
     objc_setAssociatedObject(self, @selector(sd_extendedObject), sd_extendedObject, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
+- (NSDictionary<NSString *,NSString *> *)sd_cacheValidators {
+    return objc_getAssociatedObject(self, @selector(sd_cacheValidators));
+}
+
+- (void)setSd_cacheValidators:(NSDictionary<NSString *,NSString *> *)sd_cacheValidators {
+    objc_setAssociatedObject(self, @selector(sd_cacheValidators), sd_cacheValidators, OBJC_ASSOCIATION_COPY_NONATOMIC);
+}
+
 @end
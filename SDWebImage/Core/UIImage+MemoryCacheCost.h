@@ -8,6 +8,13 @@
 
 #import "SDWebImageCompat.h"
 
+/**
+ Posted when the memory cost of an image changed, the notification object is the image. For example, `SDAnimatedImage` post this when frames are pre-loaded, or buffered and evicted by the animation players, the changes are coalesced and posted asynchronously on the main queue.
+ `SDMemoryCache` observes this to update the cost of the cached image incrementally, so the `maxMemoryCost` is respected.
+ @note This may be posted on any thread.
+ */
+FOUNDATION_EXPORT NSNotificationName _Nonnull const SDImageMemoryCostDidChangeNotification;
+
 /**
  UIImage category for memory cache cost.
  */
@@ -20,7 +27,8 @@
  For `UIImage`, this method return the single frame bytes size when `image.images` is nil for static image. Return full frame bytes size when `image.images` is not nil for animated image.
  For `NSImage`, this method return the single frame bytes size because `NSImage` does not store all frames in memory.
  @note Note that because of the limitations of category this property can get out of sync if you create another instance with CGImage or other methods.
- @note For custom animated class conforms to `SDAnimatedImage`, you can override this getter method in your subclass to return a more proper value instead, which representing the current frame's total bytes.
+ @note For custom animated class conforms to `SDAnimatedImage`, you can override this getter method in your subclass to return a more proper value instead, which representing the current frame's total bytes. Post `SDImageMemoryCostDidChangeNotification` when the value changed.
+ @note For `SDAnimatedImage`, this return the bytes of the poster frame, the pre-loaded frames, and the frames buffered by all the players (`SDAnimatedImagePlayer`) currently playing it.
  */
 @property (assign, nonatomic) NSUInteger sd_memoryCost;
 
@@ -10,6 +10,8 @@
 #import "objc/runtime.h"
 #import "NSImage+Compatibility.h"
 
+NSNotificationName const SDImageMemoryCostDidChangeNotification = @"SDImageMemoryCostDidChangeNotification";
+
 FOUNDATION_STATIC_INLINE NSUInteger SDMemoryCacheCostForImage(UIImage *image) {
     CGImageRef imageRef = image.CGImage;
     if (!imageRef) {
@@ -57,6 +57,13 @@ typedef void(^SDSetImageBlock)(UIImage * _Nullable image, NSData * _Nullable ima
  */
 @property (nonatomic, strong, null_resettable) NSProgress *sd_imageProgress;
 
+/**
+ * The thumbnail pixel size derived from the view's bounds, content mode and screen scale, used by `SDWebImageAutomaticThumbnailPixelSize`. The result is bucketed by `SDBucketedThumbnailPixelSize`.
+ * For aspect fit (`UIViewContentModeScaleAspectFit`, `NSImageScaleProportionallyDown/UpOrDown`), this is the view's pixel size. For aspect fill and scale to fill (`UIViewContentModeScaleAspectFill/ScaleToFill/Redraw`, `NSImageScaleAxesIndependently`), this is a square of the view's longer pixel length, so the thumbnail still covers the view for most of the aspect ratios.
+ * @note Return `CGSizeZero` when the view has zero bounds, or the content mode does not scale the image (like `UIViewContentModeCenter`), which means decoding in full pixel size. Subclass can override this to provide custom size.
+ */
+@property (nonatomic, assign, readonly) CGSize sd_automaticThumbnailPixelSize;
+
 /**
  * Set the imageView `image` with an `url` and optionally a placeholder image.
  *
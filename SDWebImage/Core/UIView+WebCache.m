@@ -14,6 +14,7 @@
 #import "SDWebImageTransitionInternal.h"
 #import "SDImageCache.h"
 #import "SDCallbackQueue.h"
+#import "SDDeviceHelper.h"
 
 const int64_t SDWebImageProgressUnitCountUnknown = 1LL;
 
@@ -55,6 +56,61 @@ const int64_t SDWebImageProgressUnitCountUnknown = 1LL;
     [self sd_setImageLoadState:loadState forKey:self.sd_latestOperationKey];
 }
 
+- (CGSize)sd_automaticThumbnailPixelSize {
+#if SD_UIKIT || SD_MAC
+    CGSize size = self.bounds.size;
+    if (size.width <= 0 || size.height <= 0) {
+        return CGSizeZero;
+    }
+    BOOL aspectFit;
+#if SD_UIKIT
+    switch (self.contentMode) {
+        case UIViewContentModeScaleAspectFit:
+            aspectFit = YES;
+            break;
+        case UIViewContentModeScaleToFill:
+        case UIViewContentModeScaleAspectFill:
+        case UIViewContentModeRedraw:
+            aspectFit = NO;
+            break;
+        default:
+            // The image is not scaled, thumbnail changes the display size
+            return CGSizeZero;
+    }
+    CGFloat scale = self.traitCollection.displayScale;
+#else
+    aspectFit = YES;
+    if ([self respondsToSelector:@selector(imageScaling)]) {
+        // NSImageView, NSButton
+        switch (((NSImageView *)self).imageScaling) {
+            case NSImageScaleProportionallyDown:
+            case NSImageScaleProportionallyUpOrDown:
+                aspectFit = YES;
+                break;
+            case NSImageScaleAxesIndependently:
+                aspectFit = NO;
+                break;
+            default:
+                return CGSizeZero;
+        }
+    }
+    CGFloat scale = self.window.backingScaleFactor;
+#endif
+    if (scale <= 0) {
+        // Not in the view hierarchy yet
+        scale = [SDDeviceHelper screenScale];
+    }
+    CGSize pixelSize = CGSizeMake(size.width * scale, size.height * scale);
+    if (!aspectFit) {
+        CGFloat length = MAX(pixelSize.width, pixelSize.height);
+        pixelSize = CGSizeMake(length, length);
+    }
+    return SDBucketedThumbnailPixelSize(pixelSize);
+#else
+    return CGSizeZero;
+#endif
+}
+
 - (nullable id<SDWebImageOperation>)sd_internalSetImageWithURL:(nullable NSURL *)url
                                               placeholderImage:(nullable UIImage *)placeholder
                                                        options:(SDWebImageOptions)options
@@ -89,6 +145,15 @@ const int64_t SDWebImageProgressUnitCountUnknown = 1LL;
         context = [mutableContext copy];
     }
     self.sd_latestOperationKey = validOperationKey;
+    if (SD_OPTIONS_CONTAINS(options, SDWebImageAutomaticThumbnailPixelSize) && !context[SDWebImageContextImageThumbnailPixelSize]) {
+        // derive the thumbnail size from view, before the cache key is calculated
+        CGSize thumbnailPixelSize = self.sd_automaticThumbnailPixelSize;
+        if (thumbnailPixelSize.width > 0 && thumbnailPixelSize.height > 0) {
+            SDWebImageMutableContext *mutableContext = [context mutableCopy];
+            mutableContext[SDWebImageContextImageThumbnailPixelSize] = @(thumbnailPixelSize);
+            context = [mutableContext copy];
+        }
+    }
     if (!(SD_OPTIONS_CONTAINS(options, SDWebImageAvoidAutoCancelImage))) {
         // cancel previous loading for the same set-image operation key by default
         [self sd_cancelImageLoadOperationWithKey:validOperationKey];
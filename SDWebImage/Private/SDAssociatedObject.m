@@ -26,4 +26,5 @@ void SDImageCopyAssociatedObject(UIImage * _Nullable source, UIImage * _Nullable
     target.sd_isDecoded = source.sd_isDecoded;
     // Extended Cache Data
     target.sd_extendedObject = source.sd_extendedObject;
+    target.sd_cacheValidators = source.sd_cacheValidators;
 }
@@ -20,6 +20,16 @@
 
 + (nonnull instancetype)displayLinkWithTarget:(nonnull id)target selector:(nonnull SEL)sel;
 
+/// Create a display link which shares one underlying display link with all the other shared display links of the same runloop mode. All running targets are called in a single pass on each refresh, ordered and grouped by their next fire time.
+/// @note For shared display link, `duration` is the elapsed time since the previous callback of this target, which may be longer than one refresh when using `scheduleNextCallbackAfter:`. Only main runloop is supported.
++ (nonnull instancetype)sharedDisplayLinkWithTarget:(nonnull id)target selector:(nonnull SEL)sel;
+
+@property (readonly, nonatomic) BOOL isShared;
+@property (readonly, nonatomic) NSTimeInterval refreshDuration; // the duration of one display refresh. Always zero when display link not running
+
+/// Skip the callbacks until the delay elapsed, only affect the next callback. The target which does not need to update on each refresh can use this to avoid the callback overhead. Only for shared display link, ignored otherwise
+- (void)scheduleNextCallbackAfter:(NSTimeInterval)delay;
+
 - (void)addToRunLoop:(nonnull NSRunLoop *)runloop forMode:(nonnull NSRunLoopMode)mode;
 - (void)removeFromRunLoop:(nonnull NSRunLoop *)runloop forMode:(nonnull NSRunLoopMode)mode;
 
@@ -25,8 +25,18 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
 
 #define kSDDisplayLinkInterval 1.0 / 60
 
+@class SDDisplayLinkHub;
+
 @interface SDDisplayLink ()
 
+// Shared display link, the underlying display link is owned by hub
+@property (nonatomic, assign, readwrite) BOOL isShared;
+@property (nonatomic, strong) SDDisplayLinkHub *hub;
+@property (nonatomic, assign) BOOL sharedRunning;
+@property (nonatomic, assign) NSTimeInterval fireTime; // the hub time to call the target
+@property (nonatomic, assign) NSTimeInterval lastFireTime; // the hub time of previous callback
+@property (nonatomic, assign) NSTimeInterval elapsedDuration;
+
 @property (nonatomic, assign) NSTimeInterval previousFireTime;
 @property (nonatomic, assign) NSTimeInterval nextFireTime;
 
@@ -42,6 +52,132 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
 @property (nonatomic, copy) NSRunLoopMode runloopMode;
 #endif
 
+- (void)fireSharedCallback;
+
+@end
+
+/// The owner of underlying display link for all shared display links of one runloop mode. The running clients are sorted by fire time, so each refresh only visits the due ones. Main thread only
+@interface SDDisplayLinkHub : NSObject
+
+@property (nonatomic, strong) SDDisplayLink *displayLink;
+@property (nonatomic, strong) NSMutableArray<SDDisplayLink *> *clients; // sorted by fire time
+@property (nonatomic, assign) NSTimeInterval time; // the sum of refresh durations since created
+@property (nonatomic, assign) NSTimeInterval refreshDuration;
+
+@end
+
+@implementation SDDisplayLinkHub
+
++ (instancetype)hubForRunLoopMode:(NSRunLoopMode)mode {
+    static NSMutableDictionary<NSRunLoopMode, SDDisplayLinkHub *> *hubs;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        hubs = [NSMutableDictionary dictionary];
+    });
+    SDDisplayLinkHub *hub = hubs[mode];
+    if (!hub) {
+        hub = [[SDDisplayLinkHub alloc] initWithRunLoopMode:mode];
+        hubs[mode] = hub;
+    }
+    return hub;
+}
+
+- (instancetype)initWithRunLoopMode:(NSRunLoopMode)mode {
+    self = [super init];
+    if (self) {
+        _clients = [NSMutableArray array];
+        _displayLink = [SDDisplayLink displayLinkWithTarget:self selector:@selector(displayLinkDidRefresh:)];
+        [_displayLink addToRunLoop:NSRunLoop.mainRunLoop forMode:mode];
+        [_displayLink stop];
+    }
+    return self;
+}
+
+- (void)addClient:(SDDisplayLink *)client {
+    if ([self.clients indexOfObjectIdenticalTo:client] != NSNotFound) {
+        return;
+    }
+    client.lastFireTime = self.time;
+    client.fireTime = self.time;
+    [self insertClient:client];
+    if (!self.displayLink.isRunning) {
+        [self.displayLink start];
+    }
+}
+
+- (void)removeClient:(SDDisplayLink *)client {
+    [self.clients removeObjectIdenticalTo:client];
+    if (self.clients.count == 0 && self.displayLink.isRunning) {
+        [self.displayLink stop];
+        self.refreshDuration = 0;
+    }
+}
+
+- (void)rescheduleClient:(SDDisplayLink *)client fireTime:(NSTimeInterval)fireTime {
+    client.fireTime = fireTime;
+    NSUInteger index = [self.clients indexOfObjectIdenticalTo:client];
+    if (index != NSNotFound) {
+        // Keep sorted
+        [self.clients removeObjectAtIndex:index];
+        [self insertClient:client];
+    }
+}
+
+// Binary insert after the clients with the same or earlier fire time
+- (void)insertClient:(SDDisplayLink *)client {
+    NSUInteger low = 0;
+    NSUInteger high = self.clients.count;
+    while (low < high) {
+        NSUInteger mid = (low + high) / 2;
+        if (self.clients[mid].fireTime <= client.fireTime) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    [self.clients insertObject:client atIndex:low];
+}
+
+- (void)displayLinkDidRefresh:(SDDisplayLink *)displayLink {
+    NSTimeInterval duration = displayLink.duration;
+    self.refreshDuration = duration;
+    self.time += duration;
+    // The client due within half refresh is called in this pass, the others wait for later refresh
+    NSTimeInterval deadline = self.time + duration / 2;
+    NSUInteger dueCount = 0;
+    while (dueCount < self.clients.count && self.clients[dueCount].fireTime <= deadline) {
+        dueCount++;
+    }
+    if (dueCount == 0) {
+        return;
+    }
+    NSArray<SDDisplayLink *> *dueClients = [self.clients subarrayWithRange:NSMakeRange(0, dueCount)];
+    [self.clients removeObjectsInRange:NSMakeRange(0, dueCount)];
+    for (SDDisplayLink *client in dueClients) {
+        // May be stopped or moved by the previous callback
+        if (!client.sharedRunning || client.hub != self) {
+            continue;
+        }
+        if (!client.target) {
+            // Target released without stop
+            client.sharedRunning = NO;
+            continue;
+        }
+        client.elapsedDuration = self.time - client.lastFireTime;
+        client.lastFireTime = self.time;
+        // Defaults to next refresh
+        client.fireTime = self.time;
+        [client fireSharedCallback];
+        if (client.sharedRunning && client.hub == self && [self.clients indexOfObjectIdenticalTo:client] == NSNotFound) {
+            [self insertClient:client];
+        }
+    }
+    if (self.clients.count == 0) {
+        [self.displayLink stop];
+        self.refreshDuration = 0;
+    }
+}
+
 @end
 
 @implementation SDDisplayLink
@@ -93,9 +229,48 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
     return displayLink;
 }
 
+- (instancetype)initSharedWithTarget:(id)target selector:(SEL)sel {
+    self = [super init];
+    if (self) {
+        _target = target;
+        _selector = sel;
+        _isShared = YES;
+    }
+    return self;
+}
+
++ (instancetype)sharedDisplayLinkWithTarget:(id)target selector:(SEL)sel {
+    SDDisplayLink *displayLink = [[SDDisplayLink alloc] initSharedWithTarget:target selector:sel];
+    return displayLink;
+}
+
+- (NSTimeInterval)refreshDuration {
+    if (self.isShared) {
+        return self.sharedRunning ? self.hub.refreshDuration : 0;
+    }
+    return self.duration;
+}
+
+- (void)scheduleNextCallbackAfter:(NSTimeInterval)delay {
+    if (!self.isShared || !self.hub) {
+        return;
+    }
+    [self.hub rescheduleClient:self fireTime:self.hub.time + MAX(delay, 0)];
+}
+
+- (void)fireSharedCallback {
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Warc-performSelector-leaks"
+    [_target performSelector:_selector withObject:self];
+#pragma clang diagnostic pop
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunguarded-availability"
 - (NSTimeInterval)duration {
+    if (self.isShared) {
+        return self.sharedRunning ? self.elapsedDuration : 0;
+    }
     NSTimeInterval duration = 0;
 #if SD_MAC
     CVTimeStamp outputTime = self.outputTime;
@@ -162,6 +337,9 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
 #pragma clang diagnostic pop
 
 - (BOOL)isRunning {
+    if (self.isShared) {
+        return self.sharedRunning;
+    }
 #if SD_MAC
     return CVDisplayLinkIsRunning(self.displayLink);
 #elif SD_UIKIT
@@ -175,6 +353,13 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
     if  (!runloop || !mode) {
         return;
     }
+    if (self.isShared) {
+        self.hub = [SDDisplayLinkHub hubForRunLoopMode:mode];
+        if (self.sharedRunning) {
+            [self.hub addClient:self];
+        }
+        return;
+    }
 #if SD_MAC
     self.runloopMode = mode;
 #elif SD_UIKIT
@@ -198,6 +383,11 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
     if  (!runloop || !mode) {
         return;
     }
+    if (self.isShared) {
+        [self.hub removeClient:self];
+        self.hub = nil;
+        return;
+    }
 #if SD_MAC
     self.runloopMode = nil;
 #elif SD_UIKIT
@@ -218,6 +408,15 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
 }
 
 - (void)start {
+    if (self.isShared) {
+        if (self.sharedRunning) {
+            return;
+        }
+        self.sharedRunning = YES;
+        self.elapsedDuration = 0;
+        [self.hub addClient:self];
+        return;
+    }
 #if SD_MAC
     CVDisplayLinkStart(self.displayLink);
 #elif SD_UIKIT
@@ -234,6 +433,12 @@ static BOOL kSDDisplayLinkUseTargetTimestamp = NO; // Use `next` fire time, or `
 }
 
 - (void)stop {
+    if (self.isShared) {
+        self.sharedRunning = NO;
+        self.elapsedDuration = 0;
+        [self.hub removeClient:self];
+        return;
+    }
 #if SD_MAC
     CVDisplayLinkStop(self.displayLink);
 #elif SD_UIKIT
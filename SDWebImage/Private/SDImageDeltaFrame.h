@@ -0,0 +1,47 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// The full canvas bitmap of an animated image, which the delta frames are based on. The bitmap is BGRA8888 premultiplied.
+@interface SDImageDeltaKeyframe : NSObject
+
+/// Create the keyframe by drawing the image into bitmap, return nil if failed, or the image is not 8-bit sRGB (such as wide color or HDR), which can not be stored without loss
+- (nullable instancetype)initWithImage:(UIImage *)image;
+- (instancetype)init NS_UNAVAILABLE;
+
+/// The image which reference the keyframe bitmap without copy
+@property (nonatomic, strong, readonly) UIImage *image;
+/// The bytes of the keyframe bitmap
+@property (nonatomic, assign, readonly) NSUInteger bytes;
+
+@end
+
+/// A frame stored as the dirty rect patch against the keyframe. The full frame is composed on demand.
+@interface SDImageDeltaFrame : NSObject
+
+/// Create the delta frame by comparing the image with the keyframe.
+/// Return nil if the image does not match the keyframe canvas, the image is not 8-bit sRGB (such as wide color or HDR), or the patch is not small enough to save memory (more than half of the canvas), store the full frame instead in this case.
++ (nullable instancetype)deltaFrameWithImage:(UIImage *)image keyframe:(SDImageDeltaKeyframe *)keyframe;
+
+/// The keyframe, retained by each delta frame
+@property (nonatomic, strong, readonly) SDImageDeltaKeyframe *keyframe;
+/// The dirty rect in pixel, the origin is the top-left of canvas. Empty if the frame is the same as the keyframe
+@property (nonatomic, assign, readonly) CGRect dirtyRect;
+/// The bytes of the patch bitmap, not including the keyframe
+@property (nonatomic, assign, readonly) NSUInteger bytes;
+
+/// Compose the full frame, by copying the keyframe and the patch into a buffer from `SDImageBufferPool`, the buffer is reused after the image is freed.
+- (nullable UIImage *)composedImage;
+
+@end
+
+NS_ASSUME_NONNULL_END
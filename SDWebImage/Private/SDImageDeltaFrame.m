@@ -0,0 +1,235 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import "SDImageDeltaFrame.h"
+#import "SDImageCoderHelper.h"
+#import "SDImageBufferPool.h"
+#import "UIImage+ForceDecode.h"
+#import "NSImage+Compatibility.h"
+
+// BGRA8888 premultiplied, the same as what `SDImageCoderHelper` force decode produce
+static const CGBitmapInfo kSDImageDeltaBitmapInfo = kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst;
+
+// Only the 8-bit sRGB (device RGB) bitmap can be stored without losing the precision or color gamut, the wide color (Display P3) and HDR frames should be stored as full frame
+static BOOL SDImageDeltaSupportsImage(CGImageRef imageRef) {
+    if (!imageRef || CGImageGetBitsPerComponent(imageRef) != 8) {
+        return NO;
+    }
+    CGColorSpaceRef colorSpace = CGImageGetColorSpace(imageRef);
+    if (!colorSpace || CGColorSpaceGetModel(colorSpace) != kCGColorSpaceModelRGB) {
+        return NO;
+    }
+    CGColorSpaceRef deviceColorSpace = [SDImageCoderHelper colorSpaceGetDeviceRGB];
+    if (colorSpace == deviceColorSpace || CFEqual(colorSpace, deviceColorSpace)) {
+        return YES;
+    }
+    NSString *colorSpaceName = (__bridge_transfer NSString *)CGColorSpaceCopyName(colorSpace);
+    return [colorSpaceName isEqualToString:(__bridge NSString *)kCGColorSpaceSRGB] || [colorSpaceName isEqualToString:(__bridge NSString *)kCGColorSpaceDeviceRGB];
+}
+
+static BOOL SDImageDeltaDrawImage(CGImageRef imageRef, void *buffer, size_t width, size_t height, size_t bytesPerRow) {
+    // Clear the buffer, the transparent pixels should not keep the previous content
+    memset(buffer, 0, bytesPerRow * height);
+    CGContextRef context = CGBitmapContextCreate(buffer, width, height, 8, bytesPerRow, [SDImageCoderHelper colorSpaceGetDeviceRGB], kSDImageDeltaBitmapInfo);
+    if (!context) {
+        return NO;
+    }
+    CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+    CGContextRelease(context);
+    return YES;
+}
+
+static UIImage * SDImageDeltaCreateImage(CGDataProviderRef provider, size_t width, size_t height, size_t bytesPerRow, CGFloat scale) {
+    CGImageRef imageRef = CGImageCreate(width, height, 8, 32, bytesPerRow, [SDImageCoderHelper colorSpaceGetDeviceRGB], kSDImageDeltaBitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+    if (!imageRef) {
+        return nil;
+    }
+#if SD_MAC
+    UIImage *image = [[UIImage alloc] initWithCGImage:imageRef scale:scale orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *image = [[UIImage alloc] initWithCGImage:imageRef scale:scale orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(imageRef);
+    // The bitmap can be rendered directly, don't force decode again
+    image.sd_isDecoded = YES;
+    return image;
+}
+
+@interface SDImageDeltaKeyframe ()
+
+@property (nonatomic, strong) NSData *data;
+@property (nonatomic, assign) size_t width;
+@property (nonatomic, assign) size_t height;
+@property (nonatomic, assign) size_t bytesPerRow;
+@property (nonatomic, assign) CGFloat scale;
+
+@end
+
+@implementation SDImageDeltaKeyframe
+
+- (instancetype)initWithImage:(UIImage *)image {
+    self = [super init];
+    if (self) {
+        CGImageRef imageRef = image.CGImage;
+        if (!SDImageDeltaSupportsImage(imageRef)) {
+            return nil;
+        }
+        size_t width = CGImageGetWidth(imageRef);
+        size_t height = CGImageGetHeight(imageRef);
+        if (width == 0 || height == 0) {
+            return nil;
+        }
+        size_t bytesPerRow = SDByteAlign(width * 4, 64);
+        NSMutableData *data = [NSMutableData dataWithLength:bytesPerRow * height];
+        if (!data || !SDImageDeltaDrawImage(imageRef, data.mutableBytes, width, height, bytesPerRow)) {
+            return nil;
+        }
+        CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)data);
+        if (!provider) {
+            return nil;
+        }
+        _image = SDImageDeltaCreateImage(provider, width, height, bytesPerRow, image.scale);
+        CGDataProviderRelease(provider);
+        if (!_image) {
+            return nil;
+        }
+        // Not copy, the image reference the same bytes
+        _data = data;
+        _width = width;
+        _height = height;
+        _bytesPerRow = bytesPerRow;
+        _scale = image.scale;
+    }
+    return self;
+}
+
+- (NSUInteger)bytes {
+    return self.data.length;
+}
+
+@end
+
+@interface SDImageDeltaFrame ()
+
+@property (nonatomic, strong, readwrite) SDImageDeltaKeyframe *keyframe;
+@property (nonatomic, assign, readwrite) CGRect dirtyRect;
+@property (nonatomic, strong) NSData *patch; // the bitmap of dirty rect, the bytes per row is `dirtyRect.size.width * 4`
+
+@end
+
+@implementation SDImageDeltaFrame
+
++ (instancetype)deltaFrameWithImage:(UIImage *)image keyframe:(SDImageDeltaKeyframe *)keyframe {
+    CGImageRef imageRef = image.CGImage;
+    if (!SDImageDeltaSupportsImage(imageRef)) {
+        return nil;
+    }
+    size_t width = keyframe.width;
+    size_t height = keyframe.height;
+    size_t bytesPerRow = keyframe.bytesPerRow;
+    if (CGImageGetWidth(imageRef) != width || CGImageGetHeight(imageRef) != height || image.scale != keyframe.scale) {
+        return nil;
+    }
+    size_t length = keyframe.data.length;
+    uint8_t *buffer = [SDImageBufferPool.sharedPool allocateBufferWithLength:length];
+    if (!buffer) {
+        return nil;
+    }
+    if (!SDImageDeltaDrawImage(imageRef, buffer, width, height, bytesPerRow)) {
+        [SDImageBufferPool.sharedPool recycleBuffer:buffer length:length];
+        return nil;
+    }
+
+    // Find the bounding box of changed pixels, bottom and right are exclusive
+    const uint8_t *keyBytes = keyframe.data.bytes;
+    size_t top = height, bottom = 0, left = width, right = 0;
+    for (size_t y = 0; y < height; y++) {
+        const uint32_t *row = (const uint32_t *)(buffer + y * bytesPerRow);
+        const uint32_t *keyRow = (const uint32_t *)(keyBytes + y * bytesPerRow);
+        if (memcmp(row, keyRow, width * 4) == 0) {
+            continue;
+        }
+        if (top == height) {
+            top = y;
+        }
+        bottom = y + 1;
+        // Only need to scan the pixels outside current box
+        size_t x = 0;
+        while (x < left && row[x] == keyRow[x]) {
+            x++;
+        }
+        left = x;
+        x = width;
+        while (x > right && row[x - 1] == keyRow[x - 1]) {
+            x--;
+        }
+        right = x;
+    }
+
+    SDImageDeltaFrame *frame = [SDImageDeltaFrame new];
+    frame.keyframe = keyframe;
+    if (top == height) {
+        // Same as the keyframe
+        frame.dirtyRect = CGRectZero;
+        [SDImageBufferPool.sharedPool recycleBuffer:buffer length:length];
+        return frame;
+    }
+    size_t patchBytesPerRow = (right - left) * 4;
+    size_t patchHeight = bottom - top;
+    if (patchBytesPerRow * patchHeight > length / 2) {
+        // Not worth, the composing cost is higher than the saved memory
+        [SDImageBufferPool.sharedPool recycleBuffer:buffer length:length];
+        return nil;
+    }
+    NSMutableData *patch = [NSMutableData dataWithLength:patchBytesPerRow * patchHeight];
+    uint8_t *patchBytes = patch.mutableBytes;
+    for (size_t y = 0; y < patchHeight; y++) {
+        memcpy(patchBytes + y * patchBytesPerRow, buffer + (top + y) * bytesPerRow + left * 4, patchBytesPerRow);
+    }
+    [SDImageBufferPool.sharedPool recycleBuffer:buffer length:length];
+    frame.dirtyRect = CGRectMake(left, top, right - left, patchHeight);
+    frame.patch = patch;
+    return frame;
+}
+
+- (NSUInteger)bytes {
+    return self.patch.length;
+}
+
+- (UIImage *)composedImage {
+    SDImageDeltaKeyframe *keyframe = self.keyframe;
+    CGRect dirtyRect = self.dirtyRect;
+    if (CGRectIsEmpty(dirtyRect)) {
+        return keyframe.image;
+    }
+    size_t length = keyframe.data.length;
+    size_t bytesPerRow = keyframe.bytesPerRow;
+    uint8_t *buffer = [SDImageBufferPool.sharedPool allocateBufferWithLength:length];
+    if (!buffer) {
+        return nil;
+    }
+    memcpy(buffer, keyframe.data.bytes, length);
+    size_t left = (size_t)dirtyRect.origin.x;
+    size_t top = (size_t)dirtyRect.origin.y;
+    size_t patchBytesPerRow = (size_t)dirtyRect.size.width * 4;
+    size_t patchHeight = (size_t)dirtyRect.size.height;
+    const uint8_t *patchBytes = self.patch.bytes;
+    for (size_t y = 0; y < patchHeight; y++) {
+        memcpy(buffer + (top + y) * bytesPerRow + left * 4, patchBytes + y * patchBytesPerRow, patchBytesPerRow);
+    }
+    // The buffer is returned to pool when the image is freed
+    CGDataProviderRef provider = [SDImageBufferPool.sharedPool createDataProviderWithBuffer:buffer length:length];
+    if (!provider) {
+        return nil;
+    }
+    UIImage *image = SDImageDeltaCreateImage(provider, keyframe.width, keyframe.height, bytesPerRow, keyframe.scale);
+    CGDataProviderRelease(provider);
+    return image;
+}
+
+@end
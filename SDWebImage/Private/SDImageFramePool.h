@@ -9,9 +9,23 @@
 #import <Foundation/Foundation.h>
 #import "SDWebImageCompat.h"
 #import "SDImageCoder.h"
+#import "SDAnimatedImagePlayer.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class SDImageFramePool;
+
+/// The provider which conforms to this get notified when the buffered bytes of frame pool changed, used for memory cost accounting
+@protocol SDImageFramePoolObserver <NSObject>
+
+/// Called when frames are buffered or evicted, may be called on any thread. The pool reports 0 when it's emptied or deallocated
+/// @warning This is called for each frame, and the dealloc may happen inside the global pool lock, so do not post notification or do other expensive work synchronously, coalesce them asynchronously instead
+/// @param framePool The frame pool, only used as an identifier (do not retain it, it may be in deallocating)
+/// @param bufferBytes The current buffered bytes of the pool, see `currentBufferBytes`
+- (void)framePool:(SDImageFramePool *)framePool didUpdateBufferBytes:(NSUInteger)bufferBytes;
+
+@end
+
 /// A per-provider (provider means, AnimatedImage object) based frame pool, each player who use the same provider share the same frame buffer
 @interface SDImageFramePool : NSObject
 
@@ -21,20 +35,65 @@ NS_ASSUME_NONNULL_BEGIN
 + (void)unregisterProvider:(id<SDAnimatedImageProvider>)provider;
 
 /// Prefetch the current frame, query using `frameAtIndex:` by caller to check whether finished.
+/// Multiple frames can be prefetched at the same time up to `maxConcurrentCount`, the frame which is already in buffer or being prefetched is ignored.
 - (void)prefetchFrameAtIndex:(NSUInteger)index;
+/// The number of frames being prefetched (including the pending ones)
+@property (nonatomic, readonly) NSUInteger prefetchingFrameCount;
+/// The average decode duration of one frame measured by prefetching, 0 if no frame decoded yet
+@property (atomic, readonly) NSTimeInterval averageDecodeDuration;
+/// The number of frames decoded by prefetching, used to measure the CPU usage
+@property (atomic, readonly) NSUInteger decodedFrameCount;
 
-/// Control the max buffer count for current frame pool, used for RAM/CPU balance, default unlimited
+/// Update the playhead of the player, used to choose the victim frames when the buffer is over `maxBufferCount`. The frame which will be displayed last by the playback is evicted first. If not provided, evict the least recently used frame.
+/// @param index The current displayed frame index
+/// @param playbackMode The playback mode
+/// @param reverse Whether the playback is currently moving from last frame to first frame, used for bounce mode
+- (void)updatePlayheadWithFrameIndex:(NSUInteger)index playbackMode:(SDAnimatedImagePlaybackMode)playbackMode reverse:(BOOL)reverse;
+
+/// Control the max buffer count for current frame pool, used for RAM/CPU balance, default unlimited (0)
 @property (nonatomic, assign) NSUInteger maxBufferCount;
 /// Control the max concurrent fetch queue operation count, used for CPU balance, default 1
 @property (nonatomic, assign) NSUInteger maxConcurrentCount;
 
+/// Whether to store the frame as dirty rect patch against a keyframe, the full frame is composed by `prepareFrameAtIndex:` ahead, or on demand when queried by `frameAtIndex:`. This reduce the buffer memory for the animation which only changes a small region, but cost more CPU to compare and compose the frames, default NO
+/// The first buffered frame become the keyframe, which is kept by the pool until all frames are removed or this is turned off. The frame whose patch is larger than half of canvas, or which is not 8-bit sRGB (such as wide color or HDR), is stored as full frame. When most of the frames are stored as full frame, the pool stops diffing and releases the keyframe
+/// @note This is shared by all the players of the same provider, see `SDAnimatedImagePlayer.storesDeltaFrames`
+@property (atomic, assign) BOOL storesDeltaFrames;
+
 // Frame Operations
 @property (nonatomic, readonly) NSUInteger currentFrameCount;
+/// The bytes of buffered frames, including the keyframe which delta frames based on, and the composed frames prepared ahead
+@property (nonatomic, readonly) NSUInteger currentBufferBytes;
 - (nullable UIImage *)frameAtIndex:(NSUInteger)index;
+/// Whether the frame is in buffer, without composing the delta frame
+- (BOOL)containsFrameAtIndex:(NSUInteger)index;
+/// Compose the buffered delta frame on the fetch queue ahead of display, so `frameAtIndex:` does not compose on the caller (main) thread. Do nothing if the frame is not buffered as delta frame
+- (void)prepareFrameAtIndex:(NSUInteger)index;
 - (void)setFrame:(nullable UIImage *)frame atIndex:(NSUInteger)index;
 - (void)removeFrameAtIndex:(NSUInteger)index;
 - (void)removeAllFrames;
 
+// Global Budget, shared by all frame pools
+/// The max total bytes of frame buffers shared by all active frame pools. 0 means automatically calculated from current memory, default 0
+@property (class, atomic) NSUInteger maxTotalBufferBytes;
+/// The bytes of frame buffer granted to this pool from the global budget, 0 if no player is active. Rebalanced when players activate and deactivate
+@property (atomic, readonly) NSUInteger budgetBytes;
+/// Mark the player as active (or update its demand), then rebalance the global budget. The budget is split by the frame bytes, frame rate and visibility of active players
+/// @param player The player, not retained
+/// @param frameBytes The bytes of one frame
+/// @param frameRate The frames displayed per second
+/// @param visible Whether the player is visible, the invisible players get a smaller share
+- (void)activatePlayer:(id)player frameBytes:(NSUInteger)frameBytes frameRate:(double)frameRate visible:(BOOL)visible;
+/// Mark the player as inactive, then rebalance the global budget
+- (void)deactivatePlayer:(id)player;
+
+// Buffer Statistics, used to measure the buffer miss rate
+@property (atomic, readonly) NSUInteger bufferHitCount;
+@property (atomic, readonly) NSUInteger bufferMissCount;
+/// Record whether the frame is in buffer when the player needs to display it
+- (void)recordBufferHit:(BOOL)hit;
+- (void)resetBufferStatistics;
+
 NS_ASSUME_NONNULL_END
 
 @end
@@ -9,6 +9,30 @@
 #import "SDImageFramePool.h"
 #import "SDInternalMacros.h"
 #import "objc/runtime.h"
+#import "SDImageDecodeScheduler.h"
+#import "UIImage+MemoryCacheCost.h"
+#import "SDDeviceHelper.h"
+#import "SDImageDeltaFrame.h"
+#import <QuartzCore/QuartzCore.h>
+
+// The frame buffer demand of one active player
+@interface SDImageFramePoolDemand : NSObject
+
+@property (nonatomic, assign) NSUInteger frameBytes;
+@property (nonatomic, assign) double frameRate;
+@property (nonatomic, assign) BOOL visible;
+
+@end
+
+@implementation SDImageFramePoolDemand
+@end
+
+// The share weight of invisible players, relative to the visible ones
+static const double kSDImageFramePoolInvisibleWeight = 0.1;
+// The max number of delta frames composed ahead, only the upcoming frames are needed
+static const NSUInteger kSDImageFramePoolMaxComposedFrameCount = 2;
+// The number of frames tried as delta frame before giving up, when most of them change more than half of the canvas
+static const NSUInteger kSDImageFramePoolDeltaFrameProbeCount = 8;
 
 @interface SDImageFramePool ()
 
@@ -17,15 +41,45 @@
 @property (weak) id<SDAnimatedImageProvider> provider;
 @property (atomic) NSUInteger registerCount;
 
-@property (nonatomic, strong) NSMutableDictionary<NSNumber *, UIImage *> *frameBuffer;
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, id> *frameBuffer; // the value is `UIImage` or `SDImageDeltaFrame`
+@property (nonatomic, strong) SDImageDeltaKeyframe *keyframe; // kept until the frames are removed or delta frames are disabled, protected by `@synchronized (self)`
+@property (nonatomic, assign) NSUInteger deltaFrameCount; // the number of frames stored as delta frame, protected by `@synchronized (self)`
+@property (nonatomic, assign) NSUInteger fullFrameCount; // the number of frames rejected as delta frame, protected by `@synchronized (self)`
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, UIImage *> *composedFrames; // the delta frames composed ahead, protected by `@synchronized (self)`
+@property (nonatomic, strong) NSMutableIndexSet *composingIndexes; // protected by `@synchronized (self)`
 @property (nonatomic, strong) NSOperationQueue *fetchQueue;
+@property (atomic) NSUInteger frameCost; // the last decoded frame bytes, used as the decode cost of next frame
+@property (nonatomic, assign) NSUInteger totalFrameCount;
+@property (nonatomic, strong) NSMutableIndexSet *prefetchingIndexes; // protected by `@synchronized (self)`
+@property (atomic, readwrite) NSTimeInterval averageDecodeDuration;
+@property (atomic, readwrite) NSUInteger decodedFrameCount;
+@property (nonatomic, assign) NSUInteger bufferBytes; // the running bytes of buffered frames, keyframes and composed frames, protected by `@synchronized (self)`
+@property (nonatomic, strong) NSCountedSet<SDImageDeltaKeyframe *> *keyframeReferences; // the number of buffered delta frames (and the pool itself) holding each keyframe, protected by `@synchronized (self)`
+@property (nonatomic, assign) NSUInteger reportedBufferBytes; // the last bytes reported to provider, protected by `@synchronized (self)`
+
+// Eviction, protected by `@synchronized (self)`
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, NSNumber *> *frameAccessStamps; // the access stamp of each frame, used for LRU
+@property (nonatomic, assign) NSUInteger accessStamp;
+@property (nonatomic, assign) BOOL hasPlayhead;
+@property (nonatomic, assign) NSUInteger playheadIndex;
+@property (nonatomic, assign) SDAnimatedImagePlaybackMode playbackMode;
+@property (nonatomic, assign) BOOL playbackReverse;
+
+@property (atomic, readwrite) NSUInteger bufferHitCount;
+@property (atomic, readwrite) NSUInteger bufferMissCount;
+
+// Global Budget, protected by `_providerFramePoolMapLock`
+@property (nonatomic, strong) NSMapTable<id, SDImageFramePoolDemand *> *playerDemands; // the key is not retained, player must deactivate before dealloc
+@property (atomic, readwrite) NSUInteger budgetBytes;
 
 @end
 
 // Lock to ensure atomic behavior
 SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
+static NSUInteger _maxTotalBufferBytes = 0;
 
 @implementation SDImageFramePool
+@synthesize storesDeltaFrames = _storesDeltaFrames;
 
 + (NSMapTable *)providerFramePoolMap {
     static NSMapTable *providerFramePoolMap;
@@ -42,6 +96,12 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
     self = [super init];
     if (self) {
         _frameBuffer = [NSMutableDictionary dictionary];
+        _frameAccessStamps = [NSMutableDictionary dictionary];
+        _prefetchingIndexes = [NSMutableIndexSet indexSet];
+        _composedFrames = [NSMutableDictionary dictionary];
+        _keyframeReferences = [NSCountedSet set];
+        _composingIndexes = [NSMutableIndexSet indexSet];
+        _playerDemands = [NSMapTable mapTableWithKeyOptions:NSPointerFunctionsOpaqueMemory | NSPointerFunctionsOpaquePersonality valueOptions:NSPointerFunctionsStrongMemory | NSPointerFunctionsObjectPersonality];
         _fetchQueue = [[NSOperationQueue alloc] init];
         _fetchQueue.maxConcurrentOperationCount = 1;
         _fetchQueue.name = @"com.hackemist.SDImageFramePool.fetchQueue";
@@ -56,6 +116,12 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
 #if SD_UIKIT
     [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
 #endif
+    if (_reportedBufferBytes > 0) {
+        id<SDAnimatedImageProvider> provider = _provider;
+        if ([provider conformsToProtocol:@protocol(SDImageFramePoolObserver)]) {
+            [(id<SDImageFramePoolObserver>)provider framePool:self didUpdateBufferBytes:0];
+        }
+    }
 }
 
 - (void)didReceiveMemoryWarning:(NSNotification *)notification {
@@ -74,6 +140,7 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
     if (!framePool) {
         framePool = [[SDImageFramePool alloc] init];
         framePool.provider = provider;
+        framePool.totalFrameCount = provider.animatedImageFrameCount;
         [self.providerFramePoolMap setObject:framePool forKey:provider];
     }
     framePool.registerCount += 1;
@@ -92,38 +159,93 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
     framePool.registerCount -= 1;
     if (framePool.registerCount == 0) {
         [self.providerFramePoolMap removeObjectForKey:provider];
+        // Give back the budget
+        if (framePool.playerDemands.count > 0) {
+            [framePool.playerDemands removeAllObjects];
+            [self rebalanceBudget];
+        }
     }
     SD_UNLOCK(_providerFramePoolMapLock);
 }
 
 - (void)prefetchFrameAtIndex:(NSUInteger)index {
     @synchronized (self) {
-        NSUInteger frameCount = self.frameBuffer.count;
-        if (frameCount > self.maxBufferCount) {
-            // Remove the frame buffer if need
-            // TODO, use LRU or better algorithm to detect which frames to clear
-            self.frameBuffer[@(index - 1)] = nil;
-            self.frameBuffer[@(index + 1)] = nil;
+        if (self.frameBuffer[@(index)] || [self.prefetchingIndexes containsIndex:index]) {
+            return;
         }
+        [self.prefetchingIndexes addIndex:index];
     }
     
-    if (self.fetchQueue.operationCount == 0) {
-        // Prefetch next frame in background queue
-        @weakify(self);
-        NSOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
-            @strongify(self);
-            if (!self) {
-                return;
-            }
-            id<SDAnimatedImageProvider> animatedProvider = self.provider;
-            if (!animatedProvider) {
-                return;
+    // Prefetch frame in background queue
+    @weakify(self);
+    NSOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+        @strongify(self);
+        if (!self) {
+            return;
+        }
+        id<SDAnimatedImageProvider> animatedProvider = self.provider;
+        if (!animatedProvider || ![self shouldPrefetchFrameAtIndex:index]) {
+            @synchronized (self) {
+                [self.prefetchingIndexes removeIndex:index];
             }
-            UIImage *frame = [animatedProvider animatedImageFrameAtIndex:index];
-            
-            [self setFrame:frame atIndex:index];
+            return;
+        }
+        __block UIImage *frame;
+        __block CFTimeInterval decodeDuration = 0;
+        [SDImageDecodeScheduler.sharedScheduler performWithCost:self.frameCost priority:SDImageDecodePriorityNormal block:^{
+            CFTimeInterval begin = CACurrentMediaTime();
+            frame = [animatedProvider animatedImageFrameAtIndex:index];
+            decodeDuration = CACurrentMediaTime() - begin;
         }];
-        [self.fetchQueue addOperation:operation];
+        if (frame) {
+            self.frameCost = frame.sd_memoryCost;
+            [self updateAverageDecodeDuration:decodeDuration];
+        }
+        // Encode in background, outside the lock
+        id bufferedFrame = [self bufferedFrameWithImage:frame];
+        
+        @synchronized (self) {
+            [self.prefetchingIndexes removeIndex:index];
+            [self storeBufferedFrame:bufferedFrame atIndex:index];
+        }
+        [self reportBufferBytes];
+    }];
+    [self.fetchQueue addOperation:operation];
+}
+
+- (NSUInteger)prefetchingFrameCount {
+    NSUInteger count = 0;
+    @synchronized (self) {
+        count = self.prefetchingIndexes.count;
+    }
+    return count;
+}
+
+// The playhead may moved during waiting, skip the frame which would be evicted immediately
+- (BOOL)shouldPrefetchFrameAtIndex:(NSUInteger)index {
+    @synchronized (self) {
+        if (self.maxBufferCount == 0 || !self.hasPlayhead) {
+            return YES;
+        }
+        return [self playbackDistanceToFrameAtIndex:index] <= self.maxBufferCount;
+    }
+}
+
+- (void)updateAverageDecodeDuration:(NSTimeInterval)decodeDuration {
+    @synchronized (self) {
+        self.decodedFrameCount += 1;
+        NSTimeInterval averageDecodeDuration = self.averageDecodeDuration;
+        // Exponential moving average, adapt to the recent frames quickly
+        self.averageDecodeDuration = averageDecodeDuration > 0 ? averageDecodeDuration * 0.8 + decodeDuration * 0.2 : decodeDuration;
+    }
+}
+
+- (void)updatePlayheadWithFrameIndex:(NSUInteger)index playbackMode:(SDAnimatedImagePlaybackMode)playbackMode reverse:(BOOL)reverse {
+    @synchronized (self) {
+        self.hasPlayhead = YES;
+        self.playheadIndex = index;
+        self.playbackMode = playbackMode;
+        self.playbackReverse = reverse;
     }
 }
 
@@ -131,6 +253,10 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
     self.fetchQueue.maxConcurrentOperationCount = maxConcurrentCount;
 }
 
+- (NSUInteger)maxConcurrentCount {
+    return self.fetchQueue.maxConcurrentOperationCount;
+}
+
 - (NSUInteger)currentFrameCount {
     NSUInteger frameCount = 0;
     @synchronized (self) {
@@ -140,28 +266,475 @@ SD_LOCK_DECLARE_STATIC(_providerFramePoolMapLock);
 }
 
 - (void)setFrame:(UIImage *)frame atIndex:(NSUInteger)index {
+    id bufferedFrame = [self bufferedFrameWithImage:frame];
     @synchronized (self) {
-        self.frameBuffer[@(index)] = frame;
+        [self storeBufferedFrame:bufferedFrame atIndex:index];
+    }
+    [self reportBufferBytes];
+}
+
+// Must be called under `@synchronized (self)`
+- (void)storeBufferedFrame:(id)frame atIndex:(NSUInteger)index {
+    [self setBufferedFrame:frame forKey:@(index)];
+    [self setComposedFrame:nil forKey:@(index)];
+    if (frame) {
+        [self touchFrameAtIndex:index];
+        // Keep the buffer within the limit, the new frame is requested explicitly so never evict it
+        [self evictFramesToCount:self.maxBufferCount excludingIndex:index];
+    } else {
+        self.frameAccessStamps[@(index)] = nil;
     }
 }
 
 - (UIImage *)frameAtIndex:(NSUInteger)index {
-    UIImage *frame;
+    id frame;
+    UIImage *composedFrame;
     @synchronized (self) {
         frame = self.frameBuffer[@(index)];
+        if (frame) {
+            [self touchFrameAtIndex:index];
+        }
+        // The composed frame is used once, the caller keeps it during display
+        composedFrame = self.composedFrames[@(index)];
+        [self setComposedFrame:nil forKey:@(index)];
+    }
+    if ([frame isKindOfClass:SDImageDeltaFrame.class]) {
+        if (composedFrame) {
+            return composedFrame;
+        }
+        // Not prepared ahead, compose outside the lock, the delta frame is immutable
+        return [(SDImageDeltaFrame *)frame composedImage];
     }
     return frame;
 }
 
+- (void)prepareFrameAtIndex:(NSUInteger)index {
+    SDImageDeltaFrame *deltaFrame;
+    @synchronized (self) {
+        id frame = self.frameBuffer[@(index)];
+        if (![frame isKindOfClass:SDImageDeltaFrame.class] || self.composedFrames[@(index)] || [self.composingIndexes containsIndex:index]) {
+            return;
+        }
+        if (self.composedFrames.count + self.composingIndexes.count >= kSDImageFramePoolMaxComposedFrameCount) {
+            return;
+        }
+        deltaFrame = frame;
+        [self.composingIndexes addIndex:index];
+    }
+    @weakify(self);
+    NSOperation *operation = [NSBlockOperation blockOperationWithBlock:^{
+        @strongify(self);
+        if (!self) {
+            return;
+        }
+        UIImage *composedFrame = [deltaFrame composedImage];
+        @synchronized (self) {
+            [self.composingIndexes removeIndex:index];
+            // The frame may be evicted during composing
+            if (composedFrame && self.frameBuffer[@(index)] == deltaFrame) {
+                [self setComposedFrame:composedFrame forKey:@(index)];
+            }
+        }
+    }];
+    [self.fetchQueue addOperation:operation];
+}
+
+- (BOOL)containsFrameAtIndex:(NSUInteger)index {
+    BOOL contains = NO;
+    @synchronized (self) {
+        contains = self.frameBuffer[@(index)] != nil;
+    }
+    return contains;
+}
+
+- (NSUInteger)currentBufferBytes {
+    NSUInteger bytes = 0;
+    @synchronized (self) {
+        bytes = self.bufferBytes;
+    }
+    return bytes;
+}
+
+// Must be called under `@synchronized (self)`. Replace the buffered frame and update the running bytes, the keyframe is shared by delta frames so count once
+- (void)setBufferedFrame:(id)frame forKey:(NSNumber *)key {
+    id oldFrame = self.frameBuffer[key];
+    if (oldFrame == frame) {
+        return;
+    }
+    if ([oldFrame isKindOfClass:SDImageDeltaFrame.class]) {
+        SDImageDeltaFrame *deltaFrame = oldFrame;
+        self.bufferBytes -= deltaFrame.bytes;
+        [self.keyframeReferences removeObject:deltaFrame.keyframe];
+        if ([self.keyframeReferences countForObject:deltaFrame.keyframe] == 0) {
+            self.bufferBytes -= deltaFrame.keyframe.bytes;
+        }
+    } else if (oldFrame) {
+        self.bufferBytes -= [(UIImage *)oldFrame sd_memoryCost];
+    }
+    if ([frame isKindOfClass:SDImageDeltaFrame.class]) {
+        SDImageDeltaFrame *deltaFrame = frame;
+        self.bufferBytes += deltaFrame.bytes;
+        if ([self.keyframeReferences countForObject:deltaFrame.keyframe] == 0) {
+            self.bufferBytes += deltaFrame.keyframe.bytes;
+        }
+        [self.keyframeReferences addObject:deltaFrame.keyframe];
+    } else if (frame) {
+        self.bufferBytes += [(UIImage *)frame sd_memoryCost];
+    }
+    self.frameBuffer[key] = frame;
+}
+
+// Must be called under `@synchronized (self)`
+- (void)setComposedFrame:(UIImage *)frame forKey:(NSNumber *)key {
+    UIImage *oldFrame = self.composedFrames[key];
+    if (oldFrame == frame) {
+        return;
+    }
+    self.bufferBytes -= oldFrame.sd_memoryCost;
+    self.bufferBytes += frame.sd_memoryCost;
+    self.composedFrames[key] = frame;
+}
+
+#pragma mark - Delta Frame
+
+- (BOOL)storesDeltaFrames {
+    @synchronized (self) {
+        return _storesDeltaFrames;
+    }
+}
+
+- (void)setStoresDeltaFrames:(BOOL)storesDeltaFrames {
+    @synchronized (self) {
+        if (_storesDeltaFrames == storesDeltaFrames) {
+            return;
+        }
+        _storesDeltaFrames = storesDeltaFrames;
+        // The buffered delta frames still hold the keyframe until evicted
+        [self resetKeyframe];
+    }
+    [self reportBufferBytes];
+}
+
+// Must be called under `@synchronized (self)`. Release the keyframe held by pool, and try delta frames again from the next frame
+- (void)resetKeyframe {
+    [self setRetainedKeyframe:nil];
+    self.deltaFrameCount = 0;
+    self.fullFrameCount = 0;
+}
+
+// Must be called under `@synchronized (self)`. The pool holds the keyframe as one reference, so its bytes are counted even if no delta frame is buffered
+- (void)setRetainedKeyframe:(SDImageDeltaKeyframe *)keyframe {
+    SDImageDeltaKeyframe *oldKeyframe = self.keyframe;
+    if (oldKeyframe == keyframe) {
+        return;
+    }
+    if (oldKeyframe) {
+        [self.keyframeReferences removeObject:oldKeyframe];
+        if ([self.keyframeReferences countForObject:oldKeyframe] == 0) {
+            self.bufferBytes -= oldKeyframe.bytes;
+        }
+    }
+    if (keyframe) {
+        if ([self.keyframeReferences countForObject:keyframe] == 0) {
+            self.bufferBytes += keyframe.bytes;
+        }
+        [self.keyframeReferences addObject:keyframe];
+    }
+    self.keyframe = keyframe;
+}
+
+// Convert the decoded frame into `SDImageDeltaFrame` against the keyframe if possible, else return the frame itself
+- (id)bufferedFrameWithImage:(UIImage *)image {
+    if (!image) {
+        return image;
+    }
+    SDImageDeltaKeyframe *keyframe;
+    @synchronized (self) {
+        if (!_storesDeltaFrames) {
+            return image;
+        }
+        // Most of frames change more than half of the canvas, stop diffing them
+        if (self.deltaFrameCount + self.fullFrameCount >= kSDImageFramePoolDeltaFrameProbeCount && self.fullFrameCount > self.deltaFrameCount) {
+            [self setRetainedKeyframe:nil];
+            return image;
+        }
+        keyframe = self.keyframe;
+    }
+    if (!keyframe) {
+        // The first buffered frame become the keyframe
+        keyframe = [[SDImageDeltaKeyframe alloc] initWithImage:image];
+        if (!keyframe) {
+            return image;
+        }
+        @synchronized (self) {
+            if (self.keyframe) {
+                keyframe = self.keyframe;
+            } else {
+                [self setRetainedKeyframe:keyframe];
+            }
+        }
+    }
+    SDImageDeltaFrame *deltaFrame = [SDImageDeltaFrame deltaFrameWithImage:image keyframe:keyframe];
+    @synchronized (self) {
+        if (deltaFrame) {
+            self.deltaFrameCount += 1;
+        } else {
+            self.fullFrameCount += 1;
+        }
+    }
+    return deltaFrame ?: image;
+}
+
 - (void)removeFrameAtIndex:(NSUInteger)index {
     @synchronized (self) {
-        self.frameBuffer[@(index)] = nil;
+        [self setBufferedFrame:nil forKey:@(index)];
+        self.frameAccessStamps[@(index)] = nil;
+        [self setComposedFrame:nil forKey:@(index)];
     }
+    [self reportBufferBytes];
 }
 
 - (void)removeAllFrames {
     @synchronized (self) {
         [self.frameBuffer removeAllObjects];
+        [self.frameAccessStamps removeAllObjects];
+        [self.composedFrames removeAllObjects];
+        [self.keyframeReferences removeAllObjects];
+        self.bufferBytes = 0;
+        self.keyframe = nil;
+        self.deltaFrameCount = 0;
+        self.fullFrameCount = 0;
+    }
+    [self reportBufferBytes];
+}
+
+// Report the buffered bytes to provider if changed, must be called outside the lock. This is called on each frame buffered and evicted, the observer should coalesce the expensive work
+- (void)reportBufferBytes {
+    id<SDAnimatedImageProvider> provider = self.provider;
+    if (![provider conformsToProtocol:@protocol(SDImageFramePoolObserver)]) {
+        return;
+    }
+    NSUInteger bufferBytes;
+    @synchronized (self) {
+        bufferBytes = self.bufferBytes;
+        if (bufferBytes == self.reportedBufferBytes) {
+            return;
+        }
+        self.reportedBufferBytes = bufferBytes;
+    }
+    [(id<SDImageFramePoolObserver>)provider framePool:self didUpdateBufferBytes:bufferBytes];
+}
+
+#pragma mark - Global Budget
+
++ (NSUInteger)maxTotalBufferBytes {
+    SD_LOCK(_providerFramePoolMapLock);
+    NSUInteger maxTotalBufferBytes = _maxTotalBufferBytes;
+    SD_UNLOCK(_providerFramePoolMapLock);
+    return maxTotalBufferBytes;
+}
+
++ (void)setMaxTotalBufferBytes:(NSUInteger)maxTotalBufferBytes {
+    SD_LOCK(_providerFramePoolMapLock);
+    _maxTotalBufferBytes = maxTotalBufferBytes;
+    [self rebalanceBudget];
+    SD_UNLOCK(_providerFramePoolMapLock);
+}
+
+- (void)activatePlayer:(id)player frameBytes:(NSUInteger)frameBytes frameRate:(double)frameRate visible:(BOOL)visible {
+    if (!player) {
+        return;
+    }
+    SD_LOCK(_providerFramePoolMapLock);
+    SDImageFramePoolDemand *demand = [self.playerDemands objectForKey:player];
+    if (!demand) {
+        demand = [SDImageFramePoolDemand new];
+        [self.playerDemands setObject:demand forKey:player];
+    }
+    demand.frameBytes = frameBytes;
+    demand.frameRate = frameRate;
+    demand.visible = visible;
+    [self.class rebalanceBudget];
+    SD_UNLOCK(_providerFramePoolMapLock);
+}
+
+- (void)deactivatePlayer:(id)player {
+    if (!player) {
+        return;
+    }
+    SD_LOCK(_providerFramePoolMapLock);
+    if ([self.playerDemands objectForKey:player]) {
+        [self.playerDemands removeObjectForKey:player];
+        self.budgetBytes = 0;
+        [self.class rebalanceBudget];
+    }
+    SD_UNLOCK(_providerFramePoolMapLock);
+}
+
+// Must be called under `_providerFramePoolMapLock`. Split the budget by weight (frame bytes * frame rate * visibility), the pool never gets more than all of its frames, the remaining is given to others
++ (void)rebalanceBudget {
+    NSUInteger totalBytes = _maxTotalBufferBytes;
+    if (totalBytes == 0) {
+        // Calculate based on current memory, these factors are by experience
+        NSUInteger total = [SDDeviceHelper totalMemory];
+        NSUInteger free = [SDDeviceHelper freeMemory];
+        totalBytes = MIN(total * 0.2, free * 0.6);
+    }
+    
+    // Players of the same pool share the frames, use the largest demand
+    NSMutableArray<SDImageFramePool *> *pools = [NSMutableArray array];
+    NSMapTable<SDImageFramePool *, NSNumber *> *weights = [NSMapTable strongToStrongObjectsMapTable];
+    NSMapTable<SDImageFramePool *, NSNumber *> *frameBytes = [NSMapTable strongToStrongObjectsMapTable];
+    for (SDImageFramePool *framePool in self.providerFramePoolMap.objectEnumerator) {
+        if (framePool.playerDemands.count == 0) {
+            continue;
+        }
+        double weight = 0;
+        NSUInteger bytes = 0;
+        for (SDImageFramePoolDemand *demand in framePool.playerDemands.objectEnumerator) {
+            double frameRate = demand.frameRate > 0 ? demand.frameRate : 1;
+            double visibility = demand.visible ? 1 : kSDImageFramePoolInvisibleWeight;
+            weight = MAX(weight, MAX(demand.frameBytes, 1) * frameRate * visibility);
+            bytes = MAX(bytes, demand.frameBytes);
+        }
+        [pools addObject:framePool];
+        [weights setObject:@(weight) forKey:framePool];
+        [frameBytes setObject:@(bytes) forKey:framePool];
+    }
+    
+    // Water filling
+    NSMutableArray<SDImageFramePool *> *remainingPools = [pools mutableCopy];
+    double remainingBytes = totalBytes;
+    BOOL capped = YES;
+    while (remainingPools.count > 0 && capped) {
+        capped = NO;
+        double totalWeight = 0;
+        for (SDImageFramePool *framePool in remainingPools) {
+            totalWeight += [weights objectForKey:framePool].doubleValue;
+        }
+        for (SDImageFramePool *framePool in [remainingPools copy]) {
+            double share = totalWeight > 0 ? remainingBytes * [weights objectForKey:framePool].doubleValue / totalWeight : 0;
+            double demandBytes = (double)[frameBytes objectForKey:framePool].unsignedIntegerValue * MAX(framePool.totalFrameCount, 1);
+            if (demandBytes > 0 && share >= demandBytes) {
+                [framePool applyBudgetBytes:demandBytes frameBytes:[frameBytes objectForKey:framePool].unsignedIntegerValue];
+                remainingBytes -= demandBytes;
+                [remainingPools removeObject:framePool];
+                capped = YES;
+            }
+        }
+    }
+    double totalWeight = 0;
+    for (SDImageFramePool *framePool in remainingPools) {
+        totalWeight += [weights objectForKey:framePool].doubleValue;
+    }
+    for (SDImageFramePool *framePool in remainingPools) {
+        double share = totalWeight > 0 ? remainingBytes * [weights objectForKey:framePool].doubleValue / totalWeight : 0;
+        [framePool applyBudgetBytes:share frameBytes:[frameBytes objectForKey:framePool].unsignedIntegerValue];
+    }
+}
+
+// Apply the budget, shrink the buffer immediately. The player grows the buffer later when it prefetches
+- (void)applyBudgetBytes:(NSUInteger)budgetBytes frameBytes:(NSUInteger)frameBytes {
+    self.budgetBytes = budgetBytes;
+    if (frameBytes == 0) {
+        return;
+    }
+    NSUInteger maxBufferCount = MAX(budgetBytes / frameBytes, 1);
+    @synchronized (self) {
+        if (self.maxBufferCount == 0 || maxBufferCount < self.maxBufferCount) {
+            self.maxBufferCount = maxBufferCount;
+            [self evictFramesToCount:maxBufferCount excludingIndex:self.playheadIndex];
+        }
+    }
+    // Called inside the global lock, report asynchronously
+    @weakify(self);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        @strongify(self);
+        [self reportBufferBytes];
+    });
+}
+
+#pragma mark - Buffer Statistics
+
+- (void)recordBufferHit:(BOOL)hit {
+    @synchronized (self) {
+        if (hit) {
+            self.bufferHitCount += 1;
+        } else {
+            self.bufferMissCount += 1;
+        }
+    }
+}
+
+- (void)resetBufferStatistics {
+    @synchronized (self) {
+        self.bufferHitCount = 0;
+        self.bufferMissCount = 0;
+    }
+}
+
+#pragma mark - Eviction
+
+// Must be called under `@synchronized (self)`
+- (void)touchFrameAtIndex:(NSUInteger)index {
+    self.accessStamp += 1;
+    self.frameAccessStamps[@(index)] = @(self.accessStamp);
+}
+
+// Must be called under `@synchronized (self)`. Evict until the buffer count is not larger than the count, 0 means unlimited
+- (void)evictFramesToCount:(NSUInteger)count excludingIndex:(NSUInteger)excludedIndex {
+    if (self.maxBufferCount == 0) {
+        return;
+    }
+    while (self.frameBuffer.count > count) {
+        NSNumber *victimKey;
+        NSUInteger victimDistance = 0;
+        NSUInteger victimStamp = 0;
+        for (NSNumber *key in self.frameBuffer) {
+            NSUInteger index = key.unsignedIntegerValue;
+            if (index == excludedIndex) {
+                continue;
+            }
+            NSUInteger distance = [self playbackDistanceToFrameAtIndex:index];
+            NSUInteger stamp = [self.frameAccessStamps[key] unsignedIntegerValue];
+            // The farthest frame from playhead first, then the least recently used one
+            if (!victimKey || distance > victimDistance || (distance == victimDistance && stamp < victimStamp)) {
+                victimKey = key;
+                victimDistance = distance;
+                victimStamp = stamp;
+            }
+        }
+        if (!victimKey) {
+            break;
+        }
+        [self setBufferedFrame:nil forKey:victimKey];
+        self.frameAccessStamps[victimKey] = nil;
+        [self setComposedFrame:nil forKey:victimKey];
+    }
+}
+
+// Must be called under `@synchronized (self)`. The number of frame steps until the playback reaches the frame, 0 if no playhead (LRU only)
+- (NSUInteger)playbackDistanceToFrameAtIndex:(NSUInteger)index {
+    NSUInteger frameCount = self.totalFrameCount;
+    if (!self.hasPlayhead || frameCount <= 1 || index >= frameCount) {
+        return 0;
+    }
+    NSUInteger playhead = MIN(self.playheadIndex, frameCount - 1);
+    switch (self.playbackMode) {
+        case SDAnimatedImagePlaybackModeReverse:
+            return (playhead + frameCount - index) % frameCount;
+        case SDAnimatedImagePlaybackModeBounce:
+        case SDAnimatedImagePlaybackModeReversedBounce: {
+            // Bounce is a cycle of `2 * (frameCount - 1)` steps, each frame except the ends appears twice
+            NSUInteger period = 2 * (frameCount - 1);
+            NSUInteger phase = self.playbackReverse ? (period - playhead) % period : playhead;
+            NSUInteger forwardDistance = (index + period - phase) % period;
+            NSUInteger backwardDistance = ((period - index) % period + period - phase) % period;
+            return MIN(forwardDistance, backwardDistance);
+        }
+        case SDAnimatedImagePlaybackModeNormal:
+        default:
+            return (index + frameCount - playhead) % frameCount;
     }
 }
 
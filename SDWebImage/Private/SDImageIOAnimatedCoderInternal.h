@@ -39,4 +39,9 @@
 + (BOOL)canEncodeToFormat:(SDImageFormat)format;
 + (BOOL)canDecodeFromFormat:(SDImageFormat)format;
 
+// Create a separate image source of the same data, used for parallel frames decoding. NULL for incremental decoding
+- (nullable CGImageSourceRef)createParallelImageSource CF_RETURNS_RETAINED;
+// Decode the frame from the image source created by `createParallelImageSource`, with the same decoding options
+- (nullable UIImage *)animatedImageFrameAtIndex:(NSUInteger)index imageSource:(nonnull CGImageSourceRef)imageSource;
+
 @end
@@ -0,0 +1,35 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A frame buffer which stores the decoded frame bitmaps in a temporary memory-mapped file, used by animated image to avoid decoding the same frame again.
+/// Each frame is written only once, the returned frame reference the file pages directly, which are clean memory and can be paged out by system under memory pressure.
+/// The file is unlinked immediately after creation, so it's removed when the buffer deallocates (or the process exits).
+@interface SDImageMappedFrameBuffer : NSObject
+
+- (instancetype)initWithLimitBytes:(NSUInteger)limitBytes;
+
+/// The max bytes of the file, the frame which exceeds the limit is not stored
+@property (atomic, assign) NSUInteger limitBytes;
+/// The bytes of the file used by stored frames
+@property (atomic, readonly) NSUInteger usedBytes;
+/// The number of stored frames
+@property (atomic, readonly) NSUInteger frameCount;
+
+/// Return the frame stored at index, the bitmap is read from the file without decoding. Return nil if not stored
+- (nullable UIImage *)frameAtIndex:(NSUInteger)index;
+/// Write the bitmap of decoded frame into the file, return the frame read back from the file with the same color space and orientation. Return nil if the frame can not be stored (exceed the limit, IO error, or not 8-bit such as HDR)
+- (nullable UIImage *)storeFrame:(UIImage *)frame atIndex:(NSUInteger)index;
+
+@end
+
+NS_ASSUME_NONNULL_END
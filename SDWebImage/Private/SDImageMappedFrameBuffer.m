@@ -0,0 +1,227 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import "SDImageMappedFrameBuffer.h"
+#import "SDInternalMacros.h"
+#import "SDImageCoderHelper.h"
+#import "UIImage+ForceDecode.h"
+#import "NSImage+Compatibility.h"
+#import <sys/mman.h>
+#import <fcntl.h>
+#import <unistd.h>
+
+// The location and bitmap format of one stored frame
+@interface SDImageMappedFrame : NSObject
+
+@property (nonatomic, assign) off_t offset;
+@property (nonatomic, assign) size_t length;
+@property (nonatomic, assign) size_t width;
+@property (nonatomic, assign) size_t height;
+@property (nonatomic, assign) size_t bytesPerRow;
+@property (nonatomic, assign) CGBitmapInfo bitmapInfo;
+@property (nonatomic, assign) CGColorSpaceRef colorSpace; // retained
+@property (nonatomic, assign) CGFloat scale;
+#if SD_UIKIT || SD_WATCH
+@property (nonatomic, assign) UIImageOrientation orientation;
+#endif
+
+@end
+
+@implementation SDImageMappedFrame
+
+- (void)dealloc {
+    if (_colorSpace) {
+        CGColorSpaceRelease(_colorSpace);
+    }
+}
+
+@end
+
+static void SDImageMappedFrameRelease(void *info, const void *data, size_t size) {
+    munmap((void *)data, size);
+}
+
+@interface SDImageMappedFrameBuffer () {
+    int _fd;
+    off_t _fileLength;
+    SD_LOCK_DECLARE(_lock);
+}
+
+@property (nonatomic, strong) NSMutableDictionary<NSNumber *, SDImageMappedFrame *> *frames; // protected by `_lock`
+@property (nonatomic, strong) NSMutableIndexSet *storingIndexes; // protected by `_lock`
+@property (atomic, readwrite) NSUInteger usedBytes;
+@property (atomic, readwrite) NSUInteger frameCount;
+
+@end
+
+@implementation SDImageMappedFrameBuffer
+
+- (instancetype)init {
+    return [self initWithLimitBytes:0];
+}
+
+- (instancetype)initWithLimitBytes:(NSUInteger)limitBytes {
+    self = [super init];
+    if (self) {
+        _limitBytes = limitBytes;
+        _fd = -1;
+        _frames = [NSMutableDictionary dictionary];
+        _storingIndexes = [NSMutableIndexSet indexSet];
+        SD_LOCK_INIT(_lock);
+    }
+    return self;
+}
+
+- (void)dealloc {
+    // The mapped frames still alive keep their pages valid after close
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+// Must be called inside `_lock`
+- (BOOL)openFileIfNeeded {
+    if (_fd >= 0) {
+        return YES;
+    }
+    NSString *fileName = [NSString stringWithFormat:@"com.hackemist.SDImageMappedFrameBuffer.%@", NSUUID.UUID.UUIDString];
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:fileName];
+    int fd = open(path.fileSystemRepresentation, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+        return NO;
+    }
+    // Unlink immediately, the file is removed once closed and all pages unmapped, even the process crash
+    unlink(path.fileSystemRepresentation);
+    _fd = fd;
+    return YES;
+}
+
+- (UIImage *)frameAtIndex:(NSUInteger)index {
+    SD_LOCK(_lock);
+    SDImageMappedFrame *frame = self.frames[@(index)];
+    int fd = _fd;
+    SD_UNLOCK(_lock);
+    if (!frame) {
+        return nil;
+    }
+    void *bytes = mmap(NULL, frame.length, PROT_READ, MAP_SHARED, fd, frame.offset);
+    if (bytes == MAP_FAILED) {
+        return nil;
+    }
+    CGDataProviderRef provider = CGDataProviderCreateWithData(NULL, bytes, frame.length, SDImageMappedFrameRelease);
+    if (!provider) {
+        munmap(bytes, frame.length);
+        return nil;
+    }
+    CGImageRef imageRef = CGImageCreate(frame.width, frame.height, 8, 32, frame.bytesPerRow, frame.colorSpace, frame.bitmapInfo, provider, NULL, false, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+    if (!imageRef) {
+        return nil;
+    }
+#if SD_MAC
+    // The `NSImage` bitmap is already rotated
+    UIImage *image = [[UIImage alloc] initWithCGImage:imageRef scale:frame.scale orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *image = [[UIImage alloc] initWithCGImage:imageRef scale:frame.scale orientation:frame.orientation];
+#endif
+    CGImageRelease(imageRef);
+    // The bitmap is already in a format which can be rendered directly, don't force decode again
+    image.sd_isDecoded = YES;
+    return image;
+}
+
+- (UIImage *)storeFrame:(UIImage *)image atIndex:(NSUInteger)index {
+    CGImageRef imageRef = image.CGImage;
+    if (!imageRef) {
+        return nil;
+    }
+    size_t width = CGImageGetWidth(imageRef);
+    size_t height = CGImageGetHeight(imageRef);
+    if (width == 0 || height == 0) {
+        return nil;
+    }
+    // Only 8-bit bitmap can be stored without losing precision, the HDR (16-bit or float) frames are not stored
+    if (CGImageGetBitsPerComponent(imageRef) != 8) {
+        return nil;
+    }
+    // Keep the RGB color space such as Display P3, the other color models are converted into device RGB
+    CGColorSpaceRef colorSpace = CGImageGetColorSpace(imageRef);
+    if (!colorSpace || CGColorSpaceGetModel(colorSpace) != kCGColorSpaceModelRGB) {
+        colorSpace = [SDImageCoderHelper colorSpaceGetDeviceRGB];
+    }
+    BOOL hasAlpha = [SDImageCoderHelper CGImageContainsAlpha:imageRef];
+    // BGRA8888 (premultiplied) or BGRX8888, the same as what `SDImageCoderHelper` force decode produce
+    CGBitmapInfo bitmapInfo = kCGBitmapByteOrder32Host;
+    bitmapInfo |= hasAlpha ? kCGImageAlphaPremultipliedFirst : kCGImageAlphaNoneSkipFirst;
+    size_t bytesPerRow = SDByteAlign(width * 4, 64);
+    size_t length = bytesPerRow * height;
+    // The offset of mmap should be page aligned
+    size_t alignedLength = SDByteAlign(length, (size_t)getpagesize());
+
+    SD_LOCK(_lock);
+    if (self.frames[@(index)] || [self.storingIndexes containsIndex:index]) {
+        // Already stored, or being stored by another thread
+        SD_UNLOCK(_lock);
+        return [self frameAtIndex:index];
+    }
+    if (self.usedBytes + alignedLength > self.limitBytes || ![self openFileIfNeeded]) {
+        SD_UNLOCK(_lock);
+        return nil;
+    }
+    off_t offset = _fileLength;
+    if (ftruncate(_fd, offset + alignedLength) != 0) {
+        SD_UNLOCK(_lock);
+        return nil;
+    }
+    _fileLength = offset + alignedLength;
+    self.usedBytes += alignedLength;
+    [self.storingIndexes addIndex:index];
+    int fd = _fd;
+    SD_UNLOCK(_lock);
+
+    // Draw into the file pages directly, without extra copy
+    BOOL success = NO;
+    void *bytes = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+    if (bytes != MAP_FAILED) {
+        CGContextRef context = CGBitmapContextCreate(bytes, width, height, 8, bytesPerRow, colorSpace, bitmapInfo);
+        if (context) {
+            CGContextDrawImage(context, CGRectMake(0, 0, width, height), imageRef);
+            CGContextRelease(context);
+            success = YES;
+        }
+        munmap(bytes, length);
+    }
+
+    SD_LOCK(_lock);
+    [self.storingIndexes removeIndex:index];
+    if (success) {
+        SDImageMappedFrame *frame = [SDImageMappedFrame new];
+        frame.offset = offset;
+        frame.length = length;
+        frame.width = width;
+        frame.height = height;
+        frame.bytesPerRow = bytesPerRow;
+        frame.bitmapInfo = bitmapInfo;
+        frame.colorSpace = CGColorSpaceRetain(colorSpace);
+        frame.scale = image.scale;
+#if SD_UIKIT || SD_WATCH
+        frame.orientation = image.imageOrientation;
+#endif
+        self.frames[@(index)] = frame;
+        self.frameCount = self.frames.count;
+    }
+    // The failed region is not reused, it still counts in `usedBytes`
+    SD_UNLOCK(_lock);
+
+    if (!success) {
+        return nil;
+    }
+    return [self frameAtIndex:index];
+}
+
+@end
@@ -0,0 +1,35 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import <Foundation/Foundation.h>
+#import "SDWebImageCompat.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/// A format-aware scanner for progressive download, which decide whether the received data contains enough new content to produce a visible change, so the progressive decoding is not triggered on every network packet.
+/// For JPEG, it parse the markers and trigger when a new scan (SOS) is completed, or when enough entropy-coded data (rows) for baseline JPEG arrived.
+/// For PNG, it parse the chunks and trigger when enough IDAT data (rows) arrived.
+/// For other formats, it always trigger, which is the same as before.
+/// @note This class is not thread-safe, call it from the same serial queue.
+@interface SDImageProgressiveScanner : NSObject
+
+/// Create the scanner with the expected total size of image data, which is used to calculate the row data threshold. Pass 0 if unknown.
+- (instancetype)initWithExpectedSize:(NSUInteger)expectedSize;
+
+/// The minimum ratio of new row data to the expected size, between two decoding. Defaults to 0.1.
+@property (nonatomic, assign) double minimumRowDataRatio;
+
+/// Scan the newly received bytes (the data is the accumulated image data, only the bytes after previous scan are parsed) and return whether we should decode now. When YES, the current position is marked as decoded.
+- (BOOL)shouldDecodeWithData:(NSData *)data;
+
+/// The number of JPEG scans completed, for test and debug.
+@property (nonatomic, assign, readonly) NSUInteger completedScanCount;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,196 @@
+/*
+* This file is part of the SDWebImage package.
+* (c) Olivier Poitrey <rs@dailymotion.com>
+*
+* For the full copyright and license information, please view the LICENSE
+* file that was distributed with this source code.
+*/
+
+#import "SDImageProgressiveScanner.h"
+#import "NSData+ImageContentType.h"
+
+// The lower bound of row data threshold, avoid decoding on tiny packets for small image
+static const NSUInteger kSDProgressiveMinimumRowDataLength = 4 * 1024;
+// The row data threshold used when the expected size is unknown
+static const NSUInteger kSDProgressiveDefaultRowDataLength = 32 * 1024;
+
+@interface SDImageProgressiveScanner ()
+
+@property (nonatomic, assign, readwrite) NSUInteger completedScanCount;
+
+@end
+
+@implementation SDImageProgressiveScanner {
+    NSUInteger _expectedSize;
+    SDImageFormat _format;
+    BOOL _formatDetected;
+    NSUInteger _offset; // next byte to parse, may be beyond current data length when skipping a segment which is not fully received
+    // JPEG
+    BOOL _progressiveJPEG;
+    BOOL _inEntropyData;
+    // JPEG entropy-coded data or PNG IDAT data, which contains the rows
+    NSUInteger _rowDataLength;
+    NSUInteger _partialRowDataLength;
+    // Decoded position
+    NSUInteger _decodedScanCount;
+    NSUInteger _decodedRowDataLength;
+}
+
+- (instancetype)initWithExpectedSize:(NSUInteger)expectedSize {
+    self = [super init];
+    if (self) {
+        _expectedSize = expectedSize;
+        _minimumRowDataRatio = 0.1;
+    }
+    return self;
+}
+
+- (NSUInteger)rowDataThreshold {
+    if (_expectedSize == 0) {
+        return kSDProgressiveDefaultRowDataLength;
+    }
+    double ratio = MIN(MAX(self.minimumRowDataRatio, 0), 1);
+    return MAX((NSUInteger)(_expectedSize * ratio), kSDProgressiveMinimumRowDataLength);
+}
+
+- (BOOL)shouldDecodeWithData:(NSData *)data {
+    if (data.length == 0) {
+        return NO;
+    }
+    if (!_formatDetected) {
+        _format = [NSData sd_imageFormatForImageData:data];
+        _formatDetected = YES;
+        if (_format == SDImageFormatPNG) {
+            // Skip the 8 bytes signature
+            _offset = 8;
+        }
+    }
+    switch (_format) {
+        case SDImageFormatJPEG:
+            [self scanJPEGData:data];
+            break;
+        case SDImageFormatPNG:
+            [self scanPNGData:data];
+            break;
+        default:
+            // Unknown stream structure, keep the behavior to decode each time
+            return YES;
+    }
+    
+    BOOL shouldDecode = NO;
+    NSUInteger rowDataLength = _rowDataLength + _partialRowDataLength;
+    if (self.completedScanCount > _decodedScanCount) {
+        // A new scan completed, which refines the whole image
+        shouldDecode = YES;
+    } else if (!_progressiveJPEG && rowDataLength > _decodedRowDataLength && rowDataLength - _decodedRowDataLength >= [self rowDataThreshold]) {
+        // Enough new rows arrived. For progressive JPEG, the partial scan only refines part of image, wait for the whole scan
+        shouldDecode = YES;
+    }
+    if (shouldDecode) {
+        _decodedScanCount = self.completedScanCount;
+        _decodedRowDataLength = rowDataLength;
+    }
+    return shouldDecode;
+}
+
+#pragma mark - JPEG
+
+- (void)scanJPEGData:(NSData *)data {
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    NSUInteger offset = _offset;
+    while (offset < length) {
+        if (_inEntropyData) {
+            // Entropy-coded data, 0xFF is always stuffed with 0x00, or followed by RST marker. Any other marker ends the scan
+            NSUInteger start = offset;
+            BOOL markerFound = NO;
+            while (offset + 1 < length) {
+                if (bytes[offset] != 0xFF) {
+                    offset++;
+                    continue;
+                }
+                uint8_t next = bytes[offset + 1];
+                if (next == 0x00 || (next >= 0xD0 && next <= 0xD7)) {
+                    offset += 2;
+                } else if (next == 0xFF) {
+                    // Fill byte
+                    offset++;
+                } else {
+                    markerFound = YES;
+                    break;
+                }
+            }
+            _rowDataLength += offset - start;
+            if (!markerFound) {
+                // Wait for more data, the last byte may be the start of marker
+                break;
+            }
+            _inEntropyData = NO;
+            self.completedScanCount++;
+            continue;
+        }
+        // Marker segment
+        if (offset + 2 > length) {
+            break;
+        }
+        if (bytes[offset] != 0xFF) {
+            // Corrupted stream, stop parsing and the previous decision is kept
+            offset = NSUIntegerMax;
+            break;
+        }
+        uint8_t marker = bytes[offset + 1];
+        if (marker == 0xFF) {
+            // Fill byte
+            offset++;
+            continue;
+        }
+        if (marker == 0xD8 || marker == 0xD9 || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            // Standalone marker without length
+            offset += 2;
+            continue;
+        }
+        if (offset + 4 > length) {
+            break;
+        }
+        NSUInteger segmentLength = ((NSUInteger)bytes[offset + 2] << 8) | bytes[offset + 3];
+        if (marker == 0xC2 || marker == 0xC6 || marker == 0xCA || marker == 0xCE) {
+            // SOF2 (and the other progressive SOF types)
+            _progressiveJPEG = YES;
+        } else if (marker == 0xDA) {
+            // SOS, the entropy-coded data follows the header
+            _inEntropyData = YES;
+        }
+        // Skip the segment, which may be beyond the current length
+        offset += 2 + segmentLength;
+    }
+    _offset = offset;
+}
+
+#pragma mark - PNG
+
+- (void)scanPNGData:(NSData *)data {
+    const uint8_t *bytes = data.bytes;
+    NSUInteger length = data.length;
+    NSUInteger offset = _offset;
+    _partialRowDataLength = 0;
+    while (offset + 8 <= length) {
+        NSUInteger chunkLength = ((NSUInteger)bytes[offset] << 24) | ((NSUInteger)bytes[offset + 1] << 16) | ((NSUInteger)bytes[offset + 2] << 8) | bytes[offset + 3];
+        BOOL isIDAT = memcmp(bytes + offset + 4, "IDAT", 4) == 0;
+        // Chunk layout: length (4) + type (4) + data + CRC (4)
+        NSUInteger chunkEnd = offset + 12 + chunkLength;
+        if (isIDAT) {
+            if (chunkEnd <= length) {
+                _rowDataLength += chunkLength;
+            } else {
+                // Partial IDAT chunk still contains the decodable rows, but keep the offset to parse the chunk again
+                _partialRowDataLength = MIN(length - (offset + 8), chunkLength);
+                break;
+            }
+        }
+        // Skip the chunk, which may be beyond the current length
+        offset = chunkEnd;
+    }
+    _offset = offset;
+}
+
+@end
@@ -0,0 +1 @@
+../../Core/SDImageBufferPool.h
\ No newline at end of file
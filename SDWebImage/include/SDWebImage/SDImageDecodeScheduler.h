@@ -0,0 +1 @@
+../../Core/SDImageDecodeScheduler.h
\ No newline at end of file
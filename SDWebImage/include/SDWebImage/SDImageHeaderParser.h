@@ -0,0 +1 @@
+../../Core/SDImageHeaderParser.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../Core/SDImageThumbnailVariantTable.h
\ No newline at end of file
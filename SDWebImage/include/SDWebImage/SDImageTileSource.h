@@ -0,0 +1 @@
+../../Core/SDImageTileSource.h
\ No newline at end of file
@@ -0,0 +1 @@
+../../Core/SDWebImageFailedURLTable.h
\ No newline at end of file
@@ -10,6 +10,8 @@
 #import "SDTestCase.h"
 #import "SDInternalMacros.h"
 #import "SDImageFramePool.h"
+#import "SDImageDeltaFrame.h"
+#import "SDImageMappedFrameBuffer.h"
 #import "SDWebImageTestTransformer.h"
 #import <KVOController/KVOController.h>
 
@@ -816,6 +818,629 @@ static BOOL _isCalled;
     expect(scaledImage).notTo.equal(image);
 }
 
+- (void)test38AnimatedImagePreloadAllFramesInParallel {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test SDAnimatedImage preload all frames in parallel"];
+    NSData *data = [self testAPNGPData];
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:data];
+    NSUInteger frameCount = image.animatedImageFrameCount;
+    expect(frameCount).beGreaterThan(1);
+    __block NSUInteger progressCount = 0;
+    [image preloadAllFramesWithProgress:^(NSUInteger loadedFrameCount, NSUInteger totalFrameCount) {
+        expect([NSThread isMainThread]).beTruthy();
+        expect(totalFrameCount).equal(frameCount);
+        expect(loadedFrameCount).beLessThanOrEqualTo(frameCount);
+        progressCount++;
+    } completion:^(BOOL finished) {
+        expect([NSThread isMainThread]).beTruthy();
+        expect(finished).beTruthy();
+        expect(progressCount).equal(frameCount);
+        expect(image.isAllFramesLoaded).beTruthy();
+        NSArray *loadedAnimatedImageFrames = [image valueForKey:@"loadedAnimatedImageFrames"]; // Access the internal property, only for test and may be changed in the future
+        expect(loadedAnimatedImageFrames.count).equal(frameCount);
+        for (NSUInteger i = 0; i < frameCount; i++) {
+            expect([image animatedImageFrameAtIndex:i]).notTo.beNil();
+        }
+        [expectation fulfill];
+    }];
+
+    // Benchmark the serial decoding against the parallel preloading
+    SDImageAPNGCoder *coder = [[SDImageAPNGCoder alloc] initWithAnimatedImageData:data options:nil];
+    CFAbsoluteTime begin = CFAbsoluteTimeGetCurrent();
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        @autoreleasepool {
+            expect([coder animatedImageFrameAtIndex:i]).notTo.beNil();
+        }
+    }
+    CFAbsoluteTime serialTime = CFAbsoluteTimeGetCurrent() - begin;
+    SDAnimatedImage *parallelImage = [SDAnimatedImage imageWithData:data];
+    begin = CFAbsoluteTimeGetCurrent();
+    [parallelImage preloadAllFrames];
+    CFAbsoluteTime parallelTime = CFAbsoluteTimeGetCurrent() - begin;
+    expect(parallelImage.isAllFramesLoaded).beTruthy();
+    NSLog(@"Preload %lu frames, serial: %.3fs, parallel: %.3fs, speedup %.2fx on %lu cores", (unsigned long)frameCount, serialTime, parallelTime, serialTime / MAX(parallelTime, DBL_EPSILON), (unsigned long)[NSProcessInfo processInfo].activeProcessorCount);
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test39FramePoolEvictByPlaybackMode {
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testGIFData]];
+    expect(image.animatedImageFrameCount).equal(kTestGIFFrameCount);
+    UIImage *frame = [[UIImage alloc] initWithData:[self testJPEGData]];
+    SDImageFramePool *framePool = [SDImageFramePool registerProvider:image];
+    NSArray<NSNumber *> * (^evict)(NSUInteger, SDAnimatedImagePlaybackMode, BOOL) = ^NSArray<NSNumber *> *(NSUInteger playheadIndex, SDAnimatedImagePlaybackMode mode, BOOL reverse) {
+        [framePool removeAllFrames];
+        framePool.maxBufferCount = 0;
+        for (NSUInteger i = 0; i < kTestGIFFrameCount; i++) {
+            [framePool setFrame:frame atIndex:i];
+        }
+        [framePool updatePlayheadWithFrameIndex:playheadIndex playbackMode:mode reverse:reverse];
+        framePool.maxBufferCount = 3;
+        [framePool setFrame:frame atIndex:playheadIndex];
+        expect(framePool.currentFrameCount).equal(3);
+        NSMutableArray<NSNumber *> *indexes = [NSMutableArray array];
+        for (NSUInteger i = 0; i < kTestGIFFrameCount; i++) {
+            if ([framePool frameAtIndex:i]) {
+                [indexes addObject:@(i)];
+            }
+        }
+        return indexes;
+    };
+    // Keep the upcoming frames in playback order
+    expect(evict(1, SDAnimatedImagePlaybackModeNormal, NO)).equal(@[@1, @2, @3]);
+    expect(evict(1, SDAnimatedImagePlaybackModeReverse, YES)).equal(@[@0, @1, @4]);
+    expect(evict(3, SDAnimatedImagePlaybackModeBounce, NO)).equal(@[@2, @3, @4]);
+    expect(evict(3, SDAnimatedImagePlaybackModeReversedBounce, YES)).equal(@[@1, @2, @3]);
+
+    // Buffer statistics
+    [framePool resetBufferStatistics];
+    [framePool recordBufferHit:YES];
+    [framePool recordBufferHit:YES];
+    [framePool recordBufferHit:NO];
+    expect(framePool.bufferHitCount).equal(2);
+    expect(framePool.bufferMissCount).equal(1);
+    [framePool resetBufferStatistics];
+    expect(framePool.bufferHitCount).equal(0);
+    expect(framePool.bufferMissCount).equal(0);
+    [framePool removeAllFrames];
+    [SDImageFramePool unregisterProvider:image];
+}
+
+- (void)test40AnimatedImageViewBufferMissRateByPlaybackMode {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test buffer miss rate of each playback mode"];
+    NSArray<NSNumber *> *modes = @[@(SDAnimatedImagePlaybackModeNormal), @(SDAnimatedImagePlaybackModeReverse), @(SDAnimatedImagePlaybackModeBounce), @(SDAnimatedImagePlaybackModeReversedBounce)];
+    NSMutableArray<SDAnimatedImagePlayer *> *players = [NSMutableArray array];
+    for (NSNumber *mode in modes) {
+        SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+        SDAnimatedImagePlayer *player = [SDAnimatedImagePlayer playerWithProvider:image];
+        player.playbackMode = mode.unsignedIntegerValue;
+        // Only allow 2 frames in buffer
+        player.maxBufferSize = CGImageGetBytesPerRow(image.CGImage) * CGImageGetHeight(image.CGImage) * 2;
+        player.animationFrameHandler = ^(NSUInteger index, UIImage * _Nonnull frame) {};
+        [players addObject:player];
+        [player startPlaying];
+    }
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        for (NSUInteger i = 0; i < players.count; i++) {
+            SDAnimatedImagePlayer *player = players[i];
+            [player stopPlaying];
+            SDImageFramePool *framePool = [player valueForKey:@"framePool"]; // Access the internal property, only for test and may be changed in the future
+            NSUInteger hitCount = framePool.bufferHitCount;
+            NSUInteger missCount = framePool.bufferMissCount;
+            expect(hitCount + missCount).beGreaterThan(0);
+            expect(framePool.currentFrameCount).beLessThanOrEqualTo(2);
+            NSLog(@"Playback mode %@ buffer miss rate: %.1f%% (%lu hits, %lu misses)", modes[i], (double)missCount / (hitCount + missCount) * 100, (unsigned long)hitCount, (unsigned long)missCount);
+        }
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test41FramePoolPrefetchMultipleFrames {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test frame pool prefetch multiple frames"];
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testGIFData]];
+    SDImageFramePool *framePool = [SDImageFramePool registerProvider:image];
+    [framePool removeAllFrames];
+    framePool.maxConcurrentCount = 2;
+    expect(framePool.maxConcurrentCount).equal(2);
+    for (NSUInteger i = 0; i < kTestGIFFrameCount; i++) {
+        [framePool prefetchFrameAtIndex:i];
+    }
+    // Same frame is only prefetched once
+    [framePool prefetchFrameAtIndex:0];
+    expect(framePool.prefetchingFrameCount).beLessThanOrEqualTo(kTestGIFFrameCount);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        expect(framePool.prefetchingFrameCount).equal(0);
+        expect(framePool.currentFrameCount).equal(kTestGIFFrameCount);
+        expect(framePool.averageDecodeDuration).beGreaterThan(0);
+        [framePool removeAllFrames];
+        [SDImageFramePool unregisterProvider:image];
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test42AnimatedImageViewLookaheadPrefetch {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test SDAnimatedImageView lookahead prefetch"];
+    SDAnimatedImageView *imageView = [SDAnimatedImageView new];
+    imageView.maxPrefetchFrameCount = 3;
+    imageView.maxBufferSize = NSUIntegerMax; // Cache all frames
+#if SD_UIKIT
+    [self.window addSubview:imageView];
+#else
+    [self.window.contentView addSubview:imageView];
+#endif
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    imageView.image = image;
+    expect(imageView.player.maxPrefetchFrameCount).equal(3);
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        // The current frame and the upcoming frames
+        expect(imageView.player.framePool.currentFrameCount).beGreaterThanOrEqualTo(MIN(4, image.animatedImageFrameCount));
+        [imageView removeFromSuperview];
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test43FramePoolShareGlobalBudget {
+    SDAnimatedImage *visibleImage = [SDAnimatedImage imageWithData:[self testGIFData]];
+    SDAnimatedImage *invisibleImage = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    SDImageFramePool *visiblePool = [SDImageFramePool registerProvider:visibleImage];
+    SDImageFramePool *invisiblePool = [SDImageFramePool registerProvider:invisibleImage];
+    NSObject *visiblePlayer = [NSObject new];
+    NSObject *invisiblePlayer = [NSObject new];
+    NSUInteger frameBytes = 1000;
+    SDAnimatedImagePlayer.maxTotalBufferSize = 4000;
+    expect(SDImageFramePool.maxTotalBufferBytes).equal(4000);
+
+    [visiblePool activatePlayer:visiblePlayer frameBytes:frameBytes frameRate:10 visible:YES];
+    // Only one active player, limited by all of its frames
+    expect(visiblePool.budgetBytes).beGreaterThan(0);
+    expect(visiblePool.budgetBytes).beLessThanOrEqualTo(MIN(4000, frameBytes * kTestGIFFrameCount));
+    [invisiblePool activatePlayer:invisiblePlayer frameBytes:frameBytes frameRate:10 visible:NO];
+    // Split by visibility
+    expect(visiblePool.budgetBytes).beGreaterThan(invisiblePool.budgetBytes);
+    expect(visiblePool.budgetBytes + invisiblePool.budgetBytes).beLessThanOrEqualTo(4000);
+    expect(visiblePool.maxBufferCount).equal(visiblePool.budgetBytes / frameBytes);
+    NSUInteger invisibleBudgetBytes = invisiblePool.budgetBytes;
+
+    // Rebalance when player stops
+    [visiblePool deactivatePlayer:visiblePlayer];
+    expect(visiblePool.budgetBytes).equal(0);
+    expect(invisiblePool.budgetBytes).beGreaterThan(invisibleBudgetBytes);
+    expect(invisiblePool.budgetBytes).beLessThanOrEqualTo(4000);
+
+    [invisiblePool deactivatePlayer:invisiblePlayer];
+    expect(invisiblePool.budgetBytes).equal(0);
+    SDAnimatedImagePlayer.maxTotalBufferSize = 0;
+    [SDImageFramePool unregisterProvider:visibleImage];
+    [SDImageFramePool unregisterProvider:invisibleImage];
+}
+
+- (void)test44AnimatedImagePlayerReduceFrameRate {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test SDAnimatedImagePlayer reduce frame rate"];
+    SDAnimatedImage *fullImage = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    SDAnimatedImage *reducedImage = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    SDAnimatedImagePlayer *fullPlayer = [SDAnimatedImagePlayer playerWithProvider:fullImage];
+    SDAnimatedImagePlayer *reducedPlayer = [SDAnimatedImagePlayer playerWithProvider:reducedImage];
+    reducedPlayer.maxFrameRate = 2;
+    __block NSUInteger fullFrameCount = 0;
+    __block NSUInteger reducedFrameCount = 0;
+    fullPlayer.animationFrameHandler = ^(NSUInteger index, UIImage * _Nonnull frame) {
+        fullFrameCount++;
+    };
+    reducedPlayer.animationFrameHandler = ^(NSUInteger index, UIImage * _Nonnull frame) {
+        reducedFrameCount++;
+    };
+    [fullPlayer startPlaying];
+    [reducedPlayer startPlaying];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        [fullPlayer stopPlaying];
+        [reducedPlayer stopPlaying];
+        // The reduced player keeps the timing by skipping frames, and does not decode them
+        expect(reducedPlayer.skippedFrameCount).beGreaterThan(0);
+        expect(fullPlayer.skippedFrameCount).equal(0);
+        expect(reducedFrameCount).beLessThan(fullFrameCount);
+        SDImageFramePool *fullFramePool = [fullPlayer valueForKey:@"framePool"]; // Access the internal property, only for test and may be changed in the future
+        SDImageFramePool *reducedFramePool = [reducedPlayer valueForKey:@"framePool"];
+        expect(reducedFramePool.decodedFrameCount).beLessThan(fullFramePool.decodedFrameCount);
+        NSTimeInterval savedDecodeTime = (fullFramePool.decodedFrameCount - reducedFramePool.decodedFrameCount) * fullFramePool.averageDecodeDuration;
+        NSLog(@"Full frame rate: %lu frames displayed, %lu decoded. Reduced frame rate: %lu frames displayed, %lu decoded, %lu skipped. Saved decode time: %.1fms", (unsigned long)fullFrameCount, (unsigned long)fullFramePool.decodedFrameCount, (unsigned long)reducedFrameCount, (unsigned long)reducedFramePool.decodedFrameCount, (unsigned long)reducedPlayer.skippedFrameCount, savedDecodeTime * 1000);
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test45AnimatedImageViewReduceFrameRateForSmallView {
+    SDAnimatedImageView *imageView = [[SDAnimatedImageView alloc] initWithFrame:CGRectMake(0, 0, 20, 20)];
+    imageView.realTimePlayback = YES;
+    imageView.maxFrameRate = 30;
+#if SD_UIKIT
+    [self.window addSubview:imageView];
+#else
+    [self.window.contentView addSubview:imageView];
+#endif
+    imageView.image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    expect(imageView.player.realTimePlayback).beTruthy();
+    expect(imageView.player.maxFrameRate).equal(30);
+    imageView.automaticallyReducesFrameRate = YES;
+    expect(imageView.player.maxFrameRate).equal(15);
+    imageView.automaticallyReducesFrameRate = NO;
+    expect(imageView.player.maxFrameRate).equal(30);
+    [imageView removeFromSuperview];
+}
+
+- (void)test46AnimatedImageMappedFrameBuffer {
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    NSUInteger frameCount = image.animatedImageFrameCount;
+    expect(frameCount).beGreaterThan(1);
+    expect(image.maxMappedFrameBufferSize).equal(0);
+    image.maxMappedFrameBufferSize = 100 * 1024 * 1024;
+    expect(image.maxMappedFrameBufferSize).equal(100 * 1024 * 1024);
+    // First loop decode and write into file
+    NSMutableArray<UIImage *> *decodedFrames = [NSMutableArray array];
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        UIImage *frame = [image animatedImageFrameAtIndex:i];
+        expect(frame).notTo.beNil();
+        [decodedFrames addObject:frame];
+    }
+    NSUInteger mappedFrameBufferSize = image.mappedFrameBufferSize;
+    expect(mappedFrameBufferSize).beGreaterThan(0);
+    // Later loop read back from file, without using more space
+    for (NSUInteger i = 0; i < frameCount; i++) {
+        UIImage *frame = [image animatedImageFrameAtIndex:i];
+        expect(frame).notTo.beNil();
+        expect(frame.sd_isDecoded).beTruthy();
+        expect(frame.size).equal(decodedFrames[i].size);
+        expect(frame.scale).equal(decodedFrames[i].scale);
+    }
+    expect(image.mappedFrameBufferSize).equal(mappedFrameBufferSize);
+    // Remove the file
+    image.maxMappedFrameBufferSize = 0;
+    expect(image.mappedFrameBufferSize).equal(0);
+
+    // The frame exceeding the size cap is still decoded
+    SDAnimatedImage *limitedImage = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    limitedImage.maxMappedFrameBufferSize = 1;
+    expect([limitedImage animatedImageFrameAtIndex:0]).notTo.beNil();
+    expect(limitedImage.mappedFrameBufferSize).equal(0);
+}
+
+- (void)test47FramePoolStoresDeltaFrames {
+    // The frames only change a small square in the center
+    SDGraphicsImageRendererFormat *format = [[SDGraphicsImageRendererFormat alloc] init];
+    format.scale = 1;
+    format.preferredRange = SDGraphicsImageRendererFormatRangeStandard;
+    SDGraphicsImageRenderer *renderer = [[SDGraphicsImageRenderer alloc] initWithSize:CGSizeMake(100, 100) format:format];
+    NSMutableArray<UIImage *> *frames = [NSMutableArray array];
+    for (NSUInteger i = 0; i < 3; i++) {
+        UIImage *frame = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+            CGContextSetRGBFillColor(context, 1.0, 0.0, 0.0, 1.0);
+            CGContextFillRect(context, CGRectMake(0, 0, 100, 100));
+            if (i > 0) {
+                CGContextSetRGBFillColor(context, 0.0, 0.0, 1.0 / i, 1.0);
+                CGContextFillRect(context, CGRectMake(45, 45, 10, 10));
+            }
+        }];
+        [frames addObject:frame];
+    }
+    SDImageDeltaKeyframe *keyframe = [[SDImageDeltaKeyframe alloc] initWithImage:frames[0]];
+    expect(keyframe).notTo.beNil();
+    SDImageDeltaFrame *sameFrame = [SDImageDeltaFrame deltaFrameWithImage:frames[0] keyframe:keyframe];
+    expect(CGRectIsEmpty(sameFrame.dirtyRect)).beTruthy();
+    expect(sameFrame.bytes).equal(0);
+    expect(sameFrame.composedImage).equal(keyframe.image);
+    SDImageDeltaFrame *deltaFrame = [SDImageDeltaFrame deltaFrameWithImage:frames[1] keyframe:keyframe];
+    expect(deltaFrame.dirtyRect).equal(CGRectMake(45, 45, 10, 10));
+    expect(deltaFrame.bytes).equal(10 * 10 * 4);
+    UIImage *composedImage = deltaFrame.composedImage;
+    expect(composedImage.size).equal(CGSizeMake(100, 100));
+    expect([[composedImage sd_colorAtPoint:CGPointMake(10, 10)] isEqual:[keyframe.image sd_colorAtPoint:CGPointMake(10, 10)]]).beTruthy();
+    expect([[composedImage sd_colorAtPoint:CGPointMake(50, 50)] isEqual:[keyframe.image sd_colorAtPoint:CGPointMake(50, 50)]]).beFalsy();
+    
+    // The wide color frame can not be stored as patch without loss
+    CGColorSpaceRef displayP3ColorSpace = CGColorSpaceCreateWithName(kCGColorSpaceDisplayP3);
+    CGContextRef displayP3Context = CGBitmapContextCreate(NULL, 100, 100, 8, 0, displayP3ColorSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+    CGColorSpaceRelease(displayP3ColorSpace);
+    CGImageRef displayP3ImageRef = CGBitmapContextCreateImage(displayP3Context);
+    CGContextRelease(displayP3Context);
+#if SD_MAC
+    UIImage *displayP3Image = [[UIImage alloc] initWithCGImage:displayP3ImageRef scale:1 orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *displayP3Image = [[UIImage alloc] initWithCGImage:displayP3ImageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(displayP3ImageRef);
+    expect([[SDImageDeltaKeyframe alloc] initWithImage:displayP3Image]).beNil();
+    expect([SDImageDeltaFrame deltaFrameWithImage:displayP3Image keyframe:keyframe]).beNil();
+    
+    // The frame pool only keep the patches besides one keyframe, which is opt-in
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    SDImageFramePool *framePool = [SDImageFramePool registerProvider:image];
+    expect(framePool.storesDeltaFrames).beFalsy();
+    framePool.storesDeltaFrames = YES;
+    [framePool removeAllFrames];
+    for (NSUInteger i = 0; i < frames.count; i++) {
+        [framePool setFrame:frames[i] atIndex:i];
+    }
+    expect(framePool.currentFrameCount).equal(frames.count);
+    expect([framePool containsFrameAtIndex:2]).beTruthy();
+    expect([framePool frameAtIndex:2].size).equal(CGSizeMake(100, 100));
+    NSUInteger deltaBufferBytes = framePool.currentBufferBytes;
+    expect(deltaBufferBytes).equal(keyframe.bytes + 2 * deltaFrame.bytes);
+    
+    // The composed frame prepared ahead is used once
+    [framePool prepareFrameAtIndex:1];
+    [[framePool valueForKey:@"fetchQueue"] waitUntilAllOperationsAreFinished]; // Access the internal property, only for test and may be changed in the future
+    expect(framePool.currentBufferBytes).equal(deltaBufferBytes + composedImage.sd_memoryCost);
+    UIImage *preparedImage = [framePool frameAtIndex:1];
+    expect(preparedImage.size).equal(CGSizeMake(100, 100));
+    expect([[preparedImage sd_colorAtPoint:CGPointMake(50, 50)] isEqual:[composedImage sd_colorAtPoint:CGPointMake(50, 50)]]).beTruthy();
+    expect(framePool.currentBufferBytes).equal(deltaBufferBytes);
+    
+    // The keyframe is kept by the pool after the delta frames evicted, and released when all frames are removed
+    __weak SDImageDeltaKeyframe *weakKeyframe;
+    @autoreleasepool {
+        weakKeyframe = [framePool valueForKey:@"keyframe"];
+        expect(weakKeyframe).notTo.beNil();
+        for (NSUInteger i = 0; i < frames.count; i++) {
+            [framePool removeFrameAtIndex:i];
+        }
+        expect([framePool valueForKey:@"keyframe"]).equal(weakKeyframe);
+        expect(framePool.currentBufferBytes).equal(keyframe.bytes);
+        [framePool removeAllFrames];
+    }
+    expect(weakKeyframe).beNil();
+    
+    // Stop diffing when most of the frames change the whole canvas
+    for (NSUInteger i = 0; i < 10; i++) {
+        UIImage *frame = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+            CGContextSetRGBFillColor(context, i > 0 ? 1.0 : 0.0, 0.0, i > 0 ? 0.0 : 1.0, 1.0);
+            CGContextFillRect(context, CGRectMake(0, 0, 100, 100));
+        }];
+        [framePool setFrame:frame atIndex:i];
+    }
+    expect([framePool valueForKey:@"keyframe"]).beNil();
+    [framePool removeAllFrames];
+    
+    // The image view forwards the opt-in to the shared frame pool
+    framePool.storesDeltaFrames = NO;
+    SDAnimatedImageView *imageView = [SDAnimatedImageView new];
+    imageView.storesDeltaFrames = YES;
+    imageView.image = image;
+    expect(imageView.player.storesDeltaFrames).beTruthy();
+    expect(framePool.storesDeltaFrames).beTruthy();
+    imageView.storesDeltaFrames = NO;
+    expect(framePool.storesDeltaFrames).beFalsy();
+    imageView.image = nil;
+    
+    for (NSUInteger i = 0; i < frames.count; i++) {
+        [framePool setFrame:frames[i] atIndex:i];
+    }
+    expect(framePool.currentBufferBytes).beGreaterThan(deltaBufferBytes * 2);
+    [framePool removeAllFrames];
+    [SDImageFramePool unregisterProvider:image];
+}
+
+- (void)test48AnimationTransformerCacheTransformedFrames {
+    UIImage *testImage = [[UIImage alloc] initWithData:[self testJPEGData]];
+    SDWebImageTestTransformer *transformer = [SDWebImageTestTransformer new];
+    transformer.testImage = testImage;
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testGIFData]];
+    image.maxMappedFrameBufferSize = 100 * 1024 * 1024;
+    
+    SDAnimatedImageView *imageView1 = [SDAnimatedImageView new];
+    imageView1.animationTransformer = transformer;
+    imageView1.image = image;
+    SDAnimatedImageView *imageView2 = [SDAnimatedImageView new];
+    imageView2.animationTransformer = transformer;
+    imageView2.image = image;
+    id<SDAnimatedImageProvider> provider1 = [imageView1.player valueForKey:@"animatedProvider"]; // Access the internal property, only for test and may be changed in the future
+    id<SDAnimatedImageProvider> provider2 = [imageView2.player valueForKey:@"animatedProvider"];
+    // The same image and transformer key share the transformed frames
+    id transformedFrameBuffer = [(NSObject *)provider1 valueForKey:@"transformedFrameBuffer"];
+    expect(transformedFrameBuffer).notTo.beNil();
+    expect([(NSObject *)provider2 valueForKey:@"transformedFrameBuffer"]).equal(transformedFrameBuffer);
+    
+    // First time transform, later read back from the buffer
+    UIImage *transformedFrame = [provider1 animatedImageFrameAtIndex:1];
+    expect(transformedFrame.size).equal(testImage.size);
+    transformer.testImage = nil;
+    UIImage *cachedFrame = [provider2 animatedImageFrameAtIndex:1];
+    expect(cachedFrame).notTo.beNil();
+    expect(cachedFrame.size).equal(testImage.size);
+    expect(((SDImageMappedFrameBuffer *)transformedFrameBuffer).frameCount).equal(1);
+}
+
+- (void)test49AnimatedImageMemoryCostTrackBufferedFrames {
+    SDAnimatedImage *image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    NSUInteger posterCost = image.sd_memoryCost;
+    expect(posterCost).beGreaterThan(0);
+    
+    // Buffered frames are counted, and the changes are coalesced into one notification to memory cache
+    __block NSUInteger notificationCount = 0;
+    id observer = [[NSNotificationCenter defaultCenter] addObserverForName:SDImageMemoryCostDidChangeNotification object:image queue:nil usingBlock:^(NSNotification * _Nonnull note) {
+        notificationCount++;
+    }];
+    SDImageFramePool *framePool = [SDImageFramePool registerProvider:image];
+    [framePool removeAllFrames];
+    UIImage *frame = [SDImageCoderHelper decodedImageWithImage:[image animatedImageFrameAtIndex:1]];
+    [framePool setFrame:frame atIndex:1];
+    [framePool setFrame:frame atIndex:2];
+    expect(framePool.currentBufferBytes).equal(frame.sd_memoryCost * 2);
+    expect(image.sd_memoryCost).equal(posterCost + framePool.currentBufferBytes);
+    [self expectationForNotification:SDImageMemoryCostDidChangeNotification object:image handler:nil];
+    [self waitForExpectationsWithCommonTimeout];
+    expect(notificationCount).equal(1);
+    
+    // Evicted frames are not counted
+    [framePool removeFrameAtIndex:2];
+    expect(framePool.currentBufferBytes).equal(frame.sd_memoryCost);
+    [framePool removeAllFrames];
+    expect(framePool.currentBufferBytes).equal(0);
+    expect(image.sd_memoryCost).equal(posterCost);
+    [self expectationForNotification:SDImageMemoryCostDidChangeNotification object:image handler:nil];
+    [self waitForExpectationsWithCommonTimeout];
+    expect(notificationCount).equal(2);
+    [SDImageFramePool unregisterProvider:image];
+    
+    // Pre-loaded frames are counted
+    [image preloadAllFrames];
+    expect(image.sd_memoryCost).beGreaterThan(posterCost * image.animatedImageFrameCount);
+    [self expectationForNotification:SDImageMemoryCostDidChangeNotification object:image handler:nil];
+    [self waitForExpectationsWithCommonTimeout];
+    expect(notificationCount).equal(3);
+    [image unloadAllFrames];
+    expect(image.sd_memoryCost).equal(posterCost);
+    [[NSNotificationCenter defaultCenter] removeObserver:observer];
+}
+
+- (void)test50PreloadAllFramesInsideDecodeSlotNotDeadlock {
+    XCTestExpectation *expectation1 = [self expectationWithDescription:@"Preload 1 inside decode slot finished"];
+    XCTestExpectation *expectation2 = [self expectationWithDescription:@"Preload 2 inside decode slot finished"];
+    SDImageDecodeScheduler *scheduler = SDImageDecodeScheduler.sharedScheduler;
+    NSUInteger maxConcurrentDecodes = scheduler.maxConcurrentDecodes;
+    scheduler.maxConcurrentDecodes = 2;
+    // The same as `SDWebImagePreloadAllFrames` during decoding, each load holds one slot and preload the frames in parallel
+    NSData *data = [self testGIFData];
+    for (XCTestExpectation *expectation in @[expectation1, expectation2]) {
+        dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+            [scheduler performWithCost:0 priority:SDImageDecodePriorityNormal block:^{
+                SDAnimatedImage *image = [SDAnimatedImage imageWithData:data];
+                [image preloadAllFrames];
+                expect(image.isAllFramesLoaded).beTruthy();
+            }];
+            [expectation fulfill];
+        });
+    }
+    
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        scheduler.maxConcurrentDecodes = maxConcurrentDecodes;
+    }];
+}
+
+- (void)test51MappedFrameBufferKeepColorSpaceAndOrientation {
+    SDImageMappedFrameBuffer *frameBuffer = [[SDImageMappedFrameBuffer alloc] initWithLimitBytes:10 * 1024 * 1024];
+    // The Display P3 frame keep its color space
+    CGColorSpaceRef displayP3ColorSpace = CGColorSpaceCreateWithName(kCGColorSpaceDisplayP3);
+    CGContextRef displayP3Context = CGBitmapContextCreate(NULL, 100, 50, 8, 0, displayP3ColorSpace, kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst);
+    CGContextSetRGBFillColor(displayP3Context, 1.0, 0.0, 0.0, 1.0);
+    CGContextFillRect(displayP3Context, CGRectMake(0, 0, 100, 50));
+    CGImageRef displayP3ImageRef = CGBitmapContextCreateImage(displayP3Context);
+    CGContextRelease(displayP3Context);
+#if SD_MAC
+    UIImage *displayP3Image = [[UIImage alloc] initWithCGImage:displayP3ImageRef scale:1 orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *displayP3Image = [[UIImage alloc] initWithCGImage:displayP3ImageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(displayP3ImageRef);
+    UIImage *storedFrame = [frameBuffer storeFrame:displayP3Image atIndex:0];
+    expect(storedFrame).notTo.beNil();
+    expect(CFEqual(CGImageGetColorSpace(storedFrame.CGImage), displayP3ColorSpace)).beTruthy();
+    expect(CGImageGetBitsPerComponent(storedFrame.CGImage)).equal(8);
+    CGColorSpaceRelease(displayP3ColorSpace);
+    
+#if SD_UIKIT
+    // The rotated frame keep its orientation
+    UIImage *rotatedImage = [[UIImage alloc] initWithCGImage:displayP3Image.CGImage scale:1 orientation:UIImageOrientationRight];
+    UIImage *rotatedFrame = [frameBuffer storeFrame:rotatedImage atIndex:1];
+    expect(rotatedFrame.imageOrientation).equal(UIImageOrientationRight);
+    expect(rotatedFrame.size).equal(CGSizeMake(50, 100));
+    expect([frameBuffer frameAtIndex:1].imageOrientation).equal(UIImageOrientationRight);
+#endif
+    
+    // The HDR frame (16-bit float) is not stored
+    CGColorSpaceRef extendedColorSpace = CGColorSpaceCreateWithName(kCGColorSpaceExtendedLinearSRGB);
+    CGContextRef hdrContext = CGBitmapContextCreate(NULL, 100, 50, 16, 0, extendedColorSpace, kCGBitmapByteOrder16Host | kCGImageAlphaPremultipliedLast | kCGBitmapFloatComponents);
+    CGColorSpaceRelease(extendedColorSpace);
+    CGImageRef hdrImageRef = CGBitmapContextCreateImage(hdrContext);
+    CGContextRelease(hdrContext);
+#if SD_MAC
+    UIImage *hdrImage = [[UIImage alloc] initWithCGImage:hdrImageRef scale:1 orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *hdrImage = [[UIImage alloc] initWithCGImage:hdrImageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(hdrImageRef);
+    expect([frameBuffer storeFrame:hdrImage atIndex:2]).beNil();
+    expect([frameBuffer frameAtIndex:2]).beNil();
+}
+
+- (void)test52AnimatedImageViewUpdateFrameRateWhenScrolled {
+#if SD_UIKIT
+    UIScrollView *scrollView = [[UIScrollView alloc] initWithFrame:CGRectMake(0, 0, 100, 100)];
+    scrollView.contentSize = CGSizeMake(100, 1000);
+    [self.window addSubview:scrollView];
+    SDAnimatedImageView *imageView = [[SDAnimatedImageView alloc] initWithFrame:CGRectMake(0, 500, 100, 100)];
+    [scrollView addSubview:imageView];
+#else
+    NSScrollView *scrollView = [[NSScrollView alloc] initWithFrame:NSMakeRect(0, 0, 100, 100)];
+    scrollView.documentView = [[NSView alloc] initWithFrame:NSMakeRect(0, 0, 100, 1000)];
+    [self.window.contentView addSubview:scrollView];
+    SDAnimatedImageView *imageView = [[SDAnimatedImageView alloc] initWithFrame:NSMakeRect(0, 500, 100, 100)];
+    [scrollView.documentView addSubview:imageView];
+#endif
+    imageView.image = [SDAnimatedImage imageWithData:[self testAPNGPData]];
+    imageView.automaticallyReducesFrameRate = YES;
+    // Outside of the scroll view bounds, although inside the window bounds
+    expect(imageView.player.maxFrameRate).equal(2);
+    // Scroll in, updated without waiting for the next frame
+#if SD_UIKIT
+    scrollView.contentOffset = CGPointMake(0, 500);
+#else
+    [scrollView.contentView scrollToPoint:NSMakePoint(0, 500)];
+#endif
+    expect(imageView.player.maxFrameRate).equal(0);
+    // Scroll out
+#if SD_UIKIT
+    scrollView.contentOffset = CGPointZero;
+#else
+    [scrollView.contentView scrollToPoint:NSZeroPoint];
+#endif
+    expect(imageView.player.maxFrameRate).equal(2);
+    [scrollView removeFromSuperview];
+#if SD_UIKIT
+    expect([imageView valueForKey:@"observedScrollView"]).beNil(); // Access the internal property, only for test and may be changed in the future
+#endif
+}
+
+- (void)test53PausedPlayerKeepReducedBudgetShare {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"test paused SDAnimatedImagePlayer keep the reduced budget share"];
+    SDAnimatedImagePlayer.maxTotalBufferSize = 1000;
+    // Different providers of the same data, so the frame pools have the same demand
+    SDAnimatedImagePlayer *playingPlayer = [SDAnimatedImagePlayer playerWithProvider:[SDAnimatedImage imageWithData:[self testAPNGPData]]];
+    SDAnimatedImagePlayer *pausedPlayer = [SDAnimatedImagePlayer playerWithProvider:[SDAnimatedImage imageWithData:[self testAPNGPData]]];
+    SDImageFramePool *playingFramePool = [playingPlayer valueForKey:@"framePool"]; // Access the internal property, only for test and may be changed in the future
+    SDImageFramePool *pausedFramePool = [pausedPlayer valueForKey:@"framePool"];
+    [playingPlayer startPlaying];
+    [pausedPlayer startPlaying];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.5 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        expect(playingFramePool.budgetBytes).beGreaterThan(0);
+        expect(pausedFramePool.budgetBytes).beGreaterThan(0);
+        // The paused player keeps the buffered frames, with the invisible share
+        [pausedPlayer pausePlaying];
+        expect(pausedFramePool.budgetBytes).beGreaterThan(0);
+        expect(pausedFramePool.budgetBytes).beLessThan(playingFramePool.budgetBytes);
+        // The invisible playing player get the same reduced share
+        [pausedPlayer startPlaying];
+        playingPlayer.visible = NO;
+        expect(playingFramePool.budgetBytes).beLessThan(pausedFramePool.budgetBytes);
+        playingPlayer.visible = YES;
+        // Give back the share when the frame buffer is cleared
+        [pausedPlayer pausePlaying];
+        [pausedPlayer clearFrameBuffer];
+        expect(pausedFramePool.budgetBytes).equal(0);
+        [playingPlayer stopPlaying];
+        [playingPlayer clearFrameBuffer];
+        expect(playingFramePool.budgetBytes).equal(0);
+        SDAnimatedImagePlayer.maxTotalBufferSize = 0;
+        [expectation fulfill];
+    });
+
+    [self waitForExpectationsWithCommonTimeout];
+}
+
 - (void)testAnimationTransformerWorks {
     XCTestExpectation *expectation = [self expectationWithDescription:@"test SDAnimatedImageView animationTransformer works"];
     SDAnimatedImageView *imageView = [SDAnimatedImageView new];
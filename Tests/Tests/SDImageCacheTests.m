@@ -967,6 +967,77 @@ static NSString *kTestImageKeyPNG = @"TestImageKey.png";
     expect(cacheFiles.count).equal(0);
 }
 
+- (void)test59DiskCacheValidatorsAndRefresh {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"SDImageCache cache validators read/write and refresh works"];
+    UIImage *image = [self testPNGImage];
+    NSDictionary<NSString *, NSString *> *cacheValidators = @{@"ETag" : @"\"abc\"", @"Last-Modified" : @"Wed, 21 Oct 2015 07:28:00 GMT"};
+    image.sd_cacheValidators = cacheValidators;
+    [SDImageCache.sharedImageCache removeImageFromMemoryForKey:kTestImageKeyPNG];
+    [SDImageCache.sharedImageCache removeImageFromDiskForKey:kTestImageKeyPNG];
+    // Write validators
+    [SDImageCache.sharedImageCache storeImage:image forKey:kTestImageKeyPNG completion:^{
+        SDDiskCache *diskCache = (SDDiskCache *)SDImageCache.sharedImageCache.diskCache;
+        expect([diskCache cacheValidatorsForKey:kTestImageKeyPNG]).equal(cacheValidators);
+        // Read validators
+        UIImage *newImage = [SDImageCache.sharedImageCache imageFromDiskCacheForKey:kTestImageKeyPNG];
+        expect(newImage.sd_cacheValidators).equal(cacheValidators);
+        // Make the file outdated, then refresh with new validators
+        NSString *cachePath = [SDImageCache.sharedImageCache cachePathForKey:kTestImageKeyPNG];
+        NSDate *oldDate = [NSDate dateWithTimeIntervalSinceNow:-3600];
+        [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate : oldDate} ofItemAtPath:cachePath error:nil];
+        NSData *oldData = [NSData dataWithContentsOfFile:cachePath];
+        NSDictionary<NSString *, NSString *> *newCacheValidators = @{@"ETag" : @"\"def\""};
+        [SDImageCache.sharedImageCache refreshImageForKey:kTestImageKeyPNG cacheValidators:newCacheValidators completion:^{
+            expect([diskCache cacheValidatorsForKey:kTestImageKeyPNG]).equal(newCacheValidators);
+            NSDate *modificationDate = [[NSFileManager defaultManager] attributesOfItemAtPath:cachePath error:nil][NSFileModificationDate];
+            expect([modificationDate timeIntervalSinceDate:oldDate]).beGreaterThan(3000);
+            // Data is not rewritten
+            expect([NSData dataWithContentsOfFile:cachePath]).equal(oldData);
+            [diskCache setCacheValidators:nil forKey:kTestImageKeyPNG];
+            expect([diskCache cacheValidatorsForKey:kTestImageKeyPNG]).beNil();
+            [expectation fulfill];
+        }];
+    }];
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test60DiskQueryWaitingForDecodeBudgetNotBlockIOQueue {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Disk query waiting for decode budget should not block other IO"];
+    SDImageCache *cache = [[SDImageCache alloc] initWithNamespace:@"DecodeBudget"];
+    [cache storeImageDataToDisk:[NSData dataWithContentsOfFile:[self testJPEGPath]] forKey:kTestImageKeyJPEG];
+    SDImageDecodeScheduler *scheduler = SDImageDecodeScheduler.sharedScheduler;
+    NSUInteger maxConcurrentDecodes = scheduler.maxConcurrentDecodes;
+    scheduler.maxConcurrentDecodes = 1;
+    // Hold the only slot, until the sync IO finished
+    dispatch_semaphore_t holdSemaphore = dispatch_semaphore_create(0);
+    dispatch_semaphore_t heldSemaphore = dispatch_semaphore_create(0);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        [scheduler performWithCost:0 priority:SDImageDecodePriorityNormal block:^{
+            dispatch_semaphore_signal(heldSemaphore);
+            dispatch_semaphore_wait(holdSemaphore, dispatch_time(DISPATCH_TIME_NOW, (int64_t)(5 * NSEC_PER_SEC)));
+        }];
+    });
+    dispatch_semaphore_wait(heldSemaphore, DISPATCH_TIME_FOREVER);
+    
+    [cache queryCacheOperationForKey:kTestImageKeyJPEG done:^(UIImage * _Nullable image, NSData * _Nullable data, SDImageCacheType cacheType) {
+        expect(image).notTo.beNil();
+        expect(cacheType).equal(SDImageCacheTypeDisk);
+        scheduler.maxConcurrentDecodes = maxConcurrentDecodes;
+        [cache clearDiskOnCompletion:nil];
+        [expectation fulfill];
+    }];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, kMinDelayNanosecond), dispatch_get_main_queue(), ^{
+        // The query is waiting for the budget now, the sync IO from main thread should return immediately
+        expect(scheduler.pendingCount).beGreaterThan(0);
+        CFAbsoluteTime startTime = CFAbsoluteTimeGetCurrent();
+        expect([cache diskImageDataExistsWithKey:kTestImageKeyJPEG]).beTruthy();
+        expect(CFAbsoluteTimeGetCurrent() - startTime).beLessThan(1);
+        dispatch_semaphore_signal(holdSemaphore);
+    });
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
 #pragma mark Helper methods
 
 - (UIImage *)testJPEGImage {
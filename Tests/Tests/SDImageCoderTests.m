@@ -9,6 +9,38 @@
 
 #import "SDTestCase.h"
 #import "UIColor+SDHexString.h"
+#import "SDImageIOAnimatedCoderInternal.h"
+#import "SDWebImageTestCoder.h"
+
+// The subclass which only overrides `canDecodeFromData:`, should not be bypassed by format
+@interface SDWebImageTestRejectGIFCoder : SDImageGIFCoder
+@end
+
+@implementation SDWebImageTestRejectGIFCoder
+
+- (BOOL)canDecodeFromData:(NSData *)data {
+    return NO;
+}
+
+@end
+
+// The subclass which overrides both, decides by format and is not probed
+@interface SDWebImageTestCountingIOCoder : SDImageIOCoder
+@property (nonatomic, assign) NSUInteger probeCount;
+@end
+
+@implementation SDWebImageTestCountingIOCoder
+
+- (BOOL)canDecodeFromData:(NSData *)data {
+    self.probeCount++;
+    return [super canDecodeFromData:data];
+}
+
+- (BOOL)canDecodeFromFormat:(SDImageFormat)format {
+    return [super canDecodeFromFormat:format];
+}
+
+@end
 
 @interface SDWebImageDecoderTests : SDTestCase
 
@@ -761,6 +793,199 @@
     }
 }
 
+- (void)test35ThatAnimatedCoderScanFrameDurationLazily {
+    NSURL *url = [[NSBundle bundleForClass:[self class]] URLForResource:@"TestImage" withExtension:@"gif"];
+    NSData *data = [NSData dataWithContentsOfURL:url];
+    SDImageGIFCoder *coder = [[SDImageGIFCoder alloc] initWithAnimatedImageData:data options:nil];
+    expect(coder).notTo.beNil();
+    NSUInteger frameCount = coder.animatedImageFrameCount;
+    expect(frameCount).beGreaterThan(1);
+    // The first frame available without scanning all frames
+    expect([coder animatedImageFrameAtIndex:0]).notTo.beNil();
+    
+    CGImageSourceRef source = CGImageSourceCreateWithData((__bridge CFDataRef)data, NULL);
+    // Scan in reverse order, the lazy result should match the frame properties
+    for (NSInteger i = frameCount - 1; i >= 0; i--) {
+        NSTimeInterval duration = [SDImageGIFCoder frameDurationAtIndex:i source:source];
+        expect([coder animatedImageDurationAtIndex:i]).equal(duration);
+        // Cached
+        expect([coder animatedImageDurationAtIndex:i]).equal(duration);
+    }
+    CFRelease(source);
+    expect([coder animatedImageDurationAtIndex:frameCount]).equal(0);
+}
+
+- (void)test36ThatIncrementalAnimatedCoderAppendFrames {
+    NSURL *url = [[NSBundle bundleForClass:[self class]] URLForResource:@"TestImage" withExtension:@"gif"];
+    NSData *data = [NSData dataWithContentsOfURL:url];
+    SDImageGIFCoder *coder = [[SDImageGIFCoder alloc] initIncrementalWithOptions:nil];
+    NSUInteger previousFrameCount = 0;
+    NSUInteger step = MAX(data.length / 20, 1);
+    for (NSUInteger length = step; length < data.length; length += step) {
+        [coder updateIncrementalData:[data subdataWithRange:NSMakeRange(0, length)] finished:NO];
+        NSUInteger frameCount = coder.animatedImageFrameCount;
+        // Frame table only grows
+        expect(frameCount).beGreaterThanOrEqualTo(previousFrameCount);
+        if (frameCount > 0) {
+            expect([coder animatedImageDurationAtIndex:frameCount - 1]).beGreaterThan(0);
+        }
+        previousFrameCount = frameCount;
+    }
+    [coder updateIncrementalData:data finished:YES];
+    
+    SDImageGIFCoder *fullCoder = [[SDImageGIFCoder alloc] initWithAnimatedImageData:data options:nil];
+    expect(coder.animatedImageFrameCount).equal(fullCoder.animatedImageFrameCount);
+    for (NSUInteger i = 0; i < fullCoder.animatedImageFrameCount; i++) {
+        expect([coder animatedImageDurationAtIndex:i]).equal([fullCoder animatedImageDurationAtIndex:i]);
+    }
+}
+
+- (void)test37ThatCodersManagerDispatchByFormat {
+    NSData *GIFData = [NSData dataWithContentsOfFile:[[NSBundle bundleForClass:[self class]] pathForResource:@"TestImage" ofType:@"gif"]];
+    NSData *JPEGData = [NSData dataWithContentsOfFile:[[NSBundle bundleForClass:[self class]] pathForResource:@"TestImage" ofType:@"jpg"]];
+    SDImageCodersManager *manager = [[SDImageCodersManager alloc] init];
+    manager.coders = @[SDImageIOCoder.sharedCoder, SDImageGIFCoder.sharedCoder, SDImageHEICCoder.sharedCoder];
+    expect([SDImageGIFCoder.sharedCoder canDecodeFromFormat:SDImageFormatGIF]).beTruthy();
+    expect([SDImageGIFCoder.sharedCoder canDecodeFromFormat:SDImageFormatJPEG]).beFalsy();
+    expect([SDImageHEICCoder.sharedCoder canDecodeFromFormat:SDImageFormatJPEG]).beFalsy();
+    expect([SDImageIOCoder.sharedCoder canDecodeFromFormat:SDImageFormatJPEG]).beTruthy();
+    expect([SDImageIOCoder.sharedCoder canDecodeFromFormat:SDImageFormatUndefined]).beTruthy();
+    
+    // GIF is dispatched to the GIF coder, which produce animated image
+    UIImage *GIFImage = [manager decodedImageWithData:GIFData options:nil];
+    expect(GIFImage.sd_isAnimated).beTruthy();
+    expect(GIFImage.sd_imageFormat).equal(SDImageFormatGIF);
+    // JPEG skips the declared coders, and dispatched to the Image/IO coder without probe
+    expect([manager canDecodeFromData:JPEGData]).beTruthy();
+    UIImage *JPEGImage = [manager decodedImageWithData:JPEGData options:nil];
+    expect(JPEGImage).notTo.beNil();
+    expect(JPEGImage.sd_imageFormat).equal(SDImageFormatJPEG);
+    
+    // The coder which does not declare formats is still probed in the priority order
+    SDWebImageTestCoder *testCoder = [SDWebImageTestCoder new];
+    [manager addCoder:testCoder];
+    UIImage *testImage = [manager decodedImageWithData:GIFData options:nil];
+    expect(testImage).notTo.beNil();
+    expect(testImage.sd_isAnimated).beFalsy();
+    // Table is rebuilt after coders changed
+    [manager removeCoder:testCoder];
+    expect([manager decodedImageWithData:GIFData options:nil].sd_isAnimated).beTruthy();
+    manager.coders = @[SDImageGIFCoder.sharedCoder];
+    expect([manager canDecodeFromData:GIFData]).beTruthy();
+    expect([manager canDecodeFromData:JPEGData]).beFalsy();
+    // The subclass overrides `canDecodeFromData:` is still probed
+    manager.coders = @[[SDWebImageTestRejectGIFCoder new]];
+    expect([manager canDecodeFromData:GIFData]).beFalsy();
+    // The coder decides by format is not probed
+    SDWebImageTestCountingIOCoder *countingCoder = [SDWebImageTestCountingIOCoder new];
+    manager.coders = @[countingCoder];
+    expect([manager decodedImageWithData:JPEGData options:nil]).notTo.beNil();
+    expect(countingCoder.probeCount).equal(0);
+}
+
+- (void)test38ThatTileSourceDecodeRegionAtLevelOfDetail {
+    NSString *testImagePath = [[NSBundle bundleForClass:[self class]] pathForResource:@"TestImageLarge" ofType:@"jpg"];
+    SDImageTileSource *tileSource = [[SDImageTileSource alloc] initWithContentsOfFile:testImagePath];
+    expect(tileSource).notTo.beNil();
+    expect([[SDImageTileSource alloc] initWithData:[NSData data]]).beNil();
+    // 5250x3450, 256x256 tile
+    expect(tileSource.pixelSize).equal(CGSizeMake(5250, 3450));
+    expect(tileSource.maxLevelOfDetail).equal(5);
+    expect([tileSource pixelSizeForLevelOfDetail:1]).equal(CGSizeMake(2625, 1725));
+    expect([tileSource pixelSizeForLevelOfDetail:5]).equal(CGSizeMake(165, 108));
+    expect([tileSource levelOfDetailForScale:2]).equal(0);
+    expect([tileSource levelOfDetailForScale:0.3]).equal(1);
+    expect([tileSource levelOfDetailForScale:0.01]).equal(5);
+    
+    // Full resolution tile, and the edge tile is clipped
+    UIImage *tile = [tileSource tileImageAtColumn:1 row:1 levelOfDetail:0];
+    expect(tile.size).equal(CGSizeMake(256, 256));
+    UIImage *edgeTile = [tileSource tileImageAtColumn:20 row:13 levelOfDetail:0];
+    expect(edgeTile.size).equal(CGSizeMake(130, 122));
+    expect([tileSource tileImageAtColumn:21 row:0 levelOfDetail:0]).beNil();
+    // Cached
+    expect([tileSource tileImageForRect:CGRectMake(256, 256, 256, 256) levelOfDetail:0]).equal(tile);
+    // Subsampled level, and the coarse level from thumbnail
+    expect([tileSource tileImageForRect:CGRectMake(2500, 1600, 300, 300) levelOfDetail:1].size).equal(CGSizeMake(125, 125));
+    expect([tileSource tileImageAtColumn:0 row:0 levelOfDetail:4].size).equal(CGSizeMake(256, 216));
+    expect([tileSource tileImageAtColumn:0 row:0 levelOfDetail:5].size).equal(CGSizeMake(165, 108));
+    expect([tileSource tileImageAtColumn:0 row:0 levelOfDetail:6]).beNil();
+    // The tile is the same as the region of full image
+    UIImage *fullImage = [[UIImage alloc] initWithContentsOfFile:testImagePath];
+    UIColor *tileColor = [tile sd_colorAtPoint:CGPointMake(100, 100)];
+    UIColor *fullColor = [fullImage sd_colorAtPoint:CGPointMake(356, 356)];
+    CGFloat r1, g1, b1, a1, r2, g2, b2, a2;
+    [tileColor getRed:&r1 green:&g1 blue:&b1 alpha:&a1];
+    [fullColor getRed:&r2 green:&g2 blue:&b2 alpha:&a2];
+    expect(r1).beCloseToWithin(r2, 0.02);
+    expect(g1).beCloseToWithin(g2, 0.02);
+    expect(b1).beCloseToWithin(b2, 0.02);
+    
+    [tileSource removeAllTiles];
+    expect([tileSource tileImageForRect:CGRectMake(256, 256, 256, 256) levelOfDetail:0].size).equal(CGSizeMake(256, 256));
+}
+
+- (void)test39ThatEncodeWithFramesReportProgressAndCancel {
+    NSMutableArray<SDImageFrame *> *frames = [NSMutableArray array];
+    NSUInteger frameCount = 20;
+    CGSize size = CGSizeMake(100, 100);
+    SDGraphicsImageRenderer *renderer = [[SDGraphicsImageRenderer alloc] initWithSize:size];
+    for (size_t i = 0; i < frameCount; i++) {
+        UIImage *image = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+            CGContextSetRGBFillColor(context, (CGFloat)i / frameCount, 0.0, 0.0, 1.0);
+            CGContextFillRect(context, CGRectMake(0, 0, size.width, size.height));
+        }];
+        [frames addObject:[SDImageFrame frameWithImage:image duration:0.1]];
+    }
+    
+    // The frames are prepared concurrently, but appended and reported in order
+    __block NSUInteger lastEncodedFrameCount = 0;
+    SDImageCoderEncodeProgressBlock progressBlock = ^(NSUInteger encodedFrameCount, NSUInteger totalFrameCount, BOOL *stop) {
+        expect(totalFrameCount).equal(frameCount);
+        expect(encodedFrameCount).equal(lastEncodedFrameCount + 1);
+        lastEncodedFrameCount = encodedFrameCount;
+    };
+    NSData *data = [SDImageGIFCoder.sharedCoder encodedDataWithFrames:frames loopCount:0 format:SDImageFormatGIF options:@{SDImageCoderEncodeProgress : progressBlock, SDImageCoderEncodeMaxPixelSize : @(CGSizeMake(50, 50))}];
+    expect(data).notTo.beNil();
+    expect(lastEncodedFrameCount).equal(frameCount);
+    SDImageGIFCoder *coder = [[SDImageGIFCoder alloc] initWithAnimatedImageData:data options:@{SDImageCoderDecodeScaleFactor : @(1)}];
+    expect(coder.animatedImageFrameCount).equal(frameCount);
+    UIImage *lastFrame = [coder animatedImageFrameAtIndex:frameCount - 1];
+    expect(lastFrame.size.width).beLessThanOrEqualTo(50);
+    expect(lastFrame.size.height).beLessThanOrEqualTo(50);
+    
+    // Cancel during encoding
+    __block NSUInteger cancelledFrameCount = 0;
+    SDImageCoderEncodeProgressBlock cancelBlock = ^(NSUInteger encodedFrameCount, NSUInteger totalFrameCount, BOOL *stop) {
+        cancelledFrameCount = encodedFrameCount;
+        if (encodedFrameCount == 3) {
+            *stop = YES;
+        }
+    };
+    NSData *cancelledData = [SDImageGIFCoder.sharedCoder encodedDataWithFrames:frames loopCount:0 format:SDImageFormatGIF options:@{SDImageCoderEncodeProgress : cancelBlock}];
+    expect(cancelledData).beNil();
+    expect(cancelledFrameCount).equal(3);
+    
+#if SD_UIKIT
+    // Non-Up frame comes out upright, animated image does not keep the EXIF orientation
+    CGSize rotatedSize = CGSizeMake(100, 50);
+    SDGraphicsImageRenderer *rotatedRenderer = [[SDGraphicsImageRenderer alloc] initWithSize:rotatedSize];
+    UIImage *upImage = [rotatedRenderer imageWithActions:^(CGContextRef  _Nonnull context) {
+        CGContextSetRGBFillColor(context, 1.0, 0.0, 0.0, 1.0);
+        CGContextFillRect(context, CGRectMake(0, 0, rotatedSize.width, rotatedSize.height));
+    }];
+    UIImage *rotatedImage = [[UIImage alloc] initWithCGImage:upImage.CGImage scale:1 orientation:UIImageOrientationRight];
+    NSArray<SDImageFrame *> *rotatedFrames = @[[SDImageFrame frameWithImage:rotatedImage duration:0.1], [SDImageFrame frameWithImage:rotatedImage duration:0.1]];
+    NSData *rotatedData = [SDImageGIFCoder.sharedCoder encodedDataWithFrames:rotatedFrames loopCount:0 format:SDImageFormatGIF options:nil];
+    expect(rotatedData).notTo.beNil();
+    SDImageGIFCoder *rotatedCoder = [[SDImageGIFCoder alloc] initWithAnimatedImageData:rotatedData options:@{SDImageCoderDecodeScaleFactor : @(1)}];
+    UIImage *rotatedFrame = [rotatedCoder animatedImageFrameAtIndex:0];
+    expect(rotatedFrame.imageOrientation).equal(UIImageOrientationUp);
+    expect(CGImageGetWidth(rotatedFrame.CGImage)).equal(50);
+    expect(CGImageGetHeight(rotatedFrame.CGImage)).equal(100);
+#endif
+}
+
 #pragma mark - Utils
 
 - (void)verifyCoder:(id<SDImageCoder>)coder
@@ -13,10 +13,17 @@
 #import "SDInternalMacros.h"
 #import "SDFileAttributeHelper.h"
 #import "UIColor+SDHexString.h"
+#import "SDImageProgressiveScanner.h"
+#import "SDImageHeaderParser.h"
+#import "SDImageDecodeScheduler.h"
+#import <malloc/malloc.h>
 
 @interface SDUtilsTests : SDTestCase
 
 @property (nonatomic) NSTimeInterval duration;
+@property (nonatomic) NSUInteger sharedCallCount;
+@property (nonatomic) NSUInteger skippedCallCount;
+@property (nonatomic) NSTimeInterval skippedDuration;
 
 @end
 
@@ -77,6 +84,44 @@
     self.duration += duration;
 }
 
+- (void)testSDSharedDisplayLink {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Shared Display Link"];
+    SDDisplayLink *displayLink1 = [SDDisplayLink sharedDisplayLinkWithTarget:self selector:@selector(sharedDisplayLinkDidRefresh:)];
+    SDDisplayLink *displayLink2 = [SDDisplayLink sharedDisplayLinkWithTarget:self selector:@selector(skippedDisplayLinkDidRefresh:)];
+    expect(displayLink1.isShared).beTruthy();
+    [displayLink1 addToRunLoop:NSRunLoop.mainRunLoop forMode:NSRunLoopCommonModes];
+    [displayLink2 addToRunLoop:NSRunLoop.mainRunLoop forMode:NSRunLoopCommonModes];
+    [displayLink1 start];
+    [displayLink2 start];
+    expect(displayLink1.isRunning).beTruthy();
+    expect(displayLink2.isRunning).beTruthy();
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(1 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        expect(displayLink1.refreshDuration).beGreaterThan(0);
+        // Called on each refresh
+        expect(self.sharedCallCount).beGreaterThan(10);
+        // Only called about every 200ms, the elapsed time is still accurate
+        expect(self.skippedCallCount).beLessThanOrEqualTo(6);
+        expect(self.skippedCallCount).beGreaterThan(0);
+        expect(self.skippedDuration).beCloseToWithin(1, 0.3);
+        [displayLink1 stop];
+        [displayLink2 stop];
+        expect(displayLink1.isRunning).beFalsy();
+        expect(displayLink1.duration).equal(0);
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)sharedDisplayLinkDidRefresh:(SDDisplayLink *)displayLink {
+    self.sharedCallCount++;
+}
+
+- (void)skippedDisplayLinkDidRefresh:(SDDisplayLink *)displayLink {
+    self.skippedCallCount++;
+    self.skippedDuration += displayLink.duration;
+    [displayLink scheduleNextCallbackAfter:0.2];
+}
+
 - (void)testSDFileAttributeHelper {
     NSData *fileData = [@"File Data" dataUsingEncoding:NSUTF8StringEncoding];
     NSData *extendedData = [@"Extended Data" dataUsingEncoding:NSUTF8StringEncoding];
@@ -225,6 +270,258 @@
     };
 }
 
+- (void)testSDImageProgressiveScanner {
+    // Progressive JPEG with 10 scans
+    NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
+    NSData *data = [NSData dataWithContentsOfFile:[testBundle pathForResource:@"TestImageLarge" ofType:@"jpg"]];
+    SDImageProgressiveScanner *scanner = [[SDImageProgressiveScanner alloc] initWithExpectedSize:data.length];
+    NSUInteger decodeCount = 0;
+    NSUInteger chunkCount = 0;
+    for (NSUInteger length = 1024; length < data.length + 1024; length += 1024) {
+        chunkCount++;
+        if ([scanner shouldDecodeWithData:[data subdataWithRange:NSMakeRange(0, MIN(length, data.length))]]) {
+            decodeCount++;
+        }
+    }
+    expect(scanner.completedScanCount).equal(10);
+    // Only decode on scan boundaries, instead of each received data
+    expect(decodeCount).beGreaterThan(0);
+    expect(decodeCount).beLessThanOrEqualTo(scanner.completedScanCount);
+    expect(decodeCount).beLessThan(chunkCount);
+    
+    // Non-interlaced PNG, decode when enough IDAT rows arrived
+    data = [NSData dataWithContentsOfFile:[testBundle pathForResource:@"TestImage" ofType:@"png"]];
+    scanner = [[SDImageProgressiveScanner alloc] initWithExpectedSize:data.length];
+    expect([scanner shouldDecodeWithData:[data subdataWithRange:NSMakeRange(0, 64)]]).beFalsy();
+    expect([scanner shouldDecodeWithData:data]).beTruthy();
+    expect([scanner shouldDecodeWithData:data]).beFalsy();
+    
+    // Other format always decode
+    data = [NSData dataWithContentsOfFile:[self testGIFPath]];
+    scanner = [[SDImageProgressiveScanner alloc] initWithExpectedSize:data.length];
+    expect([scanner shouldDecodeWithData:data]).beTruthy();
+}
+
+- (void)testSDImageHeaderParser {
+    NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
+    NSArray<NSArray *> *cases = @[
+        // name, extension, width, height, frame count, hints
+        @[@"TestImage", @"jpg", @80, @60, @1, @(SDImageHeaderHintNone)],
+        @[@"TestImageLarge", @"jpg", @5250, @3450, @1, @(SDImageHeaderHintProgressive)],
+        @[@"TestImage", @"png", @300, @300, @1, @(SDImageHeaderHintAlpha)],
+        @[@"TestImageAnimated", @"apng", @320, @240, @101, @(SDImageHeaderHintAlpha | SDImageHeaderHintAnimated)],
+        @[@"TestImage", @"gif", @50, @50, @5, @(SDImageHeaderHintAnimated)],
+        @[@"TestImageStatic", @"webp", @550, @368, @1, @(SDImageHeaderHintNone)],
+        @[@"TestImageAnimated", @"webp", @990, @1050, @8, @(SDImageHeaderHintAlpha | SDImageHeaderHintAnimated)],
+        @[@"TestImage", @"heic", @1440, @960, @1, @(SDImageHeaderHintNone)],
+    ];
+    for (NSArray *testCase in cases) {
+        NSData *data = [NSData dataWithContentsOfFile:[testBundle pathForResource:testCase[0] ofType:testCase[1]]];
+        SDImageHeaderInfo info = SDImageHeaderGetInfo(data.bytes, data.length);
+        expect(info.format).equal([NSData sd_imageFormatForImageData:data]);
+        expect(info.pixelWidth).equal([testCase[2] unsignedIntegerValue]);
+        expect(info.pixelHeight).equal([testCase[3] unsignedIntegerValue]);
+        expect(info.frameCount).equal([testCase[4] unsignedIntegerValue]);
+        expect(info.hints).equal([testCase[5] unsignedIntegerValue]);
+        expect(info.orientation).equal(kCGImagePropertyOrientationUp);
+        // The size is available in the first few KB
+        SDImageHeaderInfo prefixInfo = SDImageHeaderGetInfo(data.bytes, MIN(data.length, 4096));
+        expect(prefixInfo.pixelWidth).equal(info.pixelWidth);
+        expect(prefixInfo.pixelHeight).equal(info.pixelHeight);
+        // Truncated data never crash
+        for (NSUInteger length = 0; length < MIN(data.length, 1024); length++) {
+            SDImageHeaderGetInfo(data.bytes, length);
+        }
+    }
+    
+    // JPEG with EXIF orientation before SOF
+    const uint8_t JPEGBytes[] = {
+        0xFF, 0xD8,
+        // APP1 EXIF, big endian, IFD0 with orientation 6
+        0xFF, 0xE1, 0x00, 0x22, 'E', 'x', 'i', 'f', 0x00, 0x00,
+        'M', 'M', 0x00, 0x2A, 0x00, 0x00, 0x00, 0x08,
+        0x00, 0x01, 0x01, 0x12, 0x00, 0x03, 0x00, 0x00, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00,
+        0x00, 0x00, 0x00, 0x00,
+        // SOF2, 64x32
+        0xFF, 0xC2, 0x00, 0x11, 0x08, 0x00, 0x20, 0x00, 0x40, 0x03, 0x01, 0x22, 0x00, 0x02, 0x11, 0x01, 0x03, 0x11, 0x01,
+        0xFF, 0xD9
+    };
+    SDImageHeaderInfo info = SDImageHeaderGetInfo(JPEGBytes, sizeof(JPEGBytes));
+    expect(info.format).equal(SDImageFormatJPEG);
+    expect(info.pixelWidth).equal(64);
+    expect(info.pixelHeight).equal(32);
+    expect(info.orientation).equal(kCGImagePropertyOrientationRight);
+    expect(info.hints).equal(SDImageHeaderHintProgressive);
+    // SOF not arrived yet
+    info = SDImageHeaderGetInfo(JPEGBytes, 40);
+    expect(info.pixelWidth).equal(0);
+    expect(info.orientation).equal(kCGImagePropertyOrientationRight);
+    
+    expect(SDImageHeaderGetInfo(NULL, 0).format).equal(SDImageFormatUndefined);
+    expect(SDImageHeaderGetFormat("<svg></svg>", 11)).equal(SDImageFormatSVG);
+}
+
+- (void)testSDImageDecodeScheduler {
+    SDImageDecodeScheduler *scheduler = [[SDImageDecodeScheduler alloc] initWithMaxConcurrentDecodes:1 maxInFlightBytes:0];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Decode scheduler admits in priority order"];
+    expectation.expectedFulfillmentCount = 3;
+    dispatch_semaphore_t runningSemaphore = dispatch_semaphore_create(0);
+    NSMutableArray<NSString *> *order = [NSMutableArray array];
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+    void (^submit)(NSString *, SDImageDecodePriority) = ^(NSString *name, SDImageDecodePriority priority) {
+        dispatch_async(queue, ^{
+            [scheduler performWithCost:100 priority:priority block:^{
+                if ([name isEqualToString:@"first"]) {
+                    dispatch_semaphore_wait(runningSemaphore, DISPATCH_TIME_FOREVER);
+                }
+                @synchronized (order) {
+                    [order addObject:name];
+                }
+            }];
+            [expectation fulfill];
+        });
+    };
+    BOOL (^waitUntil)(BOOL (^)(void)) = ^BOOL(BOOL (^condition)(void)) {
+        NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:kAsyncTestTimeout];
+        while (!condition() && [deadline timeIntervalSinceNow] > 0) {
+            [NSThread sleepForTimeInterval:0.01];
+        }
+        return condition();
+    };
+    submit(@"first", SDImageDecodePriorityNormal);
+    expect(waitUntil(^BOOL{ return scheduler.runningCount == 1; })).beTruthy();
+    expect(scheduler.inFlightBytes).equal(100);
+    submit(@"low", SDImageDecodePriorityLow);
+    expect(waitUntil(^BOOL{ return scheduler.pendingCount == 1; })).beTruthy();
+    submit(@"high", SDImageDecodePriorityHigh);
+    expect(waitUntil(^BOOL{ return scheduler.pendingCount == 2; })).beTruthy();
+    // Main thread never waits
+    __block BOOL mainThreadPerformed = NO;
+    [scheduler performWithCost:0 priority:SDImageDecodePriorityBackground block:^{
+        mainThreadPerformed = YES;
+    }];
+    expect(mainThreadPerformed).beTruthy();
+    dispatch_semaphore_signal(runningSemaphore);
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        expect(order).equal(@[@"first", @"high", @"low"]);
+        expect(scheduler.runningCount).equal(0);
+        expect(scheduler.inFlightBytes).equal(0);
+        expect(scheduler.pendingCount).equal(0);
+    }];
+    
+    // Cost from image header
+    NSData *data = [NSData dataWithContentsOfFile:[self testJPEGPath]];
+    expect([SDImageDecodeScheduler decodeCostForImageData:data options:nil]).equal(80 * 60 * 4);
+    expect([SDImageDecodeScheduler decodeCostForImageData:data options:@{SDImageCoderDecodeThumbnailPixelSize : @(CGSizeMake(40, 40))}]).equal(40 * 30 * 4);
+    expect([SDImageDecodeScheduler decodeCostForImageData:data options:@{SDImageCoderDecodeScaleDownLimitBytes : @(1000)}]).equal(1000);
+}
+
+- (void)testSDImageDecodeSchedulerAsyncWithoutStarvation {
+    SDImageDecodeScheduler *scheduler = [[SDImageDecodeScheduler alloc] initWithMaxConcurrentDecodes:1 maxInFlightBytes:0];
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Decode scheduler admits async work, the low priority work is jumped over limited times"];
+    expectation.expectedFulfillmentCount = 11;
+    dispatch_semaphore_t runningSemaphore = dispatch_semaphore_create(0);
+    NSMutableArray<NSString *> *order = [NSMutableArray array];
+    void (^submit)(NSString *, SDImageDecodePriority) = ^(NSString *name, SDImageDecodePriority priority) {
+        [scheduler performAsyncWithCost:100 priority:priority queue:nil block:^{
+            if ([name isEqualToString:@"first"]) {
+                dispatch_semaphore_wait(runningSemaphore, DISPATCH_TIME_FOREVER);
+            }
+            @synchronized (order) {
+                [order addObject:name];
+            }
+            [expectation fulfill];
+        }];
+    };
+    submit(@"first", SDImageDecodePriorityNormal);
+    submit(@"low", SDImageDecodePriorityLow);
+    for (NSUInteger i = 0; i < 9; i++) {
+        submit(@"high", SDImageDecodePriorityHigh);
+    }
+    // The pending async work does not occupy any thread
+    expect(scheduler.runningCount).equal(1);
+    expect(scheduler.pendingCount).equal(10);
+    dispatch_semaphore_signal(runningSemaphore);
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        NSMutableArray<NSString *> *expectedOrder = [NSMutableArray arrayWithObject:@"first"];
+        for (NSUInteger i = 0; i < 8; i++) {
+            [expectedOrder addObject:@"high"];
+        }
+        [expectedOrder addObjectsFromArray:@[@"low", @"high"]];
+        expect(order).equal(expectedOrder);
+        expect(scheduler.runningCount).equal(0);
+        expect(scheduler.pendingCount).equal(0);
+    }];
+}
+
+- (void)testSDImageBufferPool {
+    SDImageBufferPool *pool = [[SDImageBufferPool alloc] init];
+    pool.maxBytes = 1024 * 1024;
+    // Small buffer is not pooled
+    void *smallBuffer = [pool allocateBufferWithLength:100];
+    expect(smallBuffer != NULL).beTruthy();
+    [pool recycleBuffer:smallBuffer length:100];
+    expect(pool.pooledBytes).equal(0);
+    // Reused by the same size class
+    void *buffer = [pool allocateBufferWithLength:100 * 1024];
+    [pool recycleBuffer:buffer length:100 * 1024];
+    expect(pool.pooledBytes).equal(104 * 1024);
+    void *reusedBuffer = [pool allocateBufferWithLength:103 * 1024];
+    expect(reusedBuffer == buffer).beTruthy();
+    expect(pool.pooledBytes).equal(0);
+    [pool recycleBuffer:reusedBuffer length:103 * 1024];
+    // Returned when the image is freed
+    size_t width = 100, height = 200, bytesPerRow = width * 4, length = bytesPerRow * height;
+    void *imageBuffer = [pool allocateBufferWithLength:length];
+    CGDataProviderRef provider = [pool createDataProviderWithBuffer:imageBuffer length:length];
+    CGImageRef imageRef = CGImageCreate(width, height, 8, 32, bytesPerRow, [SDImageCoderHelper colorSpaceGetDeviceRGB], kCGBitmapByteOrder32Host | kCGImageAlphaPremultipliedFirst, provider, NULL, false, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+    expect(imageRef != NULL).beTruthy();
+    expect(pool.pooledBytes).equal(104 * 1024);
+    CGImageRelease(imageRef);
+    expect(pool.pooledBytes).equal((104 + 80) * 1024);
+    // Bounded by bytes
+    void *largeBuffer1 = [pool allocateBufferWithLength:450 * 1024];
+    void *largeBuffer2 = [pool allocateBufferWithLength:450 * 1024];
+    [pool recycleBuffer:largeBuffer1 length:450 * 1024];
+    [pool recycleBuffer:largeBuffer2 length:450 * 1024];
+    expect(pool.pooledBytes).equal((104 + 80 + 480) * 1024);
+    [pool removeAllBuffers];
+    expect(pool.pooledBytes).equal(0);
+    // The buffer larger than the limit is allocated with exact length, and never pooled even the limit raised later
+    size_t exactLength = 1100 * 1024;
+    void *exactBuffer = [pool allocateBufferWithLength:exactLength];
+    expect(malloc_size(exactBuffer)).beLessThan(1152 * 1024);
+    pool.maxBytes = 4 * 1024 * 1024;
+    [pool recycleBuffer:exactBuffer length:exactLength];
+    expect(pool.pooledBytes).equal(0);
+    
+    // The reused buffer does not leak the previous pixels into the decoded image
+    CGSize size = CGSizeMake(300, 300);
+    size_t garbageLength = size.width * 4 * size.height;
+    void *garbageBuffer = [SDImageBufferPool.sharedPool allocateBufferWithLength:garbageLength];
+    memset(garbageBuffer, 0xFF, garbageLength);
+    [SDImageBufferPool.sharedPool recycleBuffer:garbageBuffer length:garbageLength];
+    SDGraphicsImageRendererFormat *format = [[SDGraphicsImageRendererFormat alloc] init];
+    format.scale = 1;
+    format.opaque = NO;
+    SDGraphicsImageRenderer *renderer = [[SDGraphicsImageRenderer alloc] initWithSize:size format:format];
+    UIImage *transparentImage = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+        CGContextClearRect(context, CGRectMake(0, 0, size.width, size.height));
+    }];
+    CGImageRef decodedImageRef = [SDImageCoderHelper CGImageCreateDecoded:transparentImage.CGImage];
+    expect(decodedImageRef != NULL).beTruthy();
+#if SD_MAC
+    UIImage *decodedImage = [[UIImage alloc] initWithCGImage:decodedImageRef scale:1 orientation:kCGImagePropertyOrientationUp];
+#else
+    UIImage *decodedImage = [[UIImage alloc] initWithCGImage:decodedImageRef scale:1 orientation:UIImageOrientationUp];
+#endif
+    CGImageRelease(decodedImageRef);
+    CGFloat red, green, blue, alpha;
+    [[decodedImage sd_colorAtPoint:CGPointMake(150, 150)] getRed:&red green:&green blue:&blue alpha:&alpha];
+    expect(alpha).equal(0);
+}
+
 #pragma mark - Helper
 
 - (NSString *)testJPEGPath {
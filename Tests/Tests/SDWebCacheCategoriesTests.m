@@ -666,6 +666,48 @@
     
 }
 
+- (void)testUIViewAutomaticThumbnailPixelSize {
+    // Bucketed size
+    expect(SDBucketedThumbnailPixelSize(CGSizeMake(33, 50))).equal(CGSizeMake(48, 64));
+    expect(SDBucketedThumbnailPixelSize(CGSizeMake(240, 240))).equal(CGSizeMake(256, 256));
+    expect(SDBucketedThumbnailPixelSize(CGSizeZero)).equal(CGSizeZero);
+    
+    UIImageView *imageView = [[UIImageView alloc] initWithFrame:CGRectMake(0, 0, 80, 40)];
+    // Not laid out
+    expect([[UIImageView alloc] init].sd_automaticThumbnailPixelSize).equal(CGSizeZero);
+#if SD_UIKIT
+    imageView.contentMode = UIViewContentModeCenter;
+    expect(imageView.sd_automaticThumbnailPixelSize).equal(CGSizeZero);
+    imageView.contentMode = UIViewContentModeScaleAspectFill;
+#else
+    imageView.imageScaling = NSImageScaleAxesIndependently;
+#endif
+    // Fill use the square of longer side
+    CGSize thumbnailPixelSize = imageView.sd_automaticThumbnailPixelSize;
+    expect(thumbnailPixelSize.width).beGreaterThanOrEqualTo(80);
+    expect(thumbnailPixelSize.height).equal(thumbnailPixelSize.width);
+    expect(SDBucketedThumbnailPixelSize(thumbnailPixelSize)).equal(thumbnailPixelSize);
+    
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Automatic thumbnail pixel size decode"];
+    NSURL *url = [NSURL fileURLWithPath:[[NSBundle bundleForClass:[self class]] pathForResource:@"TestImageLarge" ofType:@"jpg"]];
+    SDImageCache *cache = [[SDImageCache alloc] initWithNamespace:@"AutomaticThumbnail"];
+    SDWebImageManager *imageManager = [[SDWebImageManager alloc] initWithCache:cache loader:[SDWebImageDownloader sharedDownloader]];
+    [imageView sd_setImageWithURL:url placeholderImage:nil options:SDWebImageAutomaticThumbnailPixelSize | SDWebImageFromLoaderOnly context:@{SDWebImageContextCustomManager : imageManager} progress:nil completed:^(UIImage * _Nullable image, NSError * _Nullable error, SDImageCacheType cacheType, NSURL * _Nullable imageURL) {
+        expect(image).notTo.beNil();
+        expect(image.sd_isThumbnail).beTruthy();
+        CGSize pixelSize = CGSizeMake(image.size.width * image.scale, image.size.height * image.scale);
+        expect(MAX(pixelSize.width, pixelSize.height)).beLessThanOrEqualTo(thumbnailPixelSize.width);
+        // Benchmark: full size decode is 5250x3450 RGBA
+        NSUInteger fullCost = 5250 * 3450 * 4;
+        NSUInteger thumbnailCost = image.sd_memoryCost;
+        expect(thumbnailCost).beLessThan(fullCost);
+        NSLog(@"Automatic thumbnail %.0fx%.0f decode cost %lu bytes, full size decode cost %lu bytes, saved %.1f%%", thumbnailPixelSize.width, thumbnailPixelSize.height, (unsigned long)thumbnailCost, (unsigned long)fullCost, (1 - (double)thumbnailCost / fullCost) * 100);
+        [expectation fulfill];
+    }];
+    [self waitForExpectationsWithCommonTimeout];
+    [cache clearDiskOnCompletion:nil];
+}
+
 #pragma mark - Helper
 
 - (NSString *)testJPEGPath {
@@ -856,7 +856,190 @@
     [self waitForExpectations:expectations timeout:kAsyncTestTimeout * 2];
 }
 
+- (void)test32ThatConcurrencyControllerConvergesOnThrottledLink {
+    // Simulate a throttled link: 1MB/s shared by all running tasks, and requests begin to queue up (TTFB grows) beyond 4 concurrent downloads
+    SDWebImageDownloaderConcurrencyController *controller = [[SDWebImageDownloaderConcurrencyController alloc] initWithMinConcurrentDownloads:2 maxConcurrentDownloads:16];
+    NSInteger concurrentDownloads = 6;
+    NSInteger maxObserved = 0;
+    for (int i = 0; i < 400; i++) {
+        double throughput = 1024 * 1024 / (double)concurrentDownloads;
+        NSTimeInterval timeToFirstByte = 0.05 * (1 + MAX(concurrentDownloads - 4, 0));
+        concurrentDownloads = [controller concurrentDownloadsWithTimeToFirstByte:timeToFirstByte throughput:throughput currentConcurrentDownloads:concurrentDownloads];
+        expect(concurrentDownloads).beGreaterThanOrEqualTo(2);
+        expect(concurrentDownloads).beLessThanOrEqualTo(16);
+        if (i > 200) {
+            maxObserved = MAX(maxObserved, concurrentDownloads);
+        }
+    }
+    // AIMD oscillates around the knee, but never run away to the upper bound
+    expect(maxObserved).beLessThanOrEqualTo(6);
+
+    // Fast link: TTFB never grows, so it should probe up to the upper bound
+    [controller reset];
+    concurrentDownloads = 6;
+    for (int i = 0; i < 100; i++) {
+        concurrentDownloads = [controller concurrentDownloadsWithTimeToFirstByte:0.02 throughput:10 * 1024 * 1024 / (double)concurrentDownloads currentConcurrentDownloads:concurrentDownloads];
+    }
+    expect(concurrentDownloads).equal(16);
+}
+
+- (void)test33ThatConcurrencyControllerAdjustsDownloadQueue {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Concurrency controller adjusts download queue"];
+    SDWebImageDownloaderConfig *config = [[SDWebImageDownloaderConfig alloc] init];
+    config.maxConcurrentDownloads = 10;
+    SDWebImageDownloaderConcurrencyController *controller = [[SDWebImageDownloaderConcurrencyController alloc] initWithMinConcurrentDownloads:3 maxConcurrentDownloads:8];
+    controller.sampleWindow = 1;
+    config.concurrencyController = controller;
+    SDWebImageDownloader *downloader = [[SDWebImageDownloader alloc] initWithConfig:config];
+    expect(downloader.config.concurrencyController).equal(controller);
+
+    NSURL *imageURL = [NSURL URLWithString:kTestJPEGURL];
+    [downloader downloadImageWithURL:imageURL options:0 progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(image).notTo.beNil();
+        // Metrics are delivered before completion, the first sample clamp the concurrency into the controller's bounds
+        NSInteger adaptiveConcurrentDownloads = [[downloader valueForKey:@"adaptiveConcurrentDownloads"] integerValue]; // Access the internal property, only for test and may be changed in the future
+        expect(adaptiveConcurrentDownloads).beGreaterThanOrEqualTo(3);
+        expect(adaptiveConcurrentDownloads).beLessThanOrEqualTo(8);
+        expect(downloader.downloadQueue.maxConcurrentOperationCount).equal(adaptiveConcurrentDownloads);
+        // The config is not written by the controller, and still caps the concurrency
+        expect(downloader.config.maxConcurrentDownloads).equal(10);
+        downloader.config.maxConcurrentDownloads = 2;
+        expect(downloader.downloadQueue.maxConcurrentOperationCount).equal(2);
+        downloader.config.maxConcurrentDownloads = 10;
+        expect(downloader.downloadQueue.maxConcurrentOperationCount).equal(adaptiveConcurrentDownloads);
+        [expectation fulfill];
+    }];
+
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        [downloader invalidateSessionAndCancel:YES];
+    }];
+}
+
+- (void)test34ThatDownloadsAreCoalescedByCoalescingKey {
+    XCTestExpectation *expectation1 = [self expectationWithDescription:@"Coalesced download 1"];
+    XCTestExpectation *expectation2 = [self expectationWithDescription:@"Coalesced download 2"];
+    XCTestExpectation *expectation3 = [self expectationWithDescription:@"Cancelled coalesced download"];
+    XCTestExpectation *expectation4 = [self expectationWithDescription:@"Plain download of the URL equal to coalescing key"];
+    SDWebImageDownloader *downloader = [[SDWebImageDownloader alloc] init];
+    
+    // URL variants mapped to the same key share one operation
+    NSURL *imageURL1 = [NSURL URLWithString:[kTestJPEGURL stringByAppendingString:@"?token=1"]];
+    NSURL *imageURL2 = [NSURL URLWithString:[kTestJPEGURL stringByAppendingString:@"?token=2"]];
+    NSURL *imageURL3 = [NSURL URLWithString:[kTestJPEGURL stringByAppendingString:@"?token=3"]];
+    SDWebImageContext *context = @{SDWebImageContextDownloadCoalescingKey : kTestJPEGURL};
+    SDWebImageDownloadToken *token1 = [downloader downloadImageWithURL:imageURL1 options:0 context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(image).notTo.beNil();
+        [expectation1 fulfill];
+    }];
+    SDWebImageDownloadToken *token2 = [downloader downloadImageWithURL:imageURL2 options:0 context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(image).notTo.beNil();
+        [expectation2 fulfill];
+    }];
+    SDWebImageDownloadToken *token3 = [downloader downloadImageWithURL:imageURL3 options:0 context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(error.code).equal(SDWebImageErrorCancelled);
+        [expectation3 fulfill];
+    }];
+    expect(token2.downloadOperation).equal(token1.downloadOperation);
+    expect(token3.downloadOperation).equal(token1.downloadOperation);
+    expect(token2.url).equal(imageURL2);
+    // The request without coalescing key is keyed by URL string, which is the same key type
+    SDWebImageDownloadToken *token4 = [downloader downloadImageWithURL:[NSURL URLWithString:kTestJPEGURL] completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(image).notTo.beNil();
+        [expectation4 fulfill];
+    }];
+    expect(token4.downloadOperation).equal(token1.downloadOperation);
+    expect(downloader.currentDownloadCount).equal(1);
+    // Cancel one token does not cancel the shared operation
+    [token3 cancel];
+    expect(token1.downloadOperation.isCancelled).beFalsy();
+    
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        [downloader invalidateSessionAndCancel:YES];
+    }];
+}
+
 #pragma mark - SDWebImageLoader
+- (void)test35ThatConditionalRequestWithCacheValidatorsWorks {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Conditional request with cache validators responds 304"];
+    SDWebImageDownloader *downloader = [[SDWebImageDownloader alloc] init];
+    
+    UIImage *cachedImage = [[UIImage alloc] initWithContentsOfFile:[self testPNGPath]];
+    cachedImage.sd_cacheValidators = @{@"ETag" : @"\"abc\"", @"Last-Modified" : @"Wed, 21 Oct 2015 07:28:00 GMT"};
+    __block NSURLRequest *sentRequest;
+    SDWebImageDownloaderRequestModifier *requestModifier = [SDWebImageDownloaderRequestModifier requestModifierWithBlock:^NSURLRequest * _Nullable(NSURLRequest * _Nonnull request) {
+        sentRequest = request;
+        return request;
+    }];
+    // Stub the server response as 304 with the updated validator
+    SDWebImageDownloaderResponseModifier *responseModifier = [SDWebImageDownloaderResponseModifier responseModifierWithBlock:^NSURLResponse * _Nullable(NSURLResponse * _Nonnull response) {
+        return [[NSHTTPURLResponse alloc] initWithURL:response.URL statusCode:304 HTTPVersion:@"HTTP/1.1" headerFields:@{@"ETag" : @"\"def\""}];
+    }];
+    SDWebImageContext *context = @{SDWebImageContextLoaderCachedImage : cachedImage,
+                                   SDWebImageContextDownloadRequestModifier : requestModifier,
+                                   SDWebImageContextDownloadResponseModifier : responseModifier};
+    [downloader downloadImageWithURL:[NSURL URLWithString:kTestJPEGURL] options:0 context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect([sentRequest valueForHTTPHeaderField:@"If-None-Match"]).equal(@"\"abc\"");
+        expect([sentRequest valueForHTTPHeaderField:@"If-Modified-Since"]).equal(@"Wed, 21 Oct 2015 07:28:00 GMT");
+        expect(sentRequest.cachePolicy).equal(NSURLRequestReloadIgnoringLocalCacheData);
+        expect(image).beNil();
+        expect(error.domain).equal(SDWebImageErrorDomain);
+        expect(error.code).equal(SDWebImageErrorCacheNotModified);
+        expect(error.userInfo[SDWebImageErrorDownloadStatusCodeKey]).equal(304);
+        NSURLResponse *response = error.userInfo[SDWebImageErrorDownloadResponseKey];
+        expect(SDImageLoaderGetCacheValidators(response)).equal(@{@"ETag" : @"\"def\""});
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        [downloader invalidateSessionAndCancel:YES];
+    }];
+}
+
+- (void)test36ThatPlainRequestDoesNotShareConditionalRequest {
+    XCTestExpectation *expectation1 = [self expectationWithDescription:@"Conditional request 1 responds 304"];
+    XCTestExpectation *expectation2 = [self expectationWithDescription:@"Conditional request 2 responds 304"];
+    XCTestExpectation *expectation3 = [self expectationWithDescription:@"Plain request gets the image"];
+    XCTestExpectation *expectation4 = [self expectationWithDescription:@"Conditional request sharing the plain request gets the image"];
+    SDWebImageDownloader *downloader = [[SDWebImageDownloader alloc] init];
+    NSURL *imageURL = [NSURL URLWithString:kTestJPEGURL];
+    
+    UIImage *cachedImage = [[UIImage alloc] initWithContentsOfFile:[self testPNGPath]];
+    cachedImage.sd_cacheValidators = @{@"ETag" : @"\"abc\""};
+    // Stub the server response of the conditional request as 304
+    SDWebImageDownloaderResponseModifier *responseModifier = [SDWebImageDownloaderResponseModifier responseModifierWithBlock:^NSURLResponse * _Nullable(NSURLResponse * _Nonnull response) {
+        return [[NSHTTPURLResponse alloc] initWithURL:response.URL statusCode:304 HTTPVersion:@"HTTP/1.1" headerFields:nil];
+    }];
+    SDWebImageContext *conditionalContext = @{SDWebImageContextLoaderCachedImage : cachedImage,
+                                              SDWebImageContextDownloadResponseModifier : responseModifier};
+    SDWebImageDownloadToken *token1 = [downloader downloadImageWithURL:imageURL options:0 context:conditionalContext progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(error.code).equal(SDWebImageErrorCacheNotModified);
+        [expectation1 fulfill];
+    }];
+    SDWebImageDownloadToken *token2 = [downloader downloadImageWithURL:imageURL options:0 context:conditionalContext progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(error.code).equal(SDWebImageErrorCacheNotModified);
+        [expectation2 fulfill];
+    }];
+    expect(token2.downloadOperation).equal(token1.downloadOperation);
+    // The plain request does not receive the revalidation result
+    SDWebImageDownloadToken *token3 = [downloader downloadImageWithURL:imageURL completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(error).beNil();
+        expect(image).notTo.beNil();
+        [expectation3 fulfill];
+    }];
+    expect(token3.downloadOperation).notTo.equal(token1.downloadOperation);
+    // The conditional request can share the plain request
+    SDWebImageDownloadToken *token4 = [downloader downloadImageWithURL:imageURL options:0 context:@{SDWebImageContextLoaderCachedImage : cachedImage} progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, BOOL finished) {
+        expect(error).beNil();
+        expect(image).notTo.beNil();
+        [expectation4 fulfill];
+    }];
+    expect(token4.downloadOperation).equal(token3.downloadOperation);
+    
+    [self waitForExpectationsWithCommonTimeoutUsingHandler:^(NSError * _Nullable error) {
+        [downloader invalidateSessionAndCancel:YES];
+    }];
+}
+
 - (void)testCustomImageLoaderWorks {
     XCTestExpectation *expectation = [self expectationWithDescription:@"Custom image not works"];
     SDWebImageTestLoader *loader = [[SDWebImageTestLoader alloc] init];
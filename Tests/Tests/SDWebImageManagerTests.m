@@ -663,6 +663,299 @@
     [self waitForExpectationsWithCommonTimeout];
 }
 
+- (void)test23ThatFailedURLTableBackoffAndEviction {
+    SDWebImageFailedURLTable *table = [[SDWebImageFailedURLTable alloc] init];
+    table.baseRetryInterval = 10;
+    table.maxRetryInterval = 25;
+    table.jitterRatio = 0;
+    table.countLimit = 2;
+    NSURL *url1 = [NSURL URLWithString:@"https://example.com/1.png"];
+    NSURL *url2 = [NSURL URLWithString:@"https://example.com/2.png"];
+    NSURL *url3 = [NSURL URLWithString:@"https://example.com/3.png"];
+    expect([table isBlockedURL:url1]).beFalsy();
+    
+    // Exponential backoff, capped by max interval
+    [table recordFailureForURL:url1];
+    expect([table isBlockedURL:url1]).beTruthy();
+    expect([[table retryDateForURL:url1] timeIntervalSinceNow]).beCloseToWithin(10, 1);
+    [table recordFailureForURL:url1];
+    expect([[table retryDateForURL:url1] timeIntervalSinceNow]).beCloseToWithin(20, 1);
+    [table recordFailureForURL:url1];
+    expect([[table retryDateForURL:url1] timeIntervalSinceNow]).beCloseToWithin(25, 1);
+    expect([table failureCountForURL:url1]).equal(3);
+    
+    // Jitter only shorten the interval
+    table.jitterRatio = 1;
+    [table recordFailureForURL:url2];
+    expect([[table retryDateForURL:url2] timeIntervalSinceNow]).beLessThanOrEqualTo(10);
+    
+    // LRU eviction, url1 is the least recently failed
+    [table recordFailureForURL:url3];
+    expect(table.count).equal(2);
+    expect([table failureCountForURL:url1]).equal(0);
+    expect([table isBlockedURL:url1]).beFalsy();
+    
+    // Success remove the URL
+    [table removeURL:url3];
+    expect([table retryDateForURL:url3]).beNil();
+    
+    // Block forever
+    table.maxRetryInterval = -1;
+    [table recordFailureForURL:url1];
+    expect([table retryDateForURL:url1]).equal([NSDate distantFuture]);
+    [table removeAllURLs];
+    expect(table.count).equal(0);
+}
+
+- (void)test24ThatFailedURLTablePersists {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Failed URL table persists"];
+    NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"SDWebImageFailedURLTable.plist"];
+    [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+    SDWebImageFailedURLTable *table = [[SDWebImageFailedURLTable alloc] initWithPath:path];
+    NSURL *url = [NSURL URLWithString:@"https://example.com/1.png"];
+    [table recordFailureForURL:url];
+    [table recordFailureForURL:url];
+    // Written asynchronously after changes coalesced
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(2 * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        SDWebImageFailedURLTable *newTable = [[SDWebImageFailedURLTable alloc] initWithPath:path];
+        expect([newTable failureCountForURL:url]).equal(2);
+        expect([newTable isBlockedURL:url]).beTruthy();
+        [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+        [expectation fulfill];
+    });
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test25ThatThumbnailLoadingCanDownscaleFromLargerVariant {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Thumbnail for loading should downscale from the larger cached variant when thumbnail cache miss"];
+    
+    // Variant table lookup
+    SDImageThumbnailVariantTable *table = [SDImageThumbnailVariantTable new];
+    [table addVariantWithPixelSize:CGSizeMake(400, 400) preserveAspectRatio:YES forKey:@"a"];
+    [table addVariantWithPixelSize:CGSizeMake(200, 200) preserveAspectRatio:YES forKey:@"a"];
+    [table addVariantWithPixelSize:CGSizeMake(300, 100) preserveAspectRatio:YES forKey:@"a"];
+    expect([table nearestVariantPixelSizeForKey:@"a" pixelSize:CGSizeMake(100, 100) preserveAspectRatio:YES]).equal(CGSizeMake(200, 200));
+    expect([table nearestVariantPixelSizeForKey:@"a" pixelSize:CGSizeMake(200, 200) preserveAspectRatio:YES]).equal(CGSizeMake(400, 400));
+    expect([table nearestVariantPixelSizeForKey:@"a" pixelSize:CGSizeMake(500, 500) preserveAspectRatio:YES]).equal(CGSizeZero);
+    expect([table nearestVariantPixelSizeForKey:@"a" pixelSize:CGSizeMake(100, 100) preserveAspectRatio:NO]).equal(CGSizeZero);
+    table.countLimit = 1;
+    [table addVariantWithPixelSize:CGSizeMake(400, 400) preserveAspectRatio:YES forKey:@"b"];
+    expect(table.count).equal(1);
+    expect([table variantPixelSizesForKey:@"a" preserveAspectRatio:YES].count).equal(0);
+    
+    // 200x200 variant in memory only, no full size image, and no network
+    SDGraphicsImageRendererFormat *format = [[SDGraphicsImageRendererFormat alloc] init];
+    format.scale = 1;
+    CGSize variantSize = CGSizeMake(200, 200);
+    SDGraphicsImageRenderer *renderer = [[SDGraphicsImageRenderer alloc] initWithSize:variantSize format:format];
+    UIImage *variantImage = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+        CGContextSetRGBFillColor(context, 1.0, 0.0, 0.0, 1.0);
+        CGContextFillRect(context, CGRectMake(0, 0, variantSize.width, variantSize.height));
+    }];
+    NSURL *url = [NSURL URLWithString:@"https://placehold.co/800x800.png"];
+    SDWebImageManager *manager = SDWebImageManager.sharedManager;
+    NSString *fullSizeKey = [manager cacheKeyForURL:url];
+    NSString *variantKey = SDThumbnailedKeyForKey(fullSizeKey, variantSize, YES);
+    CGSize thumbnailSize = CGSizeMake(100, 100);
+    NSString *thumbnailKey = SDThumbnailedKeyForKey(fullSizeKey, thumbnailSize, YES);
+    CGSize smallThumbnailSize = CGSizeMake(50, 50);
+    NSString *smallThumbnailKey = SDThumbnailedKeyForKey(fullSizeKey, smallThumbnailSize, YES);
+    for (NSString *key in @[fullSizeKey, variantKey, thumbnailKey, smallThumbnailKey]) {
+        [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+        [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+    }
+    [SDImageCache.sharedImageCache storeImageToMemory:variantImage forKey:variantKey];
+    [manager.thumbnailVariantTable addVariantWithPixelSize:variantSize preserveAspectRatio:YES forKey:fullSizeKey];
+    
+    SDWebImageOptions options = SDWebImageFromCacheOnly | SDWebImageWaitStoreCache;
+    [manager loadImageWithURL:url options:options context:@{SDWebImageContextImageThumbnailPixelSize : @(thumbnailSize)} progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, SDImageCacheType cacheType, BOOL finished, NSURL * _Nullable imageURL) {
+        expect(error).beNil();
+        expect(image.size).equal(thumbnailSize);
+        expect(image.sd_isThumbnail).beTruthy();
+        expect(cacheType).equal(SDImageCacheTypeMemory);
+        // Stored with the requested thumbnail key, and recorded as a new variant
+        expect([SDImageCache.sharedImageCache imageFromMemoryCacheForKey:thumbnailKey].size).equal(thumbnailSize);
+        expect([SDImageCache.sharedImageCache imageFromDiskCacheForKey:thumbnailKey].size).equal(thumbnailSize);
+        expect([manager.thumbnailVariantTable variantPixelSizesForKey:fullSizeKey preserveAspectRatio:YES].count).equal(2);
+        
+        // 100x100 variant in disk only, decode with subsampling
+        [SDImageCache.sharedImageCache removeImageFromMemoryForKey:variantKey];
+        [SDImageCache.sharedImageCache removeImageFromMemoryForKey:thumbnailKey];
+        [manager loadImageWithURL:url options:options context:@{SDWebImageContextImageThumbnailPixelSize : @(smallThumbnailSize)} progress:nil completed:^(UIImage * _Nullable image2, NSData * _Nullable data2, NSError * _Nullable error2, SDImageCacheType cacheType2, BOOL finished2, NSURL * _Nullable imageURL2) {
+            expect(error2).beNil();
+            expect(image2.size).equal(smallThumbnailSize);
+            expect(cacheType2).equal(SDImageCacheTypeDisk);
+            // The smaller one should not be written back into the variant key
+            expect([SDImageCache.sharedImageCache imageFromMemoryCacheForKey:thumbnailKey]).beNil();
+            expect([SDImageCache.sharedImageCache imageFromMemoryCacheForKey:smallThumbnailKey].size).equal(smallThumbnailSize);
+            
+            // Clean up
+            [manager.thumbnailVariantTable removeVariantsForKey:fullSizeKey];
+            for (NSString *key in @[fullSizeKey, variantKey, thumbnailKey, smallThumbnailKey]) {
+                [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+                [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+            }
+            [expectation fulfill];
+        }];
+    }];
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test26ThatTransformAnimatedImageFramesStoreTransformedAnimation {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Transform animated image frames should store the transformed animation into disk cache"];
+    NSString *testImagePath = [[NSBundle bundleForClass:[self class]] pathForResource:@"TestImage" ofType:@"gif"];
+    NSURL *url = [NSURL fileURLWithPath:testImagePath];
+    CGSize transformSize = CGSizeMake(20, 20);
+    id<SDImageTransformer> transformer = [SDImageResizingTransformer transformerWithSize:transformSize scaleMode:SDImageScaleModeFill];
+    SDImageCache *cache = [[SDImageCache alloc] initWithNamespace:@"TransformAnimatedImageFrames"];
+    SDWebImageManager *manager = [[SDWebImageManager alloc] initWithCache:cache loader:SDWebImageDownloader.sharedDownloader];
+    SDWebImageContext *context = @{SDWebImageContextImageTransformer : transformer, SDWebImageContextAnimatedImageClass : SDAnimatedImage.class};
+    NSString *transformedKey = [manager cacheKeyForURL:url context:context];
+    [cache removeImageFromDiskForKey:transformedKey];
+    [cache removeImageFromMemoryForKey:transformedKey];
+    
+    [manager loadImageWithURL:url options:SDWebImageTransformAnimatedImageFrames | SDWebImageWaitStoreCache context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, SDImageCacheType cacheType, BOOL finished, NSURL * _Nullable imageURL) {
+        expect(error).beNil();
+        expect(image).beKindOf(SDAnimatedImage.class);
+        expect(image.sd_isTransformed).beTruthy();
+        SDAnimatedImage *animatedImage = (SDAnimatedImage *)image;
+        expect(animatedImage.animatedImageFrameCount).equal(5);
+        expect(animatedImage.animatedImageFormat).equal(SDImageFormatGIF);
+        expect([animatedImage animatedImageFrameAtIndex:1].size).equal(transformSize);
+        
+        // The disk cache keep the transformed animation
+        NSData *transformedData = [cache diskImageDataForKey:transformedKey];
+        SDAnimatedImage *cachedImage = [SDAnimatedImage imageWithData:transformedData];
+        expect(cachedImage.animatedImageFrameCount).equal(5);
+        expect(cachedImage.size).equal(transformSize);
+        [cache clearDiskOnCompletion:nil];
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test27ThatRefreshCachedWithValidatorsRevalidateOn304 {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Refresh cached with validators should refresh the cache entry on 304"];
+    NSURL *url = [NSURL URLWithString:@"https://placehold.co/51x51.png"];
+    SDWebImageManager *manager = [[SDWebImageManager alloc] initWithCache:SDImageCache.sharedImageCache loader:[[SDWebImageDownloader alloc] init]];
+    NSString *key = [manager cacheKeyForURL:url];
+    UIImage *cachedImage = [[UIImage alloc] initWithContentsOfFile:[self testJPEGPath]];
+    cachedImage.sd_cacheValidators = @{@"ETag" : @"\"abc\""};
+    [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+    [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+    
+    __block NSURLRequest *sentRequest;
+    SDWebImageDownloaderRequestModifier *requestModifier = [SDWebImageDownloaderRequestModifier requestModifierWithBlock:^NSURLRequest * _Nullable(NSURLRequest * _Nonnull request) {
+        sentRequest = request;
+        return request;
+    }];
+    // Stub the server response as 304 with the updated validator
+    SDWebImageDownloaderResponseModifier *responseModifier = [SDWebImageDownloaderResponseModifier responseModifierWithBlock:^NSURLResponse * _Nullable(NSURLResponse * _Nonnull response) {
+        return [[NSHTTPURLResponse alloc] initWithURL:response.URL statusCode:304 HTTPVersion:@"HTTP/1.1" headerFields:@{@"ETag" : @"\"def\""}];
+    }];
+    SDWebImageContext *context = @{SDWebImageContextDownloadRequestModifier : requestModifier,
+                                   SDWebImageContextDownloadResponseModifier : responseModifier};
+    SDWebImageOptions options = SDWebImageRefreshCached | SDWebImageRefreshCachedWithValidators;
+    __block NSUInteger completionCount = 0;
+    [SDImageCache.sharedImageCache storeImage:cachedImage forKey:key completion:^{
+        [manager loadImageWithURL:url options:options context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, SDImageCacheType cacheType, BOOL finished, NSURL * _Nullable imageURL) {
+            // Only the cached image callback, the 304 does not call completion again
+            completionCount++;
+            expect(image).notTo.beNil();
+            expect(cacheType).notTo.equal(SDImageCacheTypeNone);
+        }];
+    }];
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(kMinDelayNanosecond * 5)), dispatch_get_main_queue(), ^{
+        expect(completionCount).equal(1);
+        expect([sentRequest valueForHTTPHeaderField:@"If-None-Match"]).equal(@"\"abc\"");
+        SDDiskCache *diskCache = (SDDiskCache *)SDImageCache.sharedImageCache.diskCache;
+        expect([diskCache cacheValidatorsForKey:key][@"ETag"]).equal(@"\"def\"");
+        [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+        [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+        [expectation fulfill];
+    });
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test28ThatThumbnailLoadingCanDownscaleFromMemoryOriginal {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Thumbnail for loading should downscale from the full size original in memory cache"];
+    SDGraphicsImageRendererFormat *format = [[SDGraphicsImageRendererFormat alloc] init];
+    format.scale = 1;
+    CGSize originalSize = CGSizeMake(400, 400);
+    SDGraphicsImageRenderer *renderer = [[SDGraphicsImageRenderer alloc] initWithSize:originalSize format:format];
+    UIImage *originalImage = [renderer imageWithActions:^(CGContextRef  _Nonnull context) {
+        CGContextSetRGBFillColor(context, 0.0, 1.0, 0.0, 1.0);
+        CGContextFillRect(context, CGRectMake(0, 0, originalSize.width, originalSize.height));
+    }];
+    NSURL *url = [NSURL URLWithString:@"https://placehold.co/400x400.png"];
+    SDWebImageManager *manager = SDWebImageManager.sharedManager;
+    NSString *fullSizeKey = [manager cacheKeyForURL:url];
+    CGSize thumbnailSize = CGSizeMake(100, 100);
+    NSString *thumbnailKey = SDThumbnailedKeyForKey(fullSizeKey, thumbnailSize, YES);
+    for (NSString *key in @[fullSizeKey, thumbnailKey]) {
+        [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+        [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+    }
+    // Full size original in memory only, no disk data and no network
+    [SDImageCache.sharedImageCache storeImageToMemory:originalImage forKey:fullSizeKey];
+    
+    SDWebImageOptions options = SDWebImageFromCacheOnly | SDWebImageWaitStoreCache;
+    [manager loadImageWithURL:url options:options context:@{SDWebImageContextImageThumbnailPixelSize : @(thumbnailSize)} progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, SDImageCacheType cacheType, BOOL finished, NSURL * _Nullable imageURL) {
+        expect(error).beNil();
+        expect(image.size).equal(thumbnailSize);
+        expect(image.sd_isThumbnail).beTruthy();
+        expect(cacheType).equal(SDImageCacheTypeMemory);
+        // The full size original is not replaced
+        expect([SDImageCache.sharedImageCache imageFromMemoryCacheForKey:fullSizeKey]).equal(originalImage);
+        expect([SDImageCache.sharedImageCache imageFromMemoryCacheForKey:thumbnailKey].size).equal(thumbnailSize);
+        
+        // Clean up
+        [manager.thumbnailVariantTable removeVariantsForKey:fullSizeKey];
+        for (NSString *key in @[fullSizeKey, thumbnailKey]) {
+            [SDImageCache.sharedImageCache removeImageFromMemoryForKey:key];
+            [SDImageCache.sharedImageCache removeImageFromDiskForKey:key];
+        }
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
+- (void)test29ThatTransformAnimatedImageFramesUseContextCoderOptions {
+    XCTestExpectation *expectation = [self expectationWithDescription:@"Transform animated image frames should encode with the encode options in context"];
+    NSString *testImagePath = [[NSBundle bundleForClass:[self class]] pathForResource:@"TestImage" ofType:@"gif"];
+    NSURL *url = [NSURL fileURLWithPath:testImagePath];
+    CGSize transformSize = CGSizeMake(20, 20);
+    CGSize encodeSize = CGSizeMake(10, 10);
+    id<SDImageTransformer> transformer = [SDImageResizingTransformer transformerWithSize:transformSize scaleMode:SDImageScaleModeFill];
+    SDImageCache *cache = [[SDImageCache alloc] initWithNamespace:@"TransformAnimatedImageFramesCoderOptions"];
+    SDWebImageManager *manager = [[SDWebImageManager alloc] initWithCache:cache loader:SDWebImageDownloader.sharedDownloader];
+    SDWebImageContext *context = @{SDWebImageContextImageTransformer : transformer,
+                                   SDWebImageContextAnimatedImageClass : SDAnimatedImage.class,
+                                   SDWebImageContextImageEncodeOptions : @{SDImageCoderEncodeMaxPixelSize : @(encodeSize)}};
+    NSString *transformedKey = [manager cacheKeyForURL:url context:context];
+    [cache removeImageFromDiskForKey:transformedKey];
+    [cache removeImageFromMemoryForKey:transformedKey];
+    
+    [manager loadImageWithURL:url options:SDWebImageTransformAnimatedImageFrames | SDWebImageWaitStoreCache context:context progress:nil completed:^(UIImage * _Nullable image, NSData * _Nullable data, NSError * _Nullable error, SDImageCacheType cacheType, BOOL finished, NSURL * _Nullable imageURL) {
+        expect(error).beNil();
+        expect(image).beKindOf(SDAnimatedImage.class);
+        // The returned image match the encoded data in disk cache
+        expect(image.size).equal(encodeSize);
+        NSData *transformedData = [cache diskImageDataForKey:transformedKey];
+        SDAnimatedImage *cachedImage = [SDAnimatedImage imageWithData:transformedData];
+        expect(cachedImage.animatedImageFrameCount).equal(5);
+        expect(cachedImage.size).equal(encodeSize);
+        [cache clearDiskOnCompletion:nil];
+        [expectation fulfill];
+    }];
+    
+    [self waitForExpectationsWithCommonTimeout];
+}
+
 - (NSString *)testJPEGPath {
     NSBundle *testBundle = [NSBundle bundleForClass:[self class]];
     return [testBundle pathForResource:@"TestImage" ofType:@"jpg"];